@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include "chafa.h"
+#include "auto_tune.h"
 class ChafaInfo
 {
 public:
@@ -15,12 +16,23 @@ public:
     gint width_cells, height_cells;
     gint width_of_a_cell_in_pixels, height_of_a_cell_in_pixels; /* Size of each character cell, in pixels */
     bool session_type_is_x11;
+    /**
+     * @brief Wrap image sequences in tmux passthrough,
+     * set by detect_terminal
+     */
+    bool tmux_passthrough;
 
     ChafaInfo(gint width_cells,
               gint height_cells,
               gint width_of_a_cell_in_pixels,
               gint height_of_a_cell_in_pixels,
-              bool session_type_is_x11);
+              bool session_type_is_x11,
+              const Auto_Tune_Settings &settings = default_auto_tune_settings);
+
+    /**
+     * @brief How convert_image reads the desktop's pixels
+     */
+    ChafaPixelType desktop_pixel_type() const;
 
     GString *convert_image(uint8_t *texture_pixels,
                            uint32_t texture_width,
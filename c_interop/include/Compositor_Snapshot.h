@@ -0,0 +1,126 @@
+#pragma once
+#include "Native_Texture.h"
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct Draw_Item
+{
+    Native_Texture_Ref texture;
+    int32_t x;
+    int32_t y;
+};
+
+/**
+ * @brief Everything needed to draw one frame of the desktop,
+ * published by the javascript thread at the end of a frame.
+ * Never changes after it is published, so render threads can
+ * read it without locks while the clients keep committing.
+ */
+class Compositor_Snapshot
+{
+public:
+    /**
+     * @brief Goes up by one every publish
+     */
+    uint64_t sequence = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    /**
+     * @brief Bottom first, already flattened and z sorted
+     */
+    std::vector<Draw_Item> draw_list;
+
+    /**
+     * @return a hash of what draws in the region (the version and
+     * position of every texture that overlaps it, in order), the
+     * same as long as composing the region gives the same pixels.
+     * 0 if nothing draws in it.
+     */
+    uint64_t region_signature(int64_t x, int64_t y, int64_t region_width, int64_t region_height) const;
+
+    /**
+     * @brief Draws one region of the desktop into BGRA premultiplied
+     * pixels. Anything nothing draws on is transparent black.
+     * @param out where the top left of the region goes
+     */
+    void compose_region(uint8_t *out,
+                        size_t out_stride,
+                        int64_t x,
+                        int64_t y,
+                        int64_t region_width,
+                        int64_t region_height) const;
+};
+
+/**
+ * @brief Publishes snapshots to any number of reader threads, RCU style.
+ *
+ * A reader pins the current epoch in its slot before loading the
+ * current snapshot. A replaced snapshot is retired with the epoch it
+ * was replaced in, and freed once every pinned slot is past that
+ * epoch. Readers never wait for the publisher, and the publisher
+ * never waits for readers.
+ *
+ * publish and reclaim are for the javascript thread only.
+ */
+class Snapshot_Publisher
+{
+public:
+    static constexpr size_t max_readers = 64;
+
+    ~Snapshot_Publisher();
+
+    void publish(Compositor_Snapshot *snapshot);
+
+    /**
+     * @brief Frees retired snapshots no reader can still see.
+     * Called by publish.
+     */
+    void reclaim();
+
+    uint64_t next_sequence() const;
+
+    class Reader
+    {
+    public:
+        /**
+         * @brief Claims a slot, check claimed()
+         */
+        Reader(Snapshot_Publisher &publisher);
+        ~Reader();
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        bool claimed() const;
+
+        /**
+         * @return the current snapshot (or nullptr if nothing has
+         * been published yet), valid until leave()
+         */
+        const Compositor_Snapshot *enter();
+        void leave();
+
+    private:
+        Snapshot_Publisher &publisher;
+        size_t slot_index;
+    };
+
+private:
+    /**
+     * @brief 0 means not reading, one cache line each so readers
+     * don't fight over them
+     */
+    struct alignas(64) Reader_Slot
+    {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> claimed{false};
+    };
+
+    std::atomic<const Compositor_Snapshot *> current{nullptr};
+    std::atomic<uint64_t> epoch{1};
+    Reader_Slot slots[max_readers];
+    std::vector<std::pair<uint64_t, const Compositor_Snapshot *>> retired;
+    uint64_t sequence = 0;
+};
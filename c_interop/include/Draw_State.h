@@ -1,6 +1,58 @@
 #pragma once
 #include "ChafaInfo.h"
 #include "TermSize.h"
+#include "auto_tune.h"
+#include "Output_Recorder.h"
+#include "Output_Profiler.h"
+#include "Tiled_Framebuffer.h"
+#include "Kitty_Placeholders.h"
+#include "Kitty_Windows.h"
+#include "Mosaic_Renderer.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The options object passed to init_draw_state
+ */
+struct Draw_State_Options
+{
+    /**
+     * @brief if > 0, pick the chafa settings that fit in this
+     * frame time on this terminal. Measures the link right away,
+     * so must be created before stdin is read by anything else.
+     */
+    double auto_tune_frame_time_seconds = 0;
+    /**
+     * @brief if not empty, record every frame here for scripts/vt-harness
+     */
+    std::string record_output_path;
+    /**
+     * @brief if not empty, sort the output bytes by what they are
+     * for and write a report here, see Output_Profiler
+     */
+    std::string profile_output_path;
+    /**
+     * @brief Threads for the shared thread pool, 0 for one per core
+     */
+    uint32_t threads = 0;
+    /**
+     * @brief On terminals that draw with kitty images, draw with
+     * Unicode placeholders instead, see Kitty_Placeholders
+     */
+    bool kitty_placeholders = false;
+    /**
+     * @brief On terminals that draw with kitty images, draw every
+     * surface as its own image, see Kitty_Windows
+     */
+    bool kitty_windows = false;
+    /**
+     * @brief When drawing with symbols, draw with this grid
+     * instead of chafa, see Mosaic_Renderer
+     */
+    std::optional<Mosaic_Grid> mosaic_grid;
+};
 
 class Draw_State
 {
@@ -8,11 +60,110 @@ public:
     bool session_type_is_x11;
     ChafaInfo *chafa_info = nullptr;
 
-    void resize_chafa_info_if_needed(gint width_cells,
+    /**
+     * @brief The symbol set and work factor every ChafaInfo is made with.
+     * Either the defaults, the cached result of an earlier auto tune,
+     * or the result of the auto tune on the first frame.
+     */
+    Auto_Tune_Settings settings = default_auto_tune_settings;
+    /**
+     * @brief 0 when auto tune is off
+     */
+    double auto_tune_frame_time_seconds;
+    bool needs_auto_tune = false;
+    /**
+     * @brief bytes per second, negative if it couldn't be measured
+     */
+    double link_drain_rate = -1;
+    std::string auto_tune_cache_key;
+    /**
+     * @brief Keys pressed while the link was measured,
+     * see take_auto_tune_input
+     */
+    std::string input_read_during_auto_tune;
+
+    Output_Recorder *output_recorder = nullptr;
+    Output_Profiler *output_profiler = nullptr;
+    /**
+     * @brief nullptr unless asked for, only used
+     * when the terminal draws kitty images
+     */
+    Kitty_Placeholders *kitty_placeholders = nullptr;
+    /**
+     * @brief nullptr unless asked for, only used when the terminal
+     * draws kitty images and kitty_placeholders is not
+     */
+    Kitty_Windows *kitty_windows = nullptr;
+    /**
+     * @brief nullptr unless asked for, only used when the
+     * terminal draws with symbols in colors it can do
+     */
+    Mosaic_Renderer *mosaic_renderer = nullptr;
+
+    /**
+     * @brief The desktop to draw, published by javascript every frame
+     */
+    Snapshot_Publisher snapshots;
+    /**
+     * @brief What the latest snapshot was composed into
+     */
+    Tiled_Framebuffer framebuffer;
+    /**
+     * @brief The whole desktop as one image for chafa, which only
+     * takes one contiguous image. The one full size buffer, only
+     * the tiles that changed are copied in each frame.
+     */
+    std::vector<uint8_t> desktop_pixels;
+
+    /**
+     * @brief Below 1, while the desktop is changing, kitty and iTerm2
+     * images are made at this fraction of the terminal's resolution
+     * and the terminal scales them up. See set_motion_scale.
+     */
+    double motion_scale = 1;
+    /**
+     * @brief chafa_info with smaller cells, nullptr until needed
+     */
+    ChafaInfo *motion_chafa_info = nullptr;
+    double last_desktop_change_time = 0;
+    /**
+     * @brief The desktop on screen is at motion_scale, and has
+     * to be drawn again at full resolution once it settles
+     */
+    bool drew_motion_frame = false;
+
+    /**
+     * @brief nullopt when the status line is hidden
+     */
+    std::optional<std::string> last_status_line;
+    double last_full_frame_time = 0;
+    /**
+     * @brief Only kept when recording, to write the
+     * reference of frames where the desktop didn't change
+     */
+    std::string last_printable;
+
+    /**
+     * @return true if it made a new ChafaInfo
+     */
+    bool resize_chafa_info_if_needed(gint width_cells,
                                      gint height_cells,
+                                     uint32_t image_width,
+                                     uint32_t image_height,
                                      TermSize &term_size);
 
 
-    Draw_State(bool session_type_is_x11);
+    /**
+     * @brief Rounded to eighths between 1/4 and 1, so an
+     * estimate that wobbles doesn't make a new ChafaInfo every time
+     */
+    void set_motion_scale(double scale);
+
+    /**
+     * @brief Only call after resize_chafa_info_if_needed
+     */
+    ChafaInfo *get_motion_chafa_info();
+
+    Draw_State(bool session_type_is_x11, const Draw_State_Options &options = {});
     ~Draw_State();
 };
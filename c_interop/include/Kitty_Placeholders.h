@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Draws the desktop with kitty's Unicode placeholders instead
+ * of one big image.
+ *
+ * The desktop is cut into tiles of cells, each its own kitty image
+ * with a virtual placement. The cells themselves are ordinary text:
+ * U+10EEEE with diacritics for the row and column in the tile, in
+ * a foreground color that is the image id. So the picture moves
+ * with the text (scrolling, tmux panes), and a frame where one
+ * tile changed only uploads that tile again, the terminal redraws
+ * every cell that refers to it.
+ *
+ * Needs the size of a cell in pixels, the tiles are scaled to fill
+ * their cells exactly.
+ */
+class Kitty_Placeholders
+{
+public:
+    /**
+     * @brief In cells. Small enough that a change only uploads
+     * a small part of the screen, big enough that the
+     * image headers don't add up.
+     */
+    static constexpr uint32_t tile_columns = 16;
+    static constexpr uint32_t tile_rows = 8;
+
+    Kitty_Placeholders();
+
+    /**
+     * @param pixels the whole desktop, width * 4 stride
+     * @param swap_red_and_blue true if pixels are BGRA, kitty wants RGBA
+     * @param first_row the terminal row (from 0) the desktop starts on
+     * @param redraw_text write the placeholder cells even if the
+     * layout didn't change, in case something wrote over them
+     * @return uploads of the tiles that changed, then the
+     * placeholder cells if they need to be written
+     */
+    std::string draw(const uint8_t *pixels,
+                     uint32_t width,
+                     uint32_t height,
+                     bool swap_red_and_blue,
+                     uint32_t width_cells,
+                     uint32_t height_cells,
+                     uint32_t cell_width,
+                     uint32_t cell_height,
+                     uint32_t first_row,
+                     bool redraw_text);
+
+    /**
+     * @brief Every placeholder cell of the current layout, what
+     * the screen looks like as text after a full repaint
+     */
+    std::string placeholder_text;
+
+private:
+    struct Tile
+    {
+        uint32_t column;
+        uint32_t row;
+        uint32_t columns;
+        uint32_t rows;
+        uint32_t image_id;
+        /**
+         * @brief What was uploaded last, RGBA
+         */
+        std::vector<uint8_t> pixels;
+        /**
+         * @brief Scratch, scaled into then compared to pixels
+         */
+        std::vector<uint8_t> scaled;
+        bool changed = false;
+        std::string upload;
+    };
+
+    uint32_t first_image_id;
+    std::vector<Tile> tiles;
+
+    uint32_t width_cells = 0;
+    uint32_t height_cells = 0;
+    uint32_t cell_width = 0;
+    uint32_t cell_height = 0;
+    uint32_t first_row = 0;
+
+    /**
+     * @return the sequences to delete the images of the old layout
+     */
+    std::string change_layout(uint32_t width_cells,
+                              uint32_t height_cells,
+                              uint32_t cell_width,
+                              uint32_t cell_height,
+                              uint32_t first_row);
+    void make_placeholder_text();
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include "Compositor_Snapshot.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Draws the desktop as one kitty image per surface, shown
+ * with placements that have a position and a z-index, instead of
+ * one image of the whole desktop.
+ *
+ * A surface is uploaded once per texture. Textures are copy on write
+ * and this holds a reference to every texture it uploaded, so a new
+ * texture is new content and the same texture is the same content.
+ * Moving, raising or lowering a window is a placement command of a
+ * few dozen bytes, nothing is uploaded again.
+ *
+ * Nothing is drawn where no surface is, the terminal's
+ * background shows through.
+ */
+class Kitty_Windows
+{
+public:
+    Kitty_Windows();
+
+    /**
+     * @param swap_red_and_blue true if textures are BGRA, kitty wants RGBA
+     * @param first_row the terminal row (from 0) the desktop starts on
+     * @param place_again send every placement even if it didn't
+     * move, in case something cleared the screen
+     * @return uploads, placements and deletes, empty if
+     * nothing changed since the last draw
+     */
+    std::string draw(const Compositor_Snapshot &snapshot,
+                     bool swap_red_and_blue,
+                     uint32_t width_cells,
+                     uint32_t height_cells,
+                     uint32_t cell_width,
+                     uint32_t cell_height,
+                     uint32_t first_row,
+                     bool place_again);
+
+private:
+    struct Placement
+    {
+        /**
+         * @brief Where in the desktop's cells, in terminal pixels
+         */
+        int64_t x;
+        int64_t y;
+        /**
+         * @brief The part of the image that is on the desktop
+         */
+        uint32_t source_x;
+        uint32_t source_y;
+        uint32_t source_width;
+        uint32_t source_height;
+        uint32_t z;
+
+        bool operator==(const Placement &other) const = default;
+    };
+
+    struct Window_Image
+    {
+        /**
+         * @brief Holding it keeps it from being written in
+         * place, and its address from being reused
+         */
+        Native_Texture_Ref texture;
+        uint32_t image_id;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool placed = false;
+        Placement placement;
+        bool in_snapshot = false;
+        std::string upload;
+    };
+
+    uint32_t first_image_id;
+    /**
+     * @brief Ids below this have been handed out, the
+     * ones deleted since are in free_image_ids
+     */
+    uint32_t next_image = 0;
+    std::vector<uint32_t> free_image_ids;
+    std::vector<Window_Image> images;
+
+    /**
+     * @return 0 if every id of this process is in use
+     */
+    uint32_t allocate_image_id();
+    /**
+     * @brief Sends the delete and frees the id
+     */
+    void delete_image(std::string &out, uint32_t image_id);
+
+    uint32_t desktop_width = 0;
+    uint32_t desktop_height = 0;
+    uint32_t width_cells = 0;
+    uint32_t height_cells = 0;
+    uint32_t cell_width = 0;
+    uint32_t cell_height = 0;
+    uint32_t first_row = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "chafa.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief How a cell is cut up, see --render-mode
+ */
+enum class Mosaic_Grid
+{
+    /**
+     * @brief 2x3, Unicode 13 sextants
+     */
+    sextant,
+    /**
+     * @brief 2x4, Unicode 16 octants
+     */
+    octant,
+    /**
+     * @brief 2x4 braille dots
+     */
+    braille,
+};
+
+/**
+ * @return false if name is not one of the grids
+ */
+bool mosaic_grid_from_name(const std::string &name, Mosaic_Grid *grid_out);
+
+/**
+ * @brief Draws the desktop with a fixed grid of block characters
+ * instead of chafa's symbol search.
+ *
+ * Every cell is 2 sub pixels wide and 3 or 4 high. The sub pixels
+ * are box averages of the desktop, split in two at the middle of
+ * the channel with the widest range, and the two halves are the
+ * foreground and background colors. With a fixed grid every split
+ * is exactly one character, so there is nothing to search, the
+ * split is the index into the table of characters. Much less work
+ * than chafa for about the same picture, but the terminal's font
+ * has to have the characters.
+ *
+ * Only draws with truecolor or the 256 color cube,
+ * see can_draw.
+ */
+class Mosaic_Renderer
+{
+public:
+    explicit Mosaic_Renderer(Mosaic_Grid grid);
+
+    static bool can_draw(ChafaCanvasMode mode);
+
+    /**
+     * @param pixels the whole desktop, width * 4 stride
+     * @param pixels_are_bgra false for RGBA
+     * @param first_row the terminal row (from 0) the desktop starts on
+     * @return every row of cells, each placed with a cursor
+     * move, so it doesn't matter where the cursor was
+     */
+    std::string draw(const uint8_t *pixels,
+                     uint32_t width,
+                     uint32_t height,
+                     bool pixels_are_bgra,
+                     ChafaCanvasMode mode,
+                     uint32_t width_cells,
+                     uint32_t height_cells,
+                     uint32_t first_row);
+
+private:
+    uint32_t sub_rows;
+    /**
+     * @brief UTF-8, indexed by the split: bit (row * 2 + column)
+     * is set if that sub pixel is in the foreground
+     */
+    std::array<std::string, 256> characters;
+    std::vector<std::string> rows;
+
+    void draw_row(const uint8_t *pixels,
+                  uint32_t width,
+                  uint32_t height,
+                  bool pixels_are_bgra,
+                  bool indexed,
+                  uint32_t width_cells,
+                  uint32_t height_cells,
+                  uint32_t row,
+                  std::string &out);
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include "SHM_Pool_Memory.h"
+#include <napi.h>
+#include <memory>
+
+/**
+ * @brief A wl_buffer's pixels: the pool mapping it was created
+ * in, and where in the mapping it is.
+ *
+ * Immutable, and handed around as a Native_Buffer_Ref
+ * (std::shared_ptr, so the reference count is atomic). Any thread
+ * holding a reference can read the pixels, the mapping stays
+ * alive until the last reference drops, even if the client
+ * resizes or destroys the pool in the meantime.
+ *
+ * The pixels are still the client's shared memory, the client
+ * can write to them at any time.
+ */
+class Native_Buffer
+{
+public:
+    Native_Buffer(std::shared_ptr<const SHM_Mapping> mapping,
+                  uint32_t offset,
+                  int32_t width,
+                  int32_t height,
+                  int32_t stride,
+                  uint32_t format);
+
+    const std::shared_ptr<const SHM_Mapping> mapping;
+    const uint32_t offset;
+    const int32_t width;
+    const int32_t height;
+    const int32_t stride;
+    /**
+     * @brief wl_shm_format
+     */
+    const uint32_t format;
+
+    const uint8_t *data() const;
+    size_t byte_length() const;
+
+    /**
+     * @brief Whether the buffer fits inside its mapping,
+     * check before reading from it.
+     */
+    bool valid() const;
+};
+
+typedef std::shared_ptr<const Native_Buffer> Native_Buffer_Ref;
+
+/**
+ * @brief The javascript handle owns one reference, released by
+ * release_shm_buffer or when the handle is garbage collected.
+ */
+Napi::Value native_buffer_to_js(Napi::Env env, Native_Buffer_Ref buffer);
+
+/**
+ * @return a new reference, or nullptr if the handle was released
+ */
+Native_Buffer_Ref native_buffer_from_js(const Napi::Value &value);
+
+void release_native_buffer_js_handle(const Napi::Value &value);
@@ -0,0 +1,69 @@
+#pragma once
+#include "Native_Buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Our own copy of a surface's pixels, in the layout we
+ * composite in: BGRA, premultiplied, stride of width * 4.
+ * (the same bytes a wl_shm argb8888 buffer has, and the same
+ * as cairo's "raw")
+ *
+ * Copy on write: once a texture is in a published
+ * Compositor_Snapshot it is never written again, the next
+ * commit copies into another texture instead, see
+ * Native_Texture_Handle.
+ */
+class Native_Texture
+{
+public:
+    Native_Texture(uint32_t width, uint32_t height);
+
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> pixels;
+    /**
+     * @brief Every alpha is 255, compositing can copy
+     * instead of blending
+     */
+    bool opaque = false;
+    /**
+     * @brief Different for every texture and every time
+     * its pixels change, never 0
+     */
+    uint64_t version;
+
+    /**
+     * @return false if the buffer can't be read or is not the
+     * same size as this texture
+     */
+    bool copy_from(const Native_Buffer &buffer);
+};
+
+typedef std::shared_ptr<const Native_Texture> Native_Texture_Ref;
+
+/**
+ * @brief What a surface's javascript handle holds, the only
+ * mutable references to its textures.
+ *
+ * The latest snapshot always holds texture, so a commit can't
+ * write into it. It goes into spare instead, which the snapshot
+ * before had, and is free again once that snapshot is reclaimed
+ * (and Kitty_Windows moved on from it). The two swap every
+ * commit, so a surface that keeps committing at the same size
+ * doesn't allocate.
+ */
+struct Native_Texture_Handle
+{
+    std::shared_ptr<Native_Texture> texture;
+    std::shared_ptr<Native_Texture> spare;
+};
+
+Napi::Value native_texture_to_js(Napi::Env env, std::shared_ptr<Native_Texture> texture);
+
+/**
+ * @return nullptr if the value is not a texture handle
+ */
+Native_Texture_Handle *native_texture_from_js(const Napi::Value &value);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+enum class Output_Category
+{
+    status_line,
+    /**
+     * @brief Printable text, what chafa draws with in symbol mode
+     */
+    glyph,
+    sgr,
+    cursor,
+    erase,
+    /**
+     * @brief Kitty, sixels and iTerm images, headers and base64
+     */
+    image,
+    /**
+     * @brief Newlines, carriage returns and the like
+     */
+    control,
+    other,
+};
+constexpr size_t output_category_count = 8;
+
+struct Output_Category_Stats
+{
+    uint64_t bytes = 0;
+    uint64_t sequences = 0;
+    /**
+     * @brief The most bytes of this category in one frame
+     */
+    uint64_t max_bytes_in_a_frame = 0;
+};
+
+/**
+ * @brief Sorts every byte written to the terminal into what it
+ * is for, to know which output optimization is worth doing.
+ *
+ * Each frame is one line of <path>.frames.csv as it happens,
+ * the totals for the session are written to <path> by write_report.
+ */
+class Output_Profiler
+{
+public:
+    Output_Profiler(const std::string &path);
+    ~Output_Profiler();
+
+    /**
+     * @param status_line_bytes how many bytes at the start
+     * of output are the status line
+     */
+    void profile_frame(const std::string &output, size_t status_line_bytes);
+
+    void write_report();
+
+private:
+    std::string path;
+    FILE *frames_file;
+    uint64_t frames = 0;
+    std::array<Output_Category_Stats, output_category_count> totals;
+
+    void classify(const char *data,
+                  size_t length,
+                  std::array<Output_Category_Stats, output_category_count> &frame);
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * @brief Records every frame we write to the terminal, for
+ * scripts/vt-harness to replay.
+ *
+ * The file is a list of records: a one byte tag, a uint32
+ * (little endian) length, then that many bytes.
+ *   'S' terminal size, two uint32s: columns, rows
+ *   'R' reference, a full repaint of the frame from the top left
+ *   'E' emitted, the bytes that were actually written
+ * Each frame is S, R, E in that order.
+ */
+class Output_Recorder
+{
+public:
+    Output_Recorder(const std::string &path);
+    ~Output_Recorder();
+
+    void record_frame(uint32_t columns,
+                      uint32_t rows,
+                      const std::string &reference,
+                      const std::string &emitted);
+
+private:
+    FILE *file;
+    void write_record(char tag, const char *data, uint32_t length);
+};
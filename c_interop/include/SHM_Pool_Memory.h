@@ -1,19 +1,41 @@
 #pragma once
 #include <stdint.h>
 #include <cstddef>
+#include <memory>
 typedef uint32_t Object_ID_wl_shm_pool_t;
 
+/**
+ * @brief One mmap of a pool. Unmapped when the last reference
+ * drops, so a buffer keeps the memory it was created in alive
+ * after the pool is resized or destroyed.
+ */
+class SHM_Mapping
+{
+public:
+    SHM_Mapping(int fd, size_t size);
+    void *addr;
+    size_t size;
+
+    bool failed() const;
+
+    ~SHM_Mapping();
+};
+
 class SHM_Pool_Memory
 {
 public:
     SHM_Pool_Memory(int fd, size_t size);
     int file_descriptor;
-    void *addr;
-    size_t size;
+    /**
+     * @brief Only swapped on the javascript thread,
+     * other threads hold their own references through
+     * Native_Buffer.
+     */
+    std::shared_ptr<const SHM_Mapping> mapping;
 
     bool destroyed();
 
     bool remap(size_t new_size);
 
     ~SHM_Pool_Memory();
-};
\ No newline at end of file
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock::time_point Deadline;
+constexpr Deadline no_deadline = Deadline::max();
+
+enum class Task_Priority
+{
+    /**
+     * @brief Work the current frame is waiting for
+     */
+    frame = 0,
+    /**
+     * @brief Recording, caches, anything that can
+     * wait until the frame work is done
+     */
+    background = 1,
+};
+constexpr size_t task_priority_count = 2;
+
+/**
+ * @brief Counts the tasks in flight for something that
+ * has to wait for all of them, like all the bands of a frame.
+ * Thread safe, but wait only from one thread.
+ */
+class Task_Group
+{
+public:
+    /**
+     * @brief Tasks of this group that haven't started
+     * by the deadline are skipped, see expired()
+     */
+    Deadline deadline = no_deadline;
+
+    /**
+     * @return how many tasks were skipped for missing the deadline
+     */
+    uint32_t expired() const;
+
+private:
+    friend class Thread_Pool;
+    std::atomic<uint32_t> pending{0};
+    std::atomic<uint32_t> expired_count{0};
+};
+
+struct Thread_Pool_Stats
+{
+    uint32_t threads;
+    uint64_t tasks_run;
+    uint64_t tasks_stolen;
+    uint64_t tasks_expired;
+    /**
+     * @brief Tasks run by a thread waiting on its group,
+     * instead of by a worker
+     */
+    uint64_t tasks_run_while_waiting;
+    uint32_t queued;
+    /**
+     * @brief busy time over thread time, 0 to 1,
+     * since the last call to stats
+     */
+    double utilization;
+};
+
+/**
+ * @brief One pool for every parallel stage in c_interop, so they
+ * share the cores instead of each bringing their own threads.
+ *
+ * Each worker has its own queue per priority. A worker takes its
+ * own newest task first (still in cache), and when it runs out
+ * steals the oldest task from another worker. Frame tasks always
+ * go before background tasks.
+ *
+ * Never block a task on something other than a Task_Group,
+ * waiting on a group runs queued tasks, and only sleeps once
+ * the rest of its tasks are running on other threads.
+ */
+class Thread_Pool
+{
+public:
+    /**
+     * @param drawing_threads 0 means one per core. Counts the thread that
+     * calls parallel_for, which runs ranges too, so one fewer
+     * workers are started.
+     */
+    Thread_Pool(uint32_t drawing_threads);
+    ~Thread_Pool();
+
+    void submit(Task_Group &group,
+                std::function<void()> task,
+                Task_Priority priority = Task_Priority::frame);
+
+    /**
+     * @brief Not tied to a group, nobody waits on these
+     */
+    void submit_detached(std::function<void()> task,
+                         Task_Priority priority = Task_Priority::background,
+                         Deadline deadline = no_deadline);
+
+    /**
+     * @brief Runs queued tasks until every task of the group is done
+     */
+    void wait(Task_Group &group);
+
+    /**
+     * @brief Splits [0, count) into about one range per thread and waits
+     * for them all. The calling thread runs ranges too.
+     * @return false if a range was skipped for missing the deadline
+     */
+    bool parallel_for(size_t count,
+                      const std::function<void(size_t begin, size_t end)> &body,
+                      size_t min_per_task = 1,
+                      Deadline deadline = no_deadline);
+
+    /**
+     * @return the workers, not counting the thread that waits
+     */
+    uint32_t thread_count() const;
+
+    Thread_Pool_Stats stats();
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        Task_Group *group;
+        Deadline deadline;
+    };
+
+    struct alignas(64) Worker_Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks[task_priority_count];
+    };
+
+    std::vector<std::unique_ptr<Worker_Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake_up;
+    std::atomic<uint32_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint32_t> next_queue{0};
+
+    std::atomic<uint64_t> tasks_run{0};
+    std::atomic<uint64_t> tasks_stolen{0};
+    std::atomic<uint64_t> tasks_expired{0};
+    std::atomic<uint64_t> tasks_run_while_waiting{0};
+    std::atomic<uint64_t> busy_nanoseconds{0};
+    std::chrono::steady_clock::time_point last_stats_time;
+    uint64_t last_stats_busy_nanoseconds = 0;
+
+    void push(Task task, Task_Priority priority);
+    bool take(size_t home_queue, Task *task_out);
+    void run(Task &task);
+    void worker_loop(size_t index);
+};
+
+/**
+ * @brief Sets the number of threads the shared pool draws with,
+ * only has an effect before the first call to thread_pool()
+ * @param threads 0 means one per core, see Thread_Pool().
+ * At most 4 per core.
+ */
+void configure_thread_pool(uint32_t threads);
+
+/**
+ * @brief The pool shared by all of c_interop, started on first use
+ */
+Thread_Pool &thread_pool();
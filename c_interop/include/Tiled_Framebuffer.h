@@ -0,0 +1,67 @@
+#pragma once
+#include "Compositor_Snapshot.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The composited desktop, as tiles that only have memory
+ * when something is drawn on them. A tile without pixels is
+ * background (transparent black), so a big virtual monitor with
+ * one small window costs about as much as the window.
+ *
+ * A tile is only composed again when what draws on it changed
+ * (see Compositor_Snapshot::region_signature), so composing follows
+ * the damage, not the drawn area. A composed tile is hashed, and a
+ * tile whose hash didn't change is not copied anywhere.
+ */
+class Tiled_Framebuffer
+{
+public:
+    static constexpr uint32_t tile_size = 64;
+
+    struct Tile
+    {
+        /**
+         * @brief nullptr for background
+         */
+        std::unique_ptr<uint8_t[]> pixels;
+        uint64_t hash = 0;
+        /**
+         * @brief region_signature when it was last composed
+         */
+        uint64_t signature = 0;
+        /**
+         * @brief Different from the last compose
+         */
+        bool changed = true;
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tiles_x = 0;
+    uint32_t tiles_y = 0;
+    std::vector<Tile> tiles;
+
+    /**
+     * @brief Composes the tiles of the snapshot whose signature changed
+     * on the thread pool, resizing first if the desktop changed size.
+     * @return how many tiles changed
+     */
+    size_t compose(const Compositor_Snapshot &snapshot);
+
+    /**
+     * @brief Copies the tiles that changed into a whole image
+     * that already has the rest of the last frame.
+     * @param out width * height * 4 bytes
+     */
+    void copy_changed_to(uint8_t *out) const;
+
+    size_t allocated_tiles() const;
+
+private:
+    void resize(uint32_t new_width, uint32_t new_height);
+    uint32_t tile_width(uint32_t tile_x) const;
+    uint32_t tile_height(uint32_t tile_y) const;
+};
@@ -7,4 +7,12 @@ namespace escape_codes
     constexpr auto clear_line = "\033[2K";
     constexpr auto clear_line_after_cursor = "\033[0K";
     constexpr auto hide_cursor = "\033[?25l";
+    /**
+     * @brief DEC mode 2026, the terminal shows nothing in between
+     * begin and end, so a frame never shows half drawn. Terminals
+     * without it ignore the mode. Also marks where frames end in
+     * the output stream, scripts/slow-link counts them.
+     */
+    constexpr auto begin_synchronized_update = "\033[?2026h";
+    constexpr auto end_synchronized_update = "\033[?2026l";
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include "chafa.h"
+#include "TermSize.h"
+
+/**
+ * @brief The chafa settings that the auto tune picks
+ *
+ */
+struct Auto_Tune_Settings
+{
+    ChafaSymbolTags symbol_tags;
+    gfloat work_factor;
+};
+
+/**
+ * @brief The settings ChafaInfo uses when auto tune is off
+ */
+constexpr Auto_Tune_Settings default_auto_tune_settings = {CHAFA_SYMBOL_TAG_ALL, 0.0};
+
+/**
+ * @brief Measures how fast the terminal consumes our output, by timing
+ * a Device Status Report round trip with and without a payload in front
+ * of it. Over ssh this is the speed of the whole link, not just the pty.
+ *
+ * Must be called before anyone else reads stdin (it reads the DSR reply).
+ *
+ * @param input_out gets whatever else was read from stdin meanwhile,
+ * so keys pressed during the measurement can still be handled
+ * @return bytes per second, or a negative number if it couldn't be measured
+ */
+double measure_link_drain_rate(std::string &input_out);
+
+/**
+ * @brief Where the settings for this host and terminal are cached
+ * between runs
+ */
+std::string auto_tune_cache_key();
+bool load_auto_tune_settings(const std::string &key, Auto_Tune_Settings *settings_out);
+void save_auto_tune_settings(const std::string &key, const Auto_Tune_Settings &settings);
+
+/**
+ * @brief Converts a synthetic frame at the current geometry with a few
+ * symbol sets and work factors (best quality first), and picks the first
+ * one whose conversion time plus time to drain its output fits in
+ * target_frame_time_seconds. If none fit, picks the cheapest.
+ *
+ * @param link_drain_rate bytes per second, from measure_link_drain_rate
+ */
+Auto_Tune_Settings auto_tune(gint width_cells,
+                             gint height_cells,
+                             uint32_t image_width,
+                             uint32_t image_height,
+                             TermSize &term_size,
+                             bool session_type_is_x11,
+                             double link_drain_rate,
+                             double target_frame_time_seconds);
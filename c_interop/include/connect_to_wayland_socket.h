@@ -0,0 +1,12 @@
+#pragma once
+#include <napi.h>
+
+using namespace Napi;
+
+/**
+ * @brief Connects to a wayland socket like a client does,
+ * for scripts/soak-test. The fd works with
+ * send_message_and_file_descriptors and
+ * get_message_and_file_descriptors like a client's socket.
+ */
+Value connect_to_wayland_socket_js(const CallbackInfo &info);
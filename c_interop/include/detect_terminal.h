@@ -8,7 +8,11 @@
  * @param term_info_out
  * @param mode_out
  * @param pixel_mode_out
+ * @param tmux_passthrough_out true if we are inside of tmux and the
+ * image sequences need to be wrapped in tmux passthrough to reach
+ * the outer terminal.
  */
 void detect_terminal(ChafaTermInfo **term_info_out,
                      ChafaCanvasMode *mode_out,
-                     ChafaPixelMode *pixel_mode_out);
\ No newline at end of file
+                     ChafaPixelMode *pixel_mode_out,
+                     bool *tmux_passthrough_out);
\ No newline at end of file
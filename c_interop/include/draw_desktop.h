@@ -4,3 +4,6 @@
 using namespace Napi;
 Value draw_desktop_js(const CallbackInfo &info);
   
+Value write_output_profile_js(const CallbackInfo &info);
+
+Value set_motion_scale_js(const CallbackInfo &info);
@@ -3,4 +3,6 @@
   #include <napi.h>
 using namespace Napi;
 Value init_draw_state_js(const CallbackInfo &info);
+Value take_auto_tune_input_js(const CallbackInfo &info);
+Value get_thread_pool_stats_js(const CallbackInfo &info);
   
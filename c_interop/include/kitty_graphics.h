@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Image ids go in a foreground color for Unicode placeholders,
+ * so at most 24 bits. Each process starts somewhere else in that
+ * range, so two of us in the same terminal (tmux panes) don't
+ * replace each other's images.
+ */
+constexpr uint32_t kitty_image_ids_per_process = 4096;
+
+/**
+ * @brief The first of this process's kitty_image_ids_per_process ids
+ */
+uint32_t first_kitty_image_id();
+
+/**
+ * @brief Appends a kitty graphics command that sends RGBA pixels,
+ * split into as many chunks as kitty wants.
+ * @param keys the keys of the first chunk, without f, s, v or m,
+ * like "a=T,i=5,q=2"
+ */
+void append_kitty_transmit(std::string &out,
+                           const std::string &keys,
+                           const uint8_t *rgba,
+                           uint32_t width,
+                           uint32_t height);
+
+/**
+ * @brief Scales 4 byte pixels to target_width by target_height,
+ * averaging when shrinking, and writes one rectangle of
+ * the result as RGBA.
+ *
+ * @param swap_red_and_blue true if source is BGRA
+ * @param out out_width * 4 stride
+ */
+void scale_to_rgba(const uint8_t *source,
+                   uint32_t source_width,
+                   uint32_t source_height,
+                   size_t source_stride,
+                   uint32_t target_width,
+                   uint32_t target_height,
+                   uint32_t out_x,
+                   uint32_t out_y,
+                   uint32_t out_width,
+                   uint32_t out_height,
+                   bool swap_red_and_blue,
+                   uint8_t *out);
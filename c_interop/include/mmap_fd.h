@@ -4,4 +4,6 @@
 using namespace Napi;
 Value mmap_shm_pool_js(const CallbackInfo &info);
 Value remap_shm_pool_js(const CallbackInfo &info);
-Value unmmap_shm_pool_js(const CallbackInfo &info);
\ No newline at end of file
+Value unmmap_shm_pool_js(const CallbackInfo &info);
+Value create_shm_buffer_js(const CallbackInfo &info);
+Value release_shm_buffer_js(const CallbackInfo &info);
\ No newline at end of file
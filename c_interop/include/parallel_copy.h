@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Pixel_Conversion
+{
+    none,
+    /**
+     * @brief RGBA to BGRA and back
+     */
+    swap_red_and_blue,
+    /**
+     * @brief Sets every alpha to 255, for xrgb8888 where
+     * the x is whatever the client left there
+     */
+    force_opaque,
+};
+
+/**
+ * @brief Copies rows of 4 byte pixels, converting them on the way.
+ *
+ * Small copies run right here. Big ones (a 4K surface is 33MB) are
+ * split into bands of rows across the shared Thread_Pool, this
+ * returns once every band is done. Copies too big to stay in the
+ * cache write with non-temporal stores, so they don't evict
+ * what the other threads are working on.
+ */
+void copy_rows(uint8_t *destination,
+               size_t destination_stride,
+               const uint8_t *source,
+               size_t source_stride,
+               size_t row_bytes,
+               uint32_t rows,
+               Pixel_Conversion conversion);
+
+/**
+ * @brief copy_rows for one contiguous run of pixels
+ */
+void copy_pixels(uint8_t *destination,
+                 const uint8_t *source,
+                 size_t length,
+                 Pixel_Conversion conversion);
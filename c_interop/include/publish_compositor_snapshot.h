@@ -0,0 +1,5 @@
+#pragma once
+
+  #include <napi.h>
+using namespace Napi;
+Value publish_compositor_snapshot_js(const CallbackInfo &info);
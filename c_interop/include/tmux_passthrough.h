@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief True if we are running inside of a tmux session
+ * (ie $TMUX is set)
+ */
+bool inside_tmux();
+
+/**
+ * @brief Asks the tmux server to expand a format string
+ * for the client we are attached to, for example
+ * "#{client_termname}" is the TERM of the outer terminal.
+ *
+ * @return the expanded format, or an empty string on failure
+ */
+std::string tmux_display(const char *format);
+
+/**
+ * @brief tmux only forwards DCS passthrough sequences
+ * when `allow-passthrough` is on (tmux 3.3+). Older versions
+ * don't have the option and always forward them.
+ */
+bool tmux_allows_passthrough();
+
+/**
+ * @brief The TERM of the terminal tmux is attached to, if we are
+ * inside of tmux and it allows passthrough, otherwise empty.
+ * Asks tmux the first time only, later calls are free.
+ */
+const std::string &tmux_outer_term();
+
+/**
+ * @brief Copies data to a new string, but wraps every image protocol
+ * sequence (kitty APC, sixel DCS, and iTerm2 OSC 1337) in tmux DCS
+ * passthrough so that it reaches the outer terminal. Everything else
+ * (text, SGR, cursor movement) is left alone so that tmux can still
+ * keep track of it.
+ */
+std::string wrap_image_sequences_for_tmux(const char *data, size_t length);
@@ -0,0 +1,6 @@
+#pragma once
+
+  #include <napi.h>
+using namespace Napi;
+Value update_texture_js(const CallbackInfo &info);
+Value create_texture_js(const CallbackInfo &info);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief From the wayland protocol, wl_shm_format
+ */
+constexpr uint32_t wl_shm_format_yuyv = 0x56595559;
+constexpr uint32_t wl_shm_format_nv12 = 0x3231564e;
+
+/**
+ * @return whether the format is one of the YUV formats below
+ */
+bool is_yuv_format(uint32_t format);
+
+/**
+ * @brief How many bytes of shared memory a buffer in this format
+ * takes. NV12's chroma plane comes right after the luma plane,
+ * with the same stride.
+ */
+size_t yuv_buffer_byte_length(uint32_t format, int32_t stride, int32_t height);
+
+/**
+ * @brief The smallest stride that holds a row of this width. Odd
+ * widths still have a whole chroma pair for the last pixel.
+ */
+size_t yuv_min_stride(uint32_t format, uint32_t width);
+
+/**
+ * @brief Converts a YUV buffer (BT.601, limited range, what video
+ * decoders give out unless told otherwise) to opaque BGRA with
+ * a stride of width * 4.
+ *
+ * Uses SSE2 where there is SSE2, and splits big frames into
+ * bands of rows on the shared Thread_Pool like copy_rows.
+ */
+void yuv_to_bgra(uint32_t format,
+                 const uint8_t *source,
+                 int32_t source_stride,
+                 uint32_t width,
+                 uint32_t height,
+                 uint8_t *destination);
@@ -1,5 +1,11 @@
 #include "ChafaInfo.h"
 #include "detect_terminal.h"
+#include "tmux_passthrough.h"
+
+ChafaPixelType ChafaInfo::desktop_pixel_type() const
+{
+    return pixel_mode == CHAFA_PIXEL_MODE_KITTY && !session_type_is_x11 ? CHAFA_PIXEL_RGBA8_UNASSOCIATED : CHAFA_PIXEL_BGRA8_UNASSOCIATED;
+}
 
 GString *ChafaInfo::convert_image(uint8_t *texture_pixels,
                                   uint32_t texture_width,
@@ -8,7 +14,7 @@ GString *ChafaInfo::convert_image(uint8_t *texture_pixels,
 {
 
     chafa_canvas_draw_all_pixels(canvas,
-                                 pixel_mode == CHAFA_PIXEL_MODE_KITTY && !session_type_is_x11 ? CHAFA_PIXEL_RGBA8_UNASSOCIATED : CHAFA_PIXEL_BGRA8_UNASSOCIATED,
+                                 desktop_pixel_type(),
                                  //   CHAFA_PIXEL_BGRA8_UNASSOCIATED,
                                  //   CHAFA_PIXEL_RGBA8_UNASSOCIATED,
                                  //  CHAFA_PIXEL_ARGB8_UNASSOCIATED,
@@ -17,6 +23,12 @@ GString *ChafaInfo::convert_image(uint8_t *texture_pixels,
                                  texture_height,
                                  texture_stride);
     auto printable = chafa_canvas_print(canvas, term_info);
+    if (tmux_passthrough)
+    {
+        auto wrapped = wrap_image_sequences_for_tmux(printable->str, printable->len);
+        g_string_truncate(printable, 0);
+        g_string_append_len(printable, wrapped.c_str(), wrapped.length());
+    }
     return printable;
 }
 
@@ -24,21 +36,22 @@ ChafaInfo::ChafaInfo(gint width_cells,
                      gint height_cells,
                      gint width_of_a_cell_in_pixels,
                      gint height_of_a_cell_in_pixels,
-                     bool session_type_is_x11) : width_cells(width_cells),
+                     bool session_type_is_x11,
+                     const Auto_Tune_Settings &settings) : width_cells(width_cells),
                                                  height_cells(height_cells),
                                                  width_of_a_cell_in_pixels(width_of_a_cell_in_pixels),
                                                  height_of_a_cell_in_pixels(height_of_a_cell_in_pixels),
                                                  session_type_is_x11(session_type_is_x11)
 {
     {
-        detect_terminal(&term_info, &mode, &pixel_mode);
+        detect_terminal(&term_info, &mode, &pixel_mode, &tmux_passthrough);
 
         /* Specify the symbols we want */
 
         symbol_map = chafa_symbol_map_new();
         // chafa_symbol_map_add_by_tags(symbol_map, CHAFA_SYMBOL_TAG_BLOCK);
         // chafa_symbol_map_add_by_tags(symbol_map, CHAFA_SYMBOL_TAG_ASCII);
-        chafa_symbol_map_add_by_tags(symbol_map, CHAFA_SYMBOL_TAG_ALL);
+        chafa_symbol_map_add_by_tags(symbol_map, settings.symbol_tags);
 
         /* Set up a configuration with the symbols and the canvas size in characters */
 
@@ -48,7 +61,7 @@ ChafaInfo::ChafaInfo(gint width_cells,
         chafa_canvas_config_set_geometry(config, width_cells, height_cells);
         chafa_canvas_config_set_symbol_map(config, symbol_map);
         // chafa_canvas_config_set_optimizations(config, TRUE);
-        chafa_canvas_config_set_work_factor(config, 0.0);
+        chafa_canvas_config_set_work_factor(config, settings.work_factor);
         // chafa_canvas_config_set_preprocessing_enabled(config, FALSE);
         // chafa_canvas_config_set_dither_intensity(config, CHAFA_DITHER_MODE_DIFFUSION);
 
@@ -0,0 +1,202 @@
+#include "Compositor_Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+uint64_t Compositor_Snapshot::region_signature(int64_t x, int64_t y, int64_t region_width, int64_t region_height) const
+{
+    uint64_t signature = 0;
+    auto mix = [&](uint64_t value)
+    {
+        signature = (signature ^ value) * 0x9E3779B97F4A7C15ull;
+        signature ^= signature >> 29;
+    };
+    auto draws = false;
+    for (auto &item : draw_list)
+    {
+        if (item.x < x + region_width && item.x + static_cast<int64_t>(item.texture->width) > x &&
+            item.y < y + region_height && item.y + static_cast<int64_t>(item.texture->height) > y)
+        {
+            draws = true;
+            mix(item.texture->version);
+            mix((static_cast<uint64_t>(static_cast<uint32_t>(item.x)) << 32) | static_cast<uint32_t>(item.y));
+        }
+    }
+    if (!draws)
+    {
+        return 0;
+    }
+    /**
+     * Never collide with nothing drawn
+     */
+    return signature == 0 ? 1 : signature;
+}
+
+void Compositor_Snapshot::compose_region(uint8_t *out,
+                                         size_t out_stride,
+                                         int64_t x,
+                                         int64_t y,
+                                         int64_t region_width,
+                                         int64_t region_height) const
+{
+    for (int64_t row = 0; row < region_height; row++)
+    {
+        memset(out + row * out_stride, 0, region_width * 4);
+    }
+
+    for (auto &item : draw_list)
+    {
+        auto &texture = *item.texture;
+        /**
+         * Clip the texture to the region, in desktop coordinates
+         */
+        auto left = std::max<int64_t>(item.x, x);
+        auto top = std::max<int64_t>(item.y, y);
+        auto right = std::min<int64_t>(static_cast<int64_t>(item.x) + texture.width, x + region_width);
+        auto bottom = std::min<int64_t>(static_cast<int64_t>(item.y) + texture.height, y + region_height);
+        if (left >= right || top >= bottom)
+        {
+            continue;
+        }
+        auto row_pixels = static_cast<size_t>(right - left);
+        auto texture_stride = static_cast<size_t>(texture.width) * 4;
+
+        for (auto row = top; row < bottom; row++)
+        {
+            auto source = texture.pixels.data() + (row - item.y) * texture_stride + (left - item.x) * 4;
+            auto destination = out + (row - y) * out_stride + (left - x) * 4;
+            if (texture.opaque)
+            {
+                memcpy(destination, source, row_pixels * 4);
+                continue;
+            }
+            /**
+             * Premultiplied source over destination
+             */
+            for (size_t i = 0; i < row_pixels * 4; i += 4)
+            {
+                auto alpha = source[i + 3];
+                if (alpha == 255)
+                {
+                    memcpy(destination + i, source + i, 4);
+                    continue;
+                }
+                if (alpha == 0)
+                {
+                    continue;
+                }
+                auto inverse = 255 - alpha;
+                for (auto c = 0; c < 4; c++)
+                {
+                    auto value = source[i + c] + (destination[i + c] * inverse + 127) / 255;
+                    destination[i + c] = static_cast<uint8_t>(std::min(value, 255));
+                }
+            }
+        }
+    }
+}
+
+
+Snapshot_Publisher::~Snapshot_Publisher()
+{
+    /**
+     * By now every reader has to be gone
+     */
+    for (auto &[retired_epoch, snapshot] : retired)
+    {
+        delete snapshot;
+    }
+    delete current.load();
+}
+
+uint64_t Snapshot_Publisher::next_sequence() const
+{
+    return sequence + 1;
+}
+
+void Snapshot_Publisher::publish(Compositor_Snapshot *snapshot)
+{
+    snapshot->sequence = ++sequence;
+    auto old = current.exchange(snapshot);
+    /**
+     * Anyone who could have loaded old pinned
+     * an epoch <= this one before loading it
+     */
+    auto retired_epoch = epoch.fetch_add(1);
+    if (old != nullptr)
+    {
+        retired.emplace_back(retired_epoch, old);
+    }
+    reclaim();
+}
+
+void Snapshot_Publisher::reclaim()
+{
+    auto oldest_pinned = UINT64_MAX;
+    for (auto &slot : slots)
+    {
+        auto pinned = slot.epoch.load();
+        if (pinned != 0)
+        {
+            oldest_pinned = std::min(oldest_pinned, pinned);
+        }
+    }
+    std::erase_if(retired, [&](auto &entry)
+                  {
+        if (entry.first >= oldest_pinned)
+        {
+            return false;
+        }
+        delete entry.second;
+        return true; });
+}
+
+Snapshot_Publisher::Reader::Reader(Snapshot_Publisher &publisher)
+    : publisher(publisher), slot_index(max_readers)
+{
+    for (size_t i = 0; i < max_readers; i++)
+    {
+        auto expected = false;
+        if (publisher.slots[i].claimed.compare_exchange_strong(expected, true))
+        {
+            slot_index = i;
+            return;
+        }
+    }
+    std::cerr << "Snapshot_Publisher: more than " << max_readers << " readers" << std::endl;
+}
+
+Snapshot_Publisher::Reader::~Reader()
+{
+    if (!claimed())
+    {
+        return;
+    }
+    leave();
+    publisher.slots[slot_index].claimed.store(false);
+}
+
+bool Snapshot_Publisher::Reader::claimed() const
+{
+    return slot_index < max_readers;
+}
+
+const Compositor_Snapshot *Snapshot_Publisher::Reader::enter()
+{
+    if (!claimed())
+    {
+        return nullptr;
+    }
+    publisher.slots[slot_index].epoch.store(publisher.epoch.load());
+    return publisher.current.load();
+}
+
+void Snapshot_Publisher::Reader::leave()
+{
+    if (!claimed())
+    {
+        return;
+    }
+    publisher.slots[slot_index].epoch.store(0);
+}
@@ -1,6 +1,12 @@
 #include "Draw_State.h"
+#include "tmux_passthrough.h"
 
-void Draw_State::resize_chafa_info_if_needed(gint width_cells, gint height_cells,
+#include <algorithm>
+#include <cmath>
+
+bool Draw_State::resize_chafa_info_if_needed(gint width_cells, gint height_cells,
+                                             uint32_t image_width,
+                                             uint32_t image_height,
                                              TermSize &term_size)
 {
 
@@ -13,25 +19,165 @@ void Draw_State::resize_chafa_info_if_needed(gint width_cells, gint height_cells
         chafa_info = nullptr;
     }
 
-    if (chafa_info == nullptr)
+    if (chafa_info != nullptr)
+    {
+        return false;
+    }
+    if (motion_chafa_info != nullptr)
+    {
+        delete motion_chafa_info;
+        motion_chafa_info = nullptr;
+    }
+    chafa_info = new ChafaInfo(width_cells,
+                               height_cells,
+                               term_size.width_of_a_cell_in_pixels,
+                               term_size.height_of_a_cell_in_pixels,
+                               session_type_is_x11,
+                               settings);
+
+    if (needs_auto_tune)
     {
+        needs_auto_tune = false;
+        /**
+         * The symbol set and work factor only matter when drawing
+         * with symbols, not with an image protocol. Still cache the
+         * defaults, so the next start doesn't measure the link again.
+         */
+        if (chafa_info->pixel_mode != CHAFA_PIXEL_MODE_SYMBOLS)
+        {
+            save_auto_tune_settings(auto_tune_cache_key, settings);
+            return true;
+        }
+        settings = auto_tune(width_cells,
+                             height_cells,
+                             image_width,
+                             image_height,
+                             term_size,
+                             session_type_is_x11,
+                             link_drain_rate,
+                             auto_tune_frame_time_seconds);
+        save_auto_tune_settings(auto_tune_cache_key, settings);
+
+        delete chafa_info;
         chafa_info = new ChafaInfo(width_cells,
                                    height_cells,
                                    term_size.width_of_a_cell_in_pixels,
                                    term_size.height_of_a_cell_in_pixels,
-                                   session_type_is_x11);
+                                   session_type_is_x11,
+                                   settings);
+    }
+    return true;
+}
+
+void Draw_State::set_motion_scale(double scale)
+{
+    auto rounded = std::isfinite(scale) ? std::clamp(std::round(scale * 8) / 8, 0.25, 1.0) : 1.0;
+    if (rounded == motion_scale)
+    {
+        return;
+    }
+    motion_scale = rounded;
+    if (motion_chafa_info != nullptr)
+    {
+        delete motion_chafa_info;
+        motion_chafa_info = nullptr;
+    }
+}
+
+ChafaInfo *Draw_State::get_motion_chafa_info()
+{
+    if (motion_chafa_info != nullptr)
+    {
+        return motion_chafa_info;
     }
+    auto cell_width = std::max<gint>(1, std::lround(chafa_info->width_of_a_cell_in_pixels * motion_scale));
+    auto cell_height = std::max<gint>(1, std::lround(chafa_info->height_of_a_cell_in_pixels * motion_scale));
+    motion_chafa_info = new ChafaInfo(chafa_info->width_cells,
+                                      chafa_info->height_cells,
+                                      cell_width,
+                                      cell_height,
+                                      session_type_is_x11,
+                                      settings);
+    return motion_chafa_info;
 }
 
-Draw_State::Draw_State(bool session_type_is_x11) : session_type_is_x11(session_type_is_x11)
+Draw_State::Draw_State(bool session_type_is_x11,
+                       const Draw_State_Options &options) : session_type_is_x11(session_type_is_x11),
+                                                            auto_tune_frame_time_seconds(options.auto_tune_frame_time_seconds)
 {
+    /**
+     * Asking tmux about the outer terminal runs tmux, do it
+     * now instead of in the first ChafaInfo made while drawing
+     */
+    tmux_outer_term();
+    if (!options.record_output_path.empty())
+    {
+        output_recorder = new Output_Recorder(options.record_output_path);
+    }
+    if (!options.profile_output_path.empty())
+    {
+        output_profiler = new Output_Profiler(options.profile_output_path);
+    }
+    if (options.kitty_placeholders)
+    {
+        kitty_placeholders = new Kitty_Placeholders();
+    }
+    if (options.kitty_windows)
+    {
+        kitty_windows = new Kitty_Windows();
+    }
+    if (options.mosaic_grid.has_value())
+    {
+        mosaic_renderer = new Mosaic_Renderer(*options.mosaic_grid);
+    }
+    if (auto_tune_frame_time_seconds <= 0)
+    {
+        return;
+    }
+    auto_tune_cache_key = ::auto_tune_cache_key();
+    if (load_auto_tune_settings(auto_tune_cache_key, &settings))
+    {
+        return;
+    }
+    link_drain_rate = measure_link_drain_rate(input_read_during_auto_tune);
+    needs_auto_tune = true;
 }
 
 Draw_State::~Draw_State()
 {
+    if (output_recorder != nullptr)
+    {
+        delete output_recorder;
+        output_recorder = nullptr;
+    }
+    if (output_profiler != nullptr)
+    {
+        delete output_profiler;
+        output_profiler = nullptr;
+    }
+    if (kitty_placeholders != nullptr)
+    {
+        delete kitty_placeholders;
+        kitty_placeholders = nullptr;
+    }
+    if (kitty_windows != nullptr)
+    {
+        delete kitty_windows;
+        kitty_windows = nullptr;
+    }
+    if (mosaic_renderer != nullptr)
+    {
+        delete mosaic_renderer;
+        mosaic_renderer = nullptr;
+    }
+    if (motion_chafa_info != nullptr)
+    {
+        delete motion_chafa_info;
+        motion_chafa_info = nullptr;
+    }
     if (chafa_info != nullptr)
     {
         delete chafa_info;
         chafa_info = nullptr;
     }
-}
\ No newline at end of file
+}
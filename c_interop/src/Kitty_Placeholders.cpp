@@ -0,0 +1,202 @@
+#include "Kitty_Placeholders.h"
+#include "Thread_Pool.h"
+#include "kitty_graphics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+constexpr uint32_t placeholder = 0x10EEEE;
+
+/**
+ * @brief The start of kitty's rowcolumn-diacritics.txt, the n-th
+ * one means row or column n. Tiles never need more than these.
+ */
+static const uint32_t row_column_diacritics[] = {
+    0x0305, 0x030D, 0x030E, 0x0310, 0x0312, 0x033D, 0x033E, 0x033F,
+    0x0346, 0x034A, 0x034B, 0x034C, 0x0350, 0x0351, 0x0352, 0x0357};
+static_assert(std::size(row_column_diacritics) >= Kitty_Placeholders::tile_columns);
+static_assert(std::size(row_column_diacritics) >= Kitty_Placeholders::tile_rows);
+
+static void append_utf8(std::string &out, uint32_t code_point)
+{
+    if (code_point < 0x80)
+    {
+        out += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+Kitty_Placeholders::Kitty_Placeholders()
+    : first_image_id(first_kitty_image_id())
+{
+}
+
+std::string Kitty_Placeholders::change_layout(uint32_t new_width_cells,
+                                              uint32_t new_height_cells,
+                                              uint32_t new_cell_width,
+                                              uint32_t new_cell_height,
+                                              uint32_t new_first_row)
+{
+    std::stringstream deletes;
+    for (auto &tile : tiles)
+    {
+        /**
+         * Capital I frees the image data too, not just the placement
+         */
+        deletes << "\033_Ga=d,d=I,i=" << tile.image_id << ",q=2\033\\";
+    }
+    tiles.clear();
+
+    width_cells = new_width_cells;
+    height_cells = new_height_cells;
+    cell_width = new_cell_width;
+    cell_height = new_cell_height;
+    first_row = new_first_row;
+
+    for (uint32_t row = 0; row < height_cells; row += tile_rows)
+    {
+        for (uint32_t column = 0; column < width_cells; column += tile_columns)
+        {
+            Tile tile;
+            tile.column = column;
+            tile.row = row;
+            tile.columns = std::min(tile_columns, width_cells - column);
+            tile.rows = std::min(tile_rows, height_cells - row);
+            tile.image_id = first_image_id + static_cast<uint32_t>(tiles.size()) % kitty_image_ids_per_process;
+            tiles.push_back(std::move(tile));
+        }
+    }
+    make_placeholder_text();
+    return deletes.str();
+}
+
+void Kitty_Placeholders::make_placeholder_text()
+{
+    placeholder_text.clear();
+    auto tiles_x = (width_cells + tile_columns - 1) / tile_columns;
+    for (uint32_t row = 0; row < height_cells; row++)
+    {
+        placeholder_text += "\033[" + std::to_string(first_row + row + 1) + ";1H";
+        auto first_tile = (row / tile_rows) * tiles_x;
+        for (auto i = first_tile; i < first_tile + tiles_x; i++)
+        {
+            auto &tile = tiles[i];
+            auto id = tile.image_id;
+            placeholder_text += "\033[38;2;" + std::to_string((id >> 16) & 0xFF) + ";" +
+                                std::to_string((id >> 8) & 0xFF) + ";" +
+                                std::to_string(id & 0xFF) + "m";
+            /**
+             * The rest of the cells in this row of the tile leave
+             * out the diacritics, they are the cell to the left + 1
+             */
+            append_utf8(placeholder_text, placeholder);
+            append_utf8(placeholder_text, row_column_diacritics[row - tile.row]);
+            append_utf8(placeholder_text, row_column_diacritics[0]);
+            for (uint32_t column = 1; column < tile.columns; column++)
+            {
+                append_utf8(placeholder_text, placeholder);
+            }
+        }
+        placeholder_text += "\033[m";
+    }
+}
+
+std::string Kitty_Placeholders::draw(const uint8_t *pixels,
+                                     uint32_t width,
+                                     uint32_t height,
+                                     bool swap_red_and_blue,
+                                     uint32_t new_width_cells,
+                                     uint32_t new_height_cells,
+                                     uint32_t new_cell_width,
+                                     uint32_t new_cell_height,
+                                     uint32_t new_first_row,
+                                     bool redraw_text)
+{
+    std::string out;
+    auto new_layout = new_width_cells != width_cells ||
+                      new_height_cells != height_cells ||
+                      new_cell_width != cell_width ||
+                      new_cell_height != cell_height ||
+                      new_first_row != first_row;
+    if (new_layout)
+    {
+        out += change_layout(new_width_cells, new_height_cells, new_cell_width, new_cell_height, new_first_row);
+    }
+    if (width == 0 || height == 0 || cell_width == 0 || cell_height == 0 || tiles.empty())
+    {
+        return out;
+    }
+
+    thread_pool().parallel_for(tiles.size(), [&](size_t begin, size_t end)
+                               {
+        for (auto i = begin; i < end; i++)
+        {
+            auto &tile = tiles[i];
+            auto tile_width = tile.columns * cell_width;
+            auto tile_height = tile.rows * cell_height;
+            tile.scaled.resize(static_cast<size_t>(tile_width) * tile_height * 4);
+
+            scale_to_rgba(pixels,
+                          width,
+                          height,
+                          static_cast<size_t>(width) * 4,
+                          width_cells * cell_width,
+                          height_cells * cell_height,
+                          tile.column * cell_width,
+                          tile.row * cell_height,
+                          tile_width,
+                          tile_height,
+                          swap_red_and_blue,
+                          tile.scaled.data());
+
+            tile.changed = tile.pixels.size() != tile.scaled.size() ||
+                           memcmp(tile.pixels.data(), tile.scaled.data(), tile.scaled.size()) != 0;
+            tile.upload.clear();
+            if (!tile.changed)
+            {
+                continue;
+            }
+            tile.pixels.swap(tile.scaled);
+
+            /**
+             * Transmit and make a virtual placement (U=1) in one go,
+             * replacing the last upload with the same id
+             */
+            append_kitty_transmit(tile.upload,
+                                  "a=T,U=1,q=2,c=" + std::to_string(tile.columns) +
+                                      ",r=" + std::to_string(tile.rows) +
+                                      ",i=" + std::to_string(tile.image_id),
+                                  tile.pixels.data(),
+                                  tile_width,
+                                  tile_height);
+        } });
+
+    for (auto &tile : tiles)
+    {
+        out += tile.upload;
+        tile.upload.clear();
+    }
+    if (new_layout || redraw_text)
+    {
+        out += placeholder_text;
+    }
+    return out;
+}
@@ -0,0 +1,246 @@
+#include "Kitty_Windows.h"
+#include "Thread_Pool.h"
+#include "kitty_graphics.h"
+
+#include <algorithm>
+
+/**
+ * @brief Rounds towards negative infinity, windows
+ * can hang off the left and top of the desktop
+ */
+static int64_t floor_divide(int64_t numerator, int64_t denominator)
+{
+    auto quotient = numerator / denominator;
+    return (numerator % denominator != 0 && (numerator < 0) != (denominator < 0)) ? quotient - 1 : quotient;
+}
+
+Kitty_Windows::Kitty_Windows() : first_image_id(first_kitty_image_id())
+{
+}
+
+uint32_t Kitty_Windows::allocate_image_id()
+{
+    /**
+     * An id is only handed out again after its image was deleted,
+     * uploading to an id in use would replace that window's image
+     */
+    if (!free_image_ids.empty())
+    {
+        auto image_id = free_image_ids.back();
+        free_image_ids.pop_back();
+        return image_id;
+    }
+    if (next_image < kitty_image_ids_per_process)
+    {
+        return first_image_id + next_image++;
+    }
+    return 0;
+}
+
+void Kitty_Windows::delete_image(std::string &out, uint32_t image_id)
+{
+    /**
+     * Capital I frees the image data too, not just the placement
+     */
+    out += "\033_Ga=d,d=I,i=" + std::to_string(image_id) + ",q=2\033\\";
+    free_image_ids.push_back(image_id);
+}
+
+std::string Kitty_Windows::draw(const Compositor_Snapshot &snapshot,
+                                bool swap_red_and_blue,
+                                uint32_t new_width_cells,
+                                uint32_t new_height_cells,
+                                uint32_t new_cell_width,
+                                uint32_t new_cell_height,
+                                uint32_t new_first_row,
+                                bool place_again)
+{
+    std::string out;
+    if (snapshot.width != desktop_width ||
+        snapshot.height != desktop_height ||
+        new_width_cells != width_cells ||
+        new_height_cells != height_cells ||
+        new_cell_width != cell_width ||
+        new_cell_height != cell_height ||
+        new_first_row != first_row)
+    {
+        /**
+         * Every image is a different size now
+         */
+        for (auto &image : images)
+        {
+            delete_image(out, image.image_id);
+        }
+        images.clear();
+        desktop_width = snapshot.width;
+        desktop_height = snapshot.height;
+        width_cells = new_width_cells;
+        height_cells = new_height_cells;
+        cell_width = new_cell_width;
+        cell_height = new_cell_height;
+        first_row = new_first_row;
+        /**
+         * Clear whatever was drawn on the desktop's rows before
+         */
+        out += "\033[" + std::to_string(first_row + 1) + ";1H\033[J";
+    }
+    if (desktop_width == 0 || desktop_height == 0 || cell_width == 0 || cell_height == 0)
+    {
+        return out;
+    }
+    int64_t target_width = static_cast<int64_t>(width_cells) * cell_width;
+    int64_t target_height = static_cast<int64_t>(height_cells) * cell_height;
+
+    for (auto &image : images)
+    {
+        image.in_snapshot = false;
+    }
+
+    /**
+     * Find the image of every draw item, the new ones are
+     * scaled and encoded in parallel after
+     */
+    std::vector<size_t> image_of_item(snapshot.draw_list.size());
+    std::vector<size_t> new_images;
+    for (size_t i = 0; i < snapshot.draw_list.size(); i++)
+    {
+        auto &item = snapshot.draw_list[i];
+        auto found = std::find_if(images.begin(), images.end(), [&](const Window_Image &image)
+                                  { return image.texture == item.texture; });
+        if (found != images.end())
+        {
+            found->in_snapshot = true;
+            image_of_item[i] = found - images.begin();
+            continue;
+        }
+        auto image_id = allocate_image_id();
+        if (image_id == 0)
+        {
+            /**
+             * Thousands of windows, the rest aren't drawn
+             */
+            image_of_item[i] = SIZE_MAX;
+            continue;
+        }
+        Window_Image image;
+        image.texture = item.texture;
+        image.image_id = image_id;
+        image.width = static_cast<uint32_t>(std::max<int64_t>(1, item.texture->width * target_width / desktop_width));
+        image.height = static_cast<uint32_t>(std::max<int64_t>(1, item.texture->height * target_height / desktop_height));
+        image.in_snapshot = true;
+        image_of_item[i] = images.size();
+        new_images.push_back(images.size());
+        images.push_back(std::move(image));
+    }
+
+    thread_pool().parallel_for(new_images.size(), [&](size_t begin, size_t end)
+                               {
+        std::vector<uint8_t> scaled;
+        for (auto i = begin; i < end; i++)
+        {
+            auto &image = images[new_images[i]];
+            auto &texture = *image.texture;
+            scaled.resize(static_cast<size_t>(image.width) * image.height * 4);
+            scale_to_rgba(texture.pixels.data(),
+                          texture.width,
+                          texture.height,
+                          static_cast<size_t>(texture.width) * 4,
+                          image.width,
+                          image.height,
+                          0,
+                          0,
+                          image.width,
+                          image.height,
+                          swap_red_and_blue,
+                          scaled.data());
+            append_kitty_transmit(image.upload,
+                                  "a=t,q=2,i=" + std::to_string(image.image_id),
+                                  scaled.data(),
+                                  image.width,
+                                  image.height);
+        } });
+
+    /**
+     * Deleting first also takes the placements of
+     * surfaces that are gone or got new content
+     */
+    for (auto image = images.begin(); image != images.end();)
+    {
+        if (image->in_snapshot)
+        {
+            image++;
+            continue;
+        }
+        delete_image(out, image->image_id);
+        image = images.erase(image);
+        for (auto &index : image_of_item)
+        {
+            if (index != SIZE_MAX && index > static_cast<size_t>(image - images.begin()))
+            {
+                index--;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < snapshot.draw_list.size(); i++)
+    {
+        if (image_of_item[i] == SIZE_MAX)
+        {
+            continue;
+        }
+        auto &item = snapshot.draw_list[i];
+        auto &image = images[image_of_item[i]];
+        out += image.upload;
+        image.upload.clear();
+
+        Placement placement;
+        placement.x = floor_divide(static_cast<int64_t>(item.x) * target_width, desktop_width);
+        placement.y = floor_divide(static_cast<int64_t>(item.y) * target_height, desktop_height);
+        /**
+         * Bottom first, so later items go on top
+         */
+        placement.z = static_cast<uint32_t>(i + 1);
+
+        auto visible_x0 = std::max<int64_t>(placement.x, 0);
+        auto visible_y0 = std::max<int64_t>(placement.y, 0);
+        auto visible_x1 = std::min<int64_t>(placement.x + image.width, target_width);
+        auto visible_y1 = std::min<int64_t>(placement.y + image.height, target_height);
+        if (visible_x1 <= visible_x0 || visible_y1 <= visible_y0)
+        {
+            if (image.placed)
+            {
+                out += "\033_Ga=d,d=i,i=" + std::to_string(image.image_id) + ",q=2\033\\";
+                image.placed = false;
+            }
+            continue;
+        }
+        placement.source_x = static_cast<uint32_t>(visible_x0 - placement.x);
+        placement.source_y = static_cast<uint32_t>(visible_y0 - placement.y);
+        placement.source_width = static_cast<uint32_t>(visible_x1 - visible_x0);
+        placement.source_height = static_cast<uint32_t>(visible_y1 - visible_y0);
+
+        if (image.placed && image.placement == placement && !place_again)
+        {
+            continue;
+        }
+        image.placed = true;
+        image.placement = placement;
+
+        /**
+         * Placements go where the cursor is, plus an offset in
+         * pixels inside that cell. The same placement id
+         * replaces the old placement, that is the move.
+         */
+        out += "\033[" + std::to_string(first_row + 1 + visible_y0 / cell_height) + ";" +
+               std::to_string(1 + visible_x0 / cell_width) + "H";
+        out += "\033_Ga=p,p=1,C=1,q=2,i=" + std::to_string(image.image_id) +
+               ",x=" + std::to_string(placement.source_x) +
+               ",y=" + std::to_string(placement.source_y) +
+               ",w=" + std::to_string(placement.source_width) +
+               ",h=" + std::to_string(placement.source_height) +
+               ",X=" + std::to_string(visible_x0 % cell_width) +
+               ",Y=" + std::to_string(visible_y0 % cell_height) +
+               ",z=" + std::to_string(placement.z) + "\033\\";
+    }
+    return out;
+}
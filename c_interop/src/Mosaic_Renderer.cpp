@@ -0,0 +1,456 @@
+#include "Mosaic_Renderer.h"
+#include "Thread_Pool.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Rows of cells are drawn on their own, fewer than
+ * this per task and waking the threads costs more than it saves
+ */
+constexpr size_t min_rows_per_task = 4;
+
+/**
+ * @brief Octant masks that Unicode 16 left out of the octant block
+ * because an older character already looks like them
+ */
+static const std::pair<uint32_t, uint32_t> octants_elsewhere[] = {
+    {0, ' '},
+    {1, 0x1CEA8},
+    {2, 0x1CEAB},
+    {3, 0x1FB82},
+    {5, 0x2598},
+    {10, 0x259D},
+    {15, 0x2580},
+    {20, 0x1FBE6},
+    {40, 0x1FBE7},
+    {63, 0x1FB85},
+    {64, 0x1CEA3},
+    {80, 0x2596},
+    {85, 0x258C},
+    {90, 0x259E},
+    {95, 0x259B},
+    {128, 0x1CEA0},
+    {160, 0x2597},
+    {165, 0x259A},
+    {170, 0x2590},
+    {175, 0x259C},
+    {192, 0x2582},
+    {240, 0x2584},
+    {245, 0x2599},
+    {250, 0x259F},
+    {252, 0x2586},
+    {255, 0x2588},
+};
+
+/**
+ * @brief Braille numbers its dots down the left column, down the
+ * right, then the bottom row, the split goes across each row
+ */
+static const uint8_t braille_dots[] = {0x01, 0x08, 0x02, 0x10, 0x04, 0x20, 0x40, 0x80};
+
+static void append_utf8(std::string &out, uint32_t code_point)
+{
+    if (code_point < 0x80)
+    {
+        out += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+static uint32_t sextant_code_point(uint32_t mask)
+{
+    switch (mask)
+    {
+    case 0:
+        return ' ';
+    case 21:
+        return 0x258C;
+    case 42:
+        return 0x2590;
+    case 63:
+        return 0x2588;
+    }
+    /**
+     * The block skips the two halves, they were already there
+     */
+    return 0x1FB00 + mask - 1 - (mask > 21 ? 1 : 0) - (mask > 42 ? 1 : 0);
+}
+
+static uint32_t braille_code_point(uint32_t mask)
+{
+    if (mask == 0)
+    {
+        return ' ';
+    }
+    uint32_t dots = 0;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        if (mask & (1u << i))
+        {
+            dots |= braille_dots[i];
+        }
+    }
+    return 0x2800 + dots;
+}
+
+bool mosaic_grid_from_name(const std::string &name, Mosaic_Grid *grid_out)
+{
+    if (name == "sextant")
+    {
+        *grid_out = Mosaic_Grid::sextant;
+    }
+    else if (name == "octant")
+    {
+        *grid_out = Mosaic_Grid::octant;
+    }
+    else if (name == "braille")
+    {
+        *grid_out = Mosaic_Grid::braille;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+Mosaic_Renderer::Mosaic_Renderer(Mosaic_Grid grid) : sub_rows(grid == Mosaic_Grid::sextant ? 3 : 4)
+{
+    uint32_t next_octant = 0x1CD00;
+    for (uint32_t mask = 0; mask < characters.size(); mask++)
+    {
+        uint32_t code_point = ' ';
+        switch (grid)
+        {
+        case Mosaic_Grid::sextant:
+            code_point = mask < 64 ? sextant_code_point(mask) : ' ';
+            break;
+        case Mosaic_Grid::octant:
+        {
+            auto elsewhere = std::find_if(std::begin(octants_elsewhere),
+                                          std::end(octants_elsewhere),
+                                          [mask](const auto &octant)
+                                          { return octant.first == mask; });
+            code_point = elsewhere != std::end(octants_elsewhere) ? elsewhere->second : next_octant++;
+            break;
+        }
+        case Mosaic_Grid::braille:
+            code_point = braille_code_point(mask);
+            break;
+        }
+        append_utf8(characters[mask], code_point);
+    }
+}
+
+bool Mosaic_Renderer::can_draw(ChafaCanvasMode mode)
+{
+    return mode == CHAFA_CANVAS_MODE_TRUECOLOR ||
+           mode == CHAFA_CANVAS_MODE_INDEXED_256 ||
+           mode == CHAFA_CANVAS_MODE_INDEXED_240;
+}
+
+/**
+ * @brief The sub pixels of one cell, a channel per row of 8 lanes
+ * (row * 2 + column), in the byte order of the desktop. Sextants
+ * fill the last two lanes with the first so they don't widen a range.
+ */
+struct alignas(16) Cell_Samples
+{
+    int16_t channels[3][8];
+};
+
+#if defined(__SSE2__)
+static inline int16_t horizontal_min(__m128i v)
+{
+    v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<int16_t>(_mm_cvtsi128_si32(v));
+}
+
+static inline int16_t horizontal_max(__m128i v)
+{
+    v = _mm_max_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<int16_t>(_mm_cvtsi128_si32(v));
+}
+#endif
+
+/**
+ * @return bit n set if lane n is above the middle
+ * of the channel with the widest range
+ */
+static uint32_t split_cell(const Cell_Samples &cell)
+{
+#if defined(__SSE2__)
+    auto widest = _mm_setzero_si128();
+    int range = -1;
+    int16_t middle = 0;
+    for (auto &channel : cell.channels)
+    {
+        auto v = _mm_load_si128(reinterpret_cast<const __m128i *>(channel));
+        auto low = horizontal_min(v);
+        auto high = horizontal_max(v);
+        if (high - low > range)
+        {
+            range = high - low;
+            middle = static_cast<int16_t>((low + high) / 2);
+            widest = v;
+        }
+    }
+    /**
+     * 0xFFFF or 0 per lane, packed to a byte per lane,
+     * and movemask takes the top bit of each
+     */
+    auto above = _mm_cmpgt_epi16(widest, _mm_set1_epi16(middle));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(above, _mm_setzero_si128()))) & 0xFF;
+#else
+    const int16_t *widest = cell.channels[0];
+    int range = -1;
+    int middle = 0;
+    for (auto &channel : cell.channels)
+    {
+        auto [low, high] = std::minmax_element(channel, channel + 8);
+        if (*high - *low > range)
+        {
+            range = *high - *low;
+            middle = (*low + *high) / 2;
+            widest = channel;
+        }
+    }
+    uint32_t mask = 0;
+    for (uint32_t lane = 0; lane < 8; lane++)
+    {
+        if (widest[lane] > middle)
+        {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief The nearest of xterm's 6x6x6 color cube,
+ * whose levels are 0, 95, 135, 175, 215, 255
+ */
+static inline uint32_t cube_level(uint32_t value)
+{
+    return value < 48 ? 0 : value < 115 ? 1
+                                        : (value - 35) / 40;
+}
+
+static inline uint32_t color_key(bool indexed, uint32_t red, uint32_t green, uint32_t blue)
+{
+    if (indexed)
+    {
+        return 16 + 36 * cube_level(red) + 6 * cube_level(green) + cube_level(blue);
+    }
+    return (red << 16) | (green << 8) | blue;
+}
+
+static void append_color(std::string &out, bool indexed, bool foreground, uint32_t key)
+{
+    out += foreground ? "38;" : "48;";
+    if (indexed)
+    {
+        out += "5;" + std::to_string(key);
+        return;
+    }
+    out += "2;" + std::to_string(key >> 16) + ";" +
+           std::to_string((key >> 8) & 0xFF) + ";" +
+           std::to_string(key & 0xFF);
+}
+
+void Mosaic_Renderer::draw_row(const uint8_t *pixels,
+                               uint32_t width,
+                               uint32_t height,
+                               bool pixels_are_bgra,
+                               bool indexed,
+                               uint32_t width_cells,
+                               uint32_t height_cells,
+                               uint32_t row,
+                               std::string &out)
+{
+    auto sub_columns_total = static_cast<uint64_t>(width_cells) * 2;
+    auto sub_rows_total = static_cast<uint64_t>(height_cells) * sub_rows;
+    auto lanes = sub_rows * 2;
+    auto all_lanes = (1u << lanes) - 1;
+    auto red = pixels_are_bgra ? 2 : 0;
+    auto blue = pixels_are_bgra ? 0 : 2;
+
+    /**
+     * No color yet, so the first cell sets both
+     */
+    uint64_t foreground = UINT64_MAX;
+    uint64_t background = UINT64_MAX;
+
+    Cell_Samples cell;
+    for (uint32_t column = 0; column < width_cells; column++)
+    {
+        for (uint32_t sub_row = 0; sub_row < sub_rows; sub_row++)
+        {
+            auto y = static_cast<uint64_t>(row) * sub_rows + sub_row;
+            auto top = static_cast<uint32_t>(y * height / sub_rows_total);
+            auto bottom = std::max(top + 1, static_cast<uint32_t>((y + 1) * height / sub_rows_total));
+            for (uint32_t sub_column = 0; sub_column < 2; sub_column++)
+            {
+                auto x = static_cast<uint64_t>(column) * 2 + sub_column;
+                auto left = static_cast<uint32_t>(x * width / sub_columns_total);
+                auto right = std::max(left + 1, static_cast<uint32_t>((x + 1) * width / sub_columns_total));
+                uint32_t sums[3] = {0, 0, 0};
+                for (auto pixel_y = top; pixel_y < bottom; pixel_y++)
+                {
+                    auto pixel = pixels + (static_cast<size_t>(pixel_y) * width + left) * 4;
+                    for (auto pixel_x = left; pixel_x < right; pixel_x++, pixel += 4)
+                    {
+                        sums[0] += pixel[0];
+                        sums[1] += pixel[1];
+                        sums[2] += pixel[2];
+                    }
+                }
+                auto count = (bottom - top) * (right - left);
+                auto lane = sub_row * 2 + sub_column;
+                for (uint32_t channel = 0; channel < 3; channel++)
+                {
+                    cell.channels[channel][lane] = static_cast<int16_t>((sums[channel] + count / 2) / count);
+                }
+            }
+        }
+        for (auto lane = lanes; lane < 8; lane++)
+        {
+            for (auto &channel : cell.channels)
+            {
+                channel[lane] = channel[0];
+            }
+        }
+
+        auto mask = split_cell(cell) & all_lanes;
+
+        uint32_t set_sums[3] = {0, 0, 0};
+        uint32_t unset_sums[3] = {0, 0, 0};
+        for (uint32_t lane = 0; lane < lanes; lane++)
+        {
+            auto sums = (mask & (1u << lane)) ? set_sums : unset_sums;
+            for (uint32_t channel = 0; channel < 3; channel++)
+            {
+                sums[channel] += static_cast<uint32_t>(cell.channels[channel][lane]);
+            }
+        }
+        auto set_count = static_cast<uint32_t>(__builtin_popcount(mask));
+        auto unset_count = lanes - set_count;
+
+        auto foreground_key = set_count == 0 ? 0 : color_key(indexed,
+                                                             (set_sums[red] + set_count / 2) / set_count,
+                                                             (set_sums[1] + set_count / 2) / set_count,
+                                                             (set_sums[blue] + set_count / 2) / set_count);
+        auto background_key = unset_count == 0 ? 0 : color_key(indexed,
+                                                               (unset_sums[red] + unset_count / 2) / unset_count,
+                                                               (unset_sums[1] + unset_count / 2) / unset_count,
+                                                               (unset_sums[blue] + unset_count / 2) / unset_count);
+        /**
+         * Both halves can come out as the same index of the cube
+         */
+        if (set_count > 0 && unset_count > 0 && foreground_key == background_key)
+        {
+            mask = 0;
+            set_count = 0;
+            unset_count = lanes;
+        }
+
+        std::string colors;
+        if (set_count > 0 && foreground_key != foreground)
+        {
+            foreground = foreground_key;
+            append_color(colors, indexed, true, foreground_key);
+        }
+        if (unset_count > 0 && background_key != background)
+        {
+            background = background_key;
+            if (!colors.empty())
+            {
+                colors += ";";
+            }
+            append_color(colors, indexed, false, background_key);
+        }
+        if (!colors.empty())
+        {
+            out += "\033[" + colors + "m";
+        }
+        out += characters[mask];
+    }
+}
+
+std::string Mosaic_Renderer::draw(const uint8_t *pixels,
+                                  uint32_t width,
+                                  uint32_t height,
+                                  bool pixels_are_bgra,
+                                  ChafaCanvasMode mode,
+                                  uint32_t width_cells,
+                                  uint32_t height_cells,
+                                  uint32_t first_row)
+{
+    if (width == 0 || height == 0)
+    {
+        return "";
+    }
+    auto indexed = mode != CHAFA_CANVAS_MODE_TRUECOLOR;
+    rows.resize(height_cells);
+    thread_pool().parallel_for(
+        height_cells,
+        [&](size_t begin, size_t end)
+        {
+            for (auto row = begin; row < end; row++)
+            {
+                auto &out = rows[row];
+                out.clear();
+                out += "\033[" + std::to_string(first_row + row + 1) + ";1H";
+                draw_row(pixels,
+                         width,
+                         height,
+                         pixels_are_bgra,
+                         indexed,
+                         width_cells,
+                         height_cells,
+                         static_cast<uint32_t>(row),
+                         out);
+                out += "\033[m";
+            }
+        },
+        min_rows_per_task);
+
+    size_t length = 0;
+    for (auto &row : rows)
+    {
+        length += row.length();
+    }
+    std::string out;
+    out.reserve(length);
+    for (auto &row : rows)
+    {
+        out += row;
+    }
+    return out;
+}
@@ -20,8 +20,11 @@
     #include "get_fd.h"
     #include "init_draw_state.h"
     #include "draw_desktop.h"
+    #include "update_texture.h"
+    #include "publish_compositor_snapshot.h"
     #include "close_wayland_socket.h"
     #include "get_socket_path_from_name.h"
+    #include "connect_to_wayland_socket.h"
 #endif
 
 #ifdef PLATFORM_MACOS
@@ -47,11 +50,21 @@ Napi::Object Init(Napi::Env env, Napi::Object exports)
     exports["mmap_shm_pool"] = Napi::Function::New(env, mmap_shm_pool_js);
     exports["remap_shm_pool"] = Napi::Function::New(env, remap_shm_pool_js);
     exports["unmmap_shm_pool"] = Napi::Function::New(env, unmmap_shm_pool_js);
+    exports["create_shm_buffer"] = Napi::Function::New(env, create_shm_buffer_js);
+    exports["release_shm_buffer"] = Napi::Function::New(env, release_shm_buffer_js);
     exports["get_fd"] = Napi::Function::New(env, get_fd_js);
     exports["init_draw_state"] = Napi::Function::New(env, init_draw_state_js);
+    exports["take_auto_tune_input"] = Napi::Function::New(env, take_auto_tune_input_js);
+    exports["get_thread_pool_stats"] = Napi::Function::New(env, get_thread_pool_stats_js);
+    exports["update_texture"] = Napi::Function::New(env, update_texture_js);
+    exports["create_texture"] = Napi::Function::New(env, create_texture_js);
+    exports["publish_compositor_snapshot"] = Napi::Function::New(env, publish_compositor_snapshot_js);
     exports["draw_desktop"] = Napi::Function::New(env, draw_desktop_js);
+    exports["write_output_profile"] = Napi::Function::New(env, write_output_profile_js);
+    exports["set_motion_scale"] = Napi::Function::New(env, set_motion_scale_js);
     exports["close_wayland_socket"] = Napi::Function::New(env, close_wayland_socket_js);
     exports["get_socket_path_from_name"] = Napi::Function::New(env, get_socket_path_from_name_js);
+    exports["connect_to_wayland_socket"] = Napi::Function::New(env, connect_to_wayland_socket_js);
 #endif
 
 #ifdef PLATFORM_MACOS
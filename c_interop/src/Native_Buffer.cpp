@@ -0,0 +1,72 @@
+#include "Native_Buffer.h"
+#include "yuv_to_bgra.h"
+
+using namespace Napi;
+
+Native_Buffer::Native_Buffer(std::shared_ptr<const SHM_Mapping> mapping,
+                             uint32_t offset,
+                             int32_t width,
+                             int32_t height,
+                             int32_t stride,
+                             uint32_t format)
+    : mapping(std::move(mapping)),
+      offset(offset),
+      width(width),
+      height(height),
+      stride(stride),
+      format(format)
+{
+}
+
+const uint8_t *Native_Buffer::data() const
+{
+    return static_cast<const uint8_t *>(mapping->addr) + offset;
+}
+
+size_t Native_Buffer::byte_length() const
+{
+    if (is_yuv_format(format))
+    {
+        return yuv_buffer_byte_length(format, stride, height);
+    }
+    return static_cast<size_t>(stride) * height;
+}
+
+bool Native_Buffer::valid() const
+{
+    if (mapping == nullptr || mapping->failed())
+    {
+        return false;
+    }
+    if (width <= 0 || height <= 0 || stride <= 0)
+    {
+        return false;
+    }
+    return static_cast<size_t>(offset) + byte_length() <= mapping->size;
+}
+
+Value native_buffer_to_js(Env env, Native_Buffer_Ref buffer)
+{
+    return External<Native_Buffer_Ref>::New(
+        env, new Native_Buffer_Ref(std::move(buffer)),
+        [](Env env, Native_Buffer_Ref *data)
+        { delete data; });
+}
+
+Native_Buffer_Ref native_buffer_from_js(const Value &value)
+{
+    if (!value.IsExternal())
+    {
+        return nullptr;
+    }
+    return *value.As<External<Native_Buffer_Ref>>().Data();
+}
+
+void release_native_buffer_js_handle(const Value &value)
+{
+    if (!value.IsExternal())
+    {
+        return;
+    }
+    value.As<External<Native_Buffer_Ref>>().Data()->reset();
+}
@@ -0,0 +1,88 @@
+#include "Native_Texture.h"
+#include "parallel_copy.h"
+#include "yuv_to_bgra.h"
+
+#include <atomic>
+
+using namespace Napi;
+
+/**
+ * @brief From the wayland protocol, wl_shm_format
+ */
+constexpr uint32_t wl_shm_format_xrgb8888 = 1;
+
+static uint64_t next_texture_version()
+{
+    static std::atomic<uint64_t> last_version{0};
+    return last_version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+Native_Texture::Native_Texture(uint32_t width, uint32_t height)
+    : width(width),
+      height(height),
+      pixels(static_cast<size_t>(width) * height * 4),
+      version(next_texture_version())
+{
+}
+
+bool Native_Texture::copy_from(const Native_Buffer &buffer)
+{
+    if (!buffer.valid() ||
+        static_cast<uint32_t>(buffer.width) != width ||
+        static_cast<uint32_t>(buffer.height) != height)
+    {
+        return false;
+    }
+    if (is_yuv_format(buffer.format))
+    {
+        if (static_cast<size_t>(buffer.stride) < yuv_min_stride(buffer.format, width))
+        {
+            return false;
+        }
+        /**
+         * Video has no alpha, and converting here keeps
+         * everything after this BGRA
+         */
+        opaque = true;
+        yuv_to_bgra(buffer.format, buffer.data(), buffer.stride, width, height, pixels.data());
+        version = next_texture_version();
+        return true;
+    }
+    if (static_cast<uint32_t>(buffer.stride) < width * 4)
+    {
+        return false;
+    }
+    /**
+     * argb8888 and xrgb8888 are the formats every compositor
+     * has to support, anything else is copied as is.
+     */
+    opaque = buffer.format == wl_shm_format_xrgb8888;
+
+    auto row_bytes = static_cast<size_t>(width) * 4;
+    copy_rows(pixels.data(),
+              row_bytes,
+              buffer.data(),
+              buffer.stride,
+              row_bytes,
+              height,
+              opaque ? Pixel_Conversion::force_opaque : Pixel_Conversion::none);
+    version = next_texture_version();
+    return true;
+}
+
+Value native_texture_to_js(Env env, std::shared_ptr<Native_Texture> texture)
+{
+    return External<Native_Texture_Handle>::New(
+        env, new Native_Texture_Handle{std::move(texture), nullptr},
+        [](Env env, Native_Texture_Handle *data)
+        { delete data; });
+}
+
+Native_Texture_Handle *native_texture_from_js(const Value &value)
+{
+    if (!value.IsExternal())
+    {
+        return nullptr;
+    }
+    return value.As<External<Native_Texture_Handle>>().Data();
+}
@@ -0,0 +1,238 @@
+#include "Output_Profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+static const char *category_names[output_category_count] = {
+    "status_line",
+    "glyph",
+    "sgr",
+    "cursor",
+    "erase",
+    "image",
+    "control",
+    "other",
+};
+
+constexpr char escape = '\033';
+
+Output_Profiler::Output_Profiler(const std::string &path) : path(path)
+{
+    auto frames_path = path + ".frames.csv";
+    frames_file = fopen(frames_path.c_str(), "w");
+    if (frames_file == nullptr)
+    {
+        perror(("Could not open output profile " + frames_path).c_str());
+        return;
+    }
+    fprintf(frames_file, "frame,total");
+    for (auto name : category_names)
+    {
+        fprintf(frames_file, ",%s", name);
+    }
+    fprintf(frames_file, "\n");
+}
+
+Output_Profiler::~Output_Profiler()
+{
+    if (frames_file != nullptr)
+    {
+        fclose(frames_file);
+    }
+}
+
+/**
+ * @return the index one past the end of the string sequence starting
+ * at start (ESC P, ESC _, ESC ], ...), ended by ST or BEL. Escapes
+ * doubled for tmux passthrough are part of the string.
+ */
+static size_t end_of_string_sequence(const char *data, size_t length, size_t start)
+{
+    for (auto i = start + 2; i < length; i++)
+    {
+        if (data[i] == '\a')
+        {
+            return i + 1;
+        }
+        if (data[i] == escape && i + 1 < length)
+        {
+            if (data[i + 1] == escape)
+            {
+                i++;
+                continue;
+            }
+            if (data[i + 1] == '\\')
+            {
+                return i + 2;
+            }
+        }
+    }
+    return length;
+}
+
+static Output_Category category_of_csi(char final_byte)
+{
+    switch (final_byte)
+    {
+    case 'm':
+        return Output_Category::sgr;
+    case 'A':
+    case 'B':
+    case 'C':
+    case 'D':
+    case 'E':
+    case 'F':
+    case 'G':
+    case 'H':
+    case 'd':
+    case 'f':
+        return Output_Category::cursor;
+    case 'J':
+    case 'K':
+    case 'X':
+        return Output_Category::erase;
+    default:
+        return Output_Category::other;
+    }
+}
+
+void Output_Profiler::classify(const char *data,
+                               size_t length,
+                               std::array<Output_Category_Stats, output_category_count> &frame)
+{
+    auto add = [&](Output_Category category, size_t bytes)
+    {
+        auto &stats = frame[static_cast<size_t>(category)];
+        stats.bytes += bytes;
+        stats.sequences++;
+    };
+
+    size_t i = 0;
+    while (i < length)
+    {
+        auto byte = static_cast<unsigned char>(data[i]);
+        if (byte != static_cast<unsigned char>(escape))
+        {
+            /**
+             * A run of text, or a run of control characters
+             */
+            auto is_text = byte >= 0x20 && byte != 0x7f;
+            auto start = i;
+            while (i < length && data[i] != escape)
+            {
+                auto b = static_cast<unsigned char>(data[i]);
+                if ((b >= 0x20 && b != 0x7f) != is_text)
+                {
+                    break;
+                }
+                i++;
+            }
+            add(is_text ? Output_Category::glyph : Output_Category::control, i - start);
+            continue;
+        }
+        if (i + 1 >= length)
+        {
+            add(Output_Category::other, 1);
+            i++;
+            continue;
+        }
+        auto kind = data[i + 1];
+        if (kind == '[')
+        {
+            auto end = i + 2;
+            while (end < length && !(data[end] >= 0x40 && data[end] <= 0x7e))
+            {
+                end++;
+            }
+            auto final_byte = end < length ? data[end] : '\0';
+            end = std::min(end + 1, length);
+            add(category_of_csi(final_byte), end - i);
+            i = end;
+            continue;
+        }
+        if (kind == 'P' || kind == '_' || kind == ']' || kind == '^' || kind == 'X')
+        {
+            auto end = end_of_string_sequence(data, length, i);
+            /**
+             * Sixels and tmux passthrough are DCS, kitty is APC,
+             * iTerm is OSC 1337. Other OSCs are titles and such.
+             */
+            auto is_image = kind == 'P' || kind == '_' ||
+                            (kind == ']' && std::string(data + i + 2, std::min<size_t>(5, end - i - 2)) == "1337;");
+            add(is_image ? Output_Category::image : Output_Category::other, end - i);
+            i = end;
+            continue;
+        }
+        add(Output_Category::other, 2);
+        i += 2;
+    }
+}
+
+void Output_Profiler::profile_frame(const std::string &output, size_t status_line_bytes)
+{
+    std::array<Output_Category_Stats, output_category_count> frame = {};
+    status_line_bytes = std::min(status_line_bytes, output.length());
+    if (status_line_bytes > 0)
+    {
+        auto &stats = frame[static_cast<size_t>(Output_Category::status_line)];
+        stats.bytes = status_line_bytes;
+        stats.sequences = 1;
+    }
+    classify(output.c_str() + status_line_bytes, output.length() - status_line_bytes, frame);
+
+    frames++;
+    for (size_t c = 0; c < output_category_count; c++)
+    {
+        totals[c].bytes += frame[c].bytes;
+        totals[c].sequences += frame[c].sequences;
+        totals[c].max_bytes_in_a_frame = std::max(totals[c].max_bytes_in_a_frame, frame[c].bytes);
+    }
+
+    if (frames_file == nullptr)
+    {
+        return;
+    }
+    fprintf(frames_file, "%llu,%zu", static_cast<unsigned long long>(frames), output.length());
+    for (auto &stats : frame)
+    {
+        fprintf(frames_file, ",%llu", static_cast<unsigned long long>(stats.bytes));
+    }
+    fprintf(frames_file, "\n");
+}
+
+void Output_Profiler::write_report()
+{
+    if (frames_file != nullptr)
+    {
+        fflush(frames_file);
+    }
+    auto file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        perror(("Could not write output profile " + path).c_str());
+        return;
+    }
+    uint64_t total = 0;
+    for (auto &stats : totals)
+    {
+        total += stats.bytes;
+    }
+    fprintf(file, "%llu frames, %llu bytes, %.0f bytes per frame\n\n",
+            static_cast<unsigned long long>(frames),
+            static_cast<unsigned long long>(total),
+            frames == 0 ? 0.0 : static_cast<double>(total) / frames);
+    fprintf(file, "%-12s %14s %7s %14s %14s %12s\n",
+            "category", "bytes", "%", "per frame", "max in frame", "sequences");
+    for (size_t c = 0; c < output_category_count; c++)
+    {
+        auto &stats = totals[c];
+        fprintf(file, "%-12s %14llu %6.1f%% %14.0f %14llu %12llu\n",
+                category_names[c],
+                static_cast<unsigned long long>(stats.bytes),
+                total == 0 ? 0.0 : 100.0 * stats.bytes / total,
+                frames == 0 ? 0.0 : static_cast<double>(stats.bytes) / frames,
+                static_cast<unsigned long long>(stats.max_bytes_in_a_frame),
+                static_cast<unsigned long long>(stats.sequences));
+    }
+    fclose(file);
+}
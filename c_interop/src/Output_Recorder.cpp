@@ -0,0 +1,54 @@
+#include "Output_Recorder.h"
+
+#include <iostream>
+
+Output_Recorder::Output_Recorder(const std::string &path)
+{
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        perror(("Could not open output recording " + path).c_str());
+    }
+}
+
+Output_Recorder::~Output_Recorder()
+{
+    if (file != nullptr)
+    {
+        fclose(file);
+    }
+}
+
+void Output_Recorder::write_record(char tag, const char *data, uint32_t length)
+{
+    uint8_t header[5] = {
+        static_cast<uint8_t>(tag),
+        static_cast<uint8_t>(length & 0xff),
+        static_cast<uint8_t>((length >> 8) & 0xff),
+        static_cast<uint8_t>((length >> 16) & 0xff),
+        static_cast<uint8_t>((length >> 24) & 0xff),
+    };
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(data, 1, length, file);
+}
+
+void Output_Recorder::record_frame(uint32_t columns,
+                                   uint32_t rows,
+                                   const std::string &reference,
+                                   const std::string &emitted)
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+    uint8_t size[8];
+    for (auto i = 0; i < 4; i++)
+    {
+        size[i] = (columns >> (8 * i)) & 0xff;
+        size[4 + i] = (rows >> (8 * i)) & 0xff;
+    }
+    write_record('S', reinterpret_cast<const char *>(size), sizeof(size));
+    write_record('R', reference.c_str(), reference.length());
+    write_record('E', emitted.c_str(), emitted.length());
+    fflush(file);
+}
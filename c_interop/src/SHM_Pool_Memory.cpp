@@ -19,53 +19,70 @@ static void *mmap_fd(int fd, size_t size)
     return addr;
 }
 
-bool SHM_Pool_Memory::destroyed()
+SHM_Mapping::SHM_Mapping(int fd, size_t size)
+{
+    this->addr = mmap_fd(fd, size);
+    this->size = size;
+}
+
+bool SHM_Mapping::failed() const
 {
     return addr == MAP_FAILED;
 }
 
+SHM_Mapping::~SHM_Mapping()
+{
+    if (addr != MAP_FAILED)
+    {
+        munmap(addr, size);
+    }
+}
+
+bool SHM_Pool_Memory::destroyed()
+{
+    return mapping == nullptr || mapping->failed();
+}
+
 SHM_Pool_Memory::SHM_Pool_Memory(int fd, size_t size)
 {
     this->file_descriptor = fd;
-    this->addr = mmap_fd(fd, size);
-    this->size = size;
+    this->mapping = std::make_shared<const SHM_Mapping>(fd, size);
 }
 
 bool SHM_Pool_Memory::remap(size_t new_size)
 {
-    if (new_size == size)
-    {
-        return true;
-    }
-    if (addr == MAP_FAILED)
+    if (destroyed())
     {
         return false;
     }
-    if (munmap(addr, size) == -1)
+    if (new_size == mapping->size)
     {
-        perror("munmap in remap");
-        this->addr = MAP_FAILED;
-        return false;
+        return true;
     }
-    addr = mmap_fd(file_descriptor, new_size);
-    if (addr == MAP_FAILED)
+    /**
+     * Map the new size next to the old one instead of
+     * unmapping first, buffers still reading from the
+     * old mapping keep it until they are released.
+     */
+    auto new_mapping = std::make_shared<const SHM_Mapping>(file_descriptor, new_size);
+    if (new_mapping->failed())
     {
         perror("mmap in remap");
         return false;
     }
-    size = new_size;
+    mapping = new_mapping;
     return true;
 }
 
 SHM_Pool_Memory::~SHM_Pool_Memory()
 {
-
-    if (addr != MAP_FAILED)
-    {
-        munmap(addr, size);
-    }
+    /**
+     * The mapping is unmapped when the last
+     * buffer that uses it is released
+     */
+    mapping = nullptr;
     if (file_descriptor != -1)
     {
         close(file_descriptor);
     }
-}
\ No newline at end of file
+}
@@ -1,9 +1,16 @@
 #include "Send_Message_And_File_Descriptors.h"
 
+#include <cerrno>
+#include <poll.h>
 #include <sys/socket.h>
 
 using namespace Napi;
 
+/**
+ * @brief How long a send waits for a full socket to be writable
+ */
+constexpr int socket_writable_wait_ms = 100;
+
 /**
  * @brief
  *
@@ -13,7 +20,9 @@ using namespace Napi;
  * @param fds
  * @param num_fds
  * @param bytes_written
- * @return true if we should continue to send to this socket
+ * @return true if we should continue to send to this socket. If the
+ * socket stayed full (or we were interrupted) this is true with 0
+ * bytes_written, try again.
  * @return false if this socket has closed
  */
 bool send_message_and_file_descriptors(
@@ -36,27 +45,46 @@ bool send_message_and_file_descriptors(
     // Set up the msghdr structure
     msg.msg_iov = &iov;
     msg.msg_iovlen = 1;
-    msg.msg_control = cmsgbuf;
-    msg.msg_controllen = sizeof(cmsgbuf);
-
-    // Set up the control message header
-    cmsg = CMSG_FIRSTHDR(&msg);
-    cmsg->cmsg_level = SOL_SOCKET;
-    cmsg->cmsg_type = SCM_RIGHTS;
-    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
-    // if (num_fds > 0)
-    // {
-    //     printf("Going to sends fds %d\n", fds[0]);
-    // }
-
-    // Copy the file descriptors into the control message
-    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * num_fds);
-
-    // Send the message
-    ssize_t n = sendmsg(clientSocket, &msg, 0);
+    if (num_fds > 0)
+    {
+        msg.msg_control = cmsgbuf;
+        msg.msg_controllen = sizeof(cmsgbuf);
+
+        // Set up the control message header
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+
+        // Copy the file descriptors into the control message
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * num_fds);
+    }
+
+    /**
+     * If the socket is full, wait for the client to read, but only
+     * so long: a client that isn't reading shouldn't hold on to
+     * a worker thread. The caller will try again.
+     */
+    ssize_t n = sendmsg(clientSocket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        struct pollfd poll_fd = {clientSocket, POLLOUT, 0};
+        if (poll(&poll_fd, 1, socket_writable_wait_ms) > 0)
+        {
+            n = sendmsg(clientSocket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+        else
+        {
+            errno = EAGAIN;
+        }
+    }
     if (n == -1)
     {
         *bytes_written = 0;
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            return true;
+        }
         // if (errno == EPIPE)
         // {
         //     return false;
@@ -116,7 +144,7 @@ Value send_message_and_file_descriptors_js(const CallbackInfo &info)
 
     auto file_descriptor_buffer = info[2].As<TypedArray>();
 
-    auto file_descriptor_buffer_with_offset = (int *)(((uint8_t *)file_descriptor_buffer.ArrayBuffer().Data()) + buffer.ByteOffset());
+    auto file_descriptor_buffer_with_offset = (int *)(((uint8_t *)file_descriptor_buffer.ArrayBuffer().Data()) + file_descriptor_buffer.ByteOffset());
 
     auto callback = info[3].As<Function>();
 
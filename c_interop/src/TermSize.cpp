@@ -1,5 +1,6 @@
 #include "TermSize.h"
 
+#include <cstdlib> /* getenv, atoi */
 #include <sys/ioctl.h> /* ioctl */
 #include <unistd.h> /* STDOUT_FILENO, STDERR_FILENO, STDIN_FILENO */
 
@@ -10,7 +11,21 @@ TermSize::TermSize()
 
     struct winsize w;
 
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) >= 0 || ioctl(STDERR_FILENO, TIOCGWINSZ, &w) >= 0 || ioctl(STDIN_FILENO, TIOCGWINSZ, &w) >= 0)
+    /**
+     * When stdout is not the terminal, like under scripts/slow-link
+     * with --vt, stdin and stderr can still be the developer's real
+     * terminal, which is not the size we draw for. The shell
+     * convention for the size wins over them then.
+     */
+    auto columns = getenv("COLUMNS");
+    auto lines = getenv("LINES");
+    auto stdout_is_a_tty = isatty(STDOUT_FILENO);
+    if (!stdout_is_a_tty && columns != nullptr && lines != nullptr)
+    {
+        width_cells = atoi(columns);
+        height_cells = atoi(lines);
+    }
+    else if ((stdout_is_a_tty && ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) >= 0) || ioctl(STDERR_FILENO, TIOCGWINSZ, &w) >= 0 || ioctl(STDIN_FILENO, TIOCGWINSZ, &w) >= 0)
     {
         width_cells = w.ws_col;
         height_cells = w.ws_row;
@@ -0,0 +1,311 @@
+#include "Thread_Pool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Which queue of which pool the current thread works on,
+ * so tasks submitted by a task go to the submitting worker
+ */
+static thread_local const Thread_Pool *current_pool = nullptr;
+static thread_local size_t current_worker = SIZE_MAX;
+
+/**
+ * @brief More drawing threads than this per core only adds
+ * switching, the same limit as --threads
+ */
+constexpr uint32_t max_threads_per_core = 4;
+
+uint32_t Task_Group::expired() const
+{
+    return expired_count.load();
+}
+
+Thread_Pool::Thread_Pool(uint32_t drawing_threads)
+{
+    if (drawing_threads == 0)
+    {
+        drawing_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto workers = drawing_threads - 1;
+    last_stats_time = std::chrono::steady_clock::now();
+    /**
+     * With no workers, whoever waits runs everything
+     * from the one queue
+     */
+    for (uint32_t i = 0; i < std::max(1u, workers); i++)
+    {
+        queues.push_back(std::make_unique<Worker_Queue>());
+    }
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        threads.emplace_back([this, i]
+                             { worker_loop(i); });
+    }
+}
+
+Thread_Pool::~Thread_Pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake_up.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t Thread_Pool::thread_count() const
+{
+    return static_cast<uint32_t>(threads.size());
+}
+
+void Thread_Pool::push(Task task, Task_Priority priority)
+{
+    auto index = current_pool == this
+                     ? current_worker
+                     : next_queue.fetch_add(1) % queues.size();
+    /**
+     * Counted before it is in the queue, so
+     * taking it can't make queued go below 0
+     */
+    queued.fetch_add(1);
+    {
+        auto &queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+    /**
+     * Taking the lock orders this with a worker
+     * checking queued right before it sleeps
+     */
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake_up.notify_one();
+}
+
+void Thread_Pool::submit(Task_Group &group,
+                         std::function<void()> task,
+                         Task_Priority priority)
+{
+    group.pending.fetch_add(1);
+    push({std::move(task), &group, group.deadline}, priority);
+}
+
+void Thread_Pool::submit_detached(std::function<void()> task,
+                                  Task_Priority priority,
+                                  Deadline deadline)
+{
+    push({std::move(task), nullptr, deadline}, priority);
+}
+
+bool Thread_Pool::take(size_t home_queue, Task *task_out)
+{
+    if (queued.load() == 0)
+    {
+        return false;
+    }
+    auto queue_count = queues.size();
+    for (size_t priority = 0; priority < task_priority_count; priority++)
+    {
+        /**
+         * Newest from our own queue, it's likely still in cache
+         */
+        if (home_queue < queue_count)
+        {
+            auto &queue = *queues[home_queue];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto &tasks = queue.tasks[priority];
+            if (!tasks.empty())
+            {
+                *task_out = std::move(tasks.back());
+                tasks.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        /**
+         * Oldest from everyone else
+         */
+        auto start = home_queue < queue_count ? home_queue + 1 : 0;
+        for (size_t i = 0; i < queue_count; i++)
+        {
+            auto index = (start + i) % queue_count;
+            if (index == home_queue)
+            {
+                continue;
+            }
+            auto &queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto &tasks = queue.tasks[priority];
+            if (!tasks.empty())
+            {
+                *task_out = std::move(tasks.front());
+                tasks.pop_front();
+                queued.fetch_sub(1);
+                if (home_queue < queue_count)
+                {
+                    tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Thread_Pool::run(Task &task)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (start > task.deadline)
+    {
+        tasks_expired.fetch_add(1, std::memory_order_relaxed);
+        if (task.group != nullptr)
+        {
+            task.group->expired_count.fetch_add(1);
+        }
+    }
+    else
+    {
+        task.run();
+        tasks_run.fetch_add(1, std::memory_order_relaxed);
+        auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        busy_nanoseconds.fetch_add(busy.count(), std::memory_order_relaxed);
+    }
+    /**
+     * The group can be gone as soon as pending is 0,
+     * only the pool is touched after
+     */
+    if (task.group != nullptr &&
+        task.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        wake_up.notify_all();
+    }
+}
+
+void Thread_Pool::worker_loop(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+    while (true)
+    {
+        Task task;
+        if (take(index, &task))
+        {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_up.wait(lock, [this]
+                     { return queued.load() > 0 || stopping.load(); });
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+void Thread_Pool::wait(Task_Group &group)
+{
+    auto home = current_pool == this ? current_worker : SIZE_MAX;
+    while (group.pending.load(std::memory_order_acquire) > 0)
+    {
+        Task task;
+        if (take(home, &task))
+        {
+            tasks_run_while_waiting.fetch_add(1, std::memory_order_relaxed);
+            run(task);
+            continue;
+        }
+        /**
+         * The rest is running on other threads. Wakes up for the
+         * group finishing, or for more tasks to help with, the
+         * last task of a group notifies under the same lock.
+         */
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_up.wait(lock, [&]
+                     { return group.pending.load(std::memory_order_acquire) == 0 || queued.load() > 0; });
+    }
+}
+
+bool Thread_Pool::parallel_for(size_t count,
+                               const std::function<void(size_t begin, size_t end)> &body,
+                               size_t min_per_task,
+                               Deadline deadline)
+{
+    if (count == 0)
+    {
+        return true;
+    }
+    min_per_task = std::max<size_t>(min_per_task, 1);
+    auto tasks = std::min<size_t>(thread_count() + 1, (count + min_per_task - 1) / min_per_task);
+    if (tasks <= 1)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            tasks_expired.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        body(0, count);
+        return true;
+    }
+    Task_Group group;
+    group.deadline = deadline;
+    auto per_task = (count + tasks - 1) / tasks;
+    for (size_t begin = 0; begin < count; begin += per_task)
+    {
+        auto end = std::min(begin + per_task, count);
+        submit(group, [&body, begin, end]
+               { body(begin, end); });
+    }
+    wait(group);
+    return group.expired() == 0;
+}
+
+Thread_Pool_Stats Thread_Pool::stats()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto busy = busy_nanoseconds.load();
+    auto elapsed = std::chrono::duration<double>(now - last_stats_time).count();
+    auto busy_seconds = (busy - last_stats_busy_nanoseconds) / 1e9;
+    last_stats_time = now;
+    last_stats_busy_nanoseconds = busy;
+
+    Thread_Pool_Stats out;
+    out.threads = thread_count();
+    out.tasks_run = tasks_run.load();
+    out.tasks_stolen = tasks_stolen.load();
+    out.tasks_expired = tasks_expired.load();
+    out.tasks_run_while_waiting = tasks_run_while_waiting.load();
+    out.queued = queued.load();
+    out.utilization = elapsed <= 0 || out.threads == 0 ? 0 : std::min(1.0, busy_seconds / (elapsed * out.threads));
+    return out;
+}
+
+static std::atomic<uint32_t> configured_threads{0};
+
+void configure_thread_pool(uint32_t threads)
+{
+    /**
+     * The command line is checked too, but a bad count
+     * here would start billions of threads
+     */
+    auto max_threads = std::max(1u, std::thread::hardware_concurrency()) * max_threads_per_core;
+    configured_threads = std::min(threads, max_threads);
+}
+
+Thread_Pool &thread_pool()
+{
+    /**
+     * Never destroyed, the workers just go away with the process.
+     * Joining them at exit could wait on a task that is
+     * half way through a frame.
+     */
+    static auto pool = new Thread_Pool(configured_threads.load());
+    return *pool;
+}
@@ -0,0 +1,148 @@
+#include "Tiled_Framebuffer.h"
+#include "Thread_Pool.h"
+
+#include <cstring>
+
+/**
+ * @brief What every background tile hashes to
+ */
+constexpr uint64_t background_hash = 0;
+
+/**
+ * @brief 8 bytes at a time, tiles are 256 byte rows so
+ * there is never a remainder
+ */
+static uint64_t hash_tile(const uint8_t *pixels, size_t length)
+{
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, pixels + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    /**
+     * Never collide with background
+     */
+    return hash == background_hash ? 1 : hash;
+}
+
+uint32_t Tiled_Framebuffer::tile_width(uint32_t tile_x) const
+{
+    return std::min(tile_size, width - tile_x * tile_size);
+}
+
+uint32_t Tiled_Framebuffer::tile_height(uint32_t tile_y) const
+{
+    return std::min(tile_size, height - tile_y * tile_size);
+}
+
+void Tiled_Framebuffer::resize(uint32_t new_width, uint32_t new_height)
+{
+    width = new_width;
+    height = new_height;
+    tiles_x = (width + tile_size - 1) / tile_size;
+    tiles_y = (height + tile_size - 1) / tile_size;
+    tiles.clear();
+    tiles.resize(static_cast<size_t>(tiles_x) * tiles_y);
+}
+
+size_t Tiled_Framebuffer::compose(const Compositor_Snapshot &snapshot)
+{
+    auto resized = snapshot.width != width || snapshot.height != height;
+    if (resized)
+    {
+        resize(snapshot.width, snapshot.height);
+    }
+
+    std::atomic<size_t> changed_count{0};
+    thread_pool().parallel_for(tiles.size(), [&](size_t begin, size_t end)
+                               {
+        for (auto i = begin; i < end; i++)
+        {
+            auto &tile = tiles[i];
+            auto tile_x = static_cast<uint32_t>(i % tiles_x);
+            auto tile_y = static_cast<uint32_t>(i / tiles_x);
+            int64_t x = static_cast<int64_t>(tile_x) * tile_size;
+            int64_t y = static_cast<int64_t>(tile_y) * tile_size;
+            auto w = tile_width(tile_x);
+            auto h = tile_height(tile_y);
+
+            auto signature = snapshot.region_signature(x, y, w, h);
+            if (!resized && signature == tile.signature)
+            {
+                tile.changed = false;
+                continue;
+            }
+            tile.signature = signature;
+
+            auto previous_hash = tile.hash;
+            if (signature == 0)
+            {
+                tile.pixels = nullptr;
+                tile.hash = background_hash;
+            }
+            else
+            {
+                if (tile.pixels == nullptr)
+                {
+                    tile.pixels = std::make_unique<uint8_t[]>(tile_size * tile_size * 4);
+                }
+                /**
+                 * Edge tiles keep the full stride, so hashing
+                 * always reads whole rows of whole tiles
+                 */
+                snapshot.compose_region(tile.pixels.get(), tile_size * 4, x, y, w, h);
+                tile.hash = hash_tile(tile.pixels.get(), static_cast<size_t>(tile_size) * h * 4);
+            }
+            tile.changed = resized || tile.hash != previous_hash;
+            if (tile.changed)
+            {
+                changed_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        } }, 16);
+    return changed_count.load();
+}
+
+void Tiled_Framebuffer::copy_changed_to(uint8_t *out) const
+{
+    auto out_stride = static_cast<size_t>(width) * 4;
+    thread_pool().parallel_for(tiles.size(), [&](size_t begin, size_t end)
+                               {
+        for (auto i = begin; i < end; i++)
+        {
+            auto &tile = tiles[i];
+            if (!tile.changed)
+            {
+                continue;
+            }
+            auto tile_x = static_cast<uint32_t>(i % tiles_x);
+            auto tile_y = static_cast<uint32_t>(i / tiles_x);
+            auto w = tile_width(tile_x);
+            auto h = tile_height(tile_y);
+            auto destination = out + static_cast<size_t>(tile_y) * tile_size * out_stride + static_cast<size_t>(tile_x) * tile_size * 4;
+            for (uint32_t row = 0; row < h; row++)
+            {
+                if (tile.pixels == nullptr)
+                {
+                    memset(destination + row * out_stride, 0, w * 4);
+                    continue;
+                }
+                memcpy(destination + row * out_stride, tile.pixels.get() + row * tile_size * 4, w * 4);
+            }
+        } }, 16);
+}
+
+size_t Tiled_Framebuffer::allocated_tiles() const
+{
+    size_t count = 0;
+    for (auto &tile : tiles)
+    {
+        if (tile.pixels != nullptr)
+        {
+            count++;
+        }
+    }
+    return count;
+}
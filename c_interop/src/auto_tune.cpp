@@ -0,0 +1,324 @@
+#include "auto_tune.h"
+#include "ChafaInfo.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @brief Device Status Report, the terminal replies with "\033[0n"
+ */
+constexpr auto device_status_report = "\033[5n";
+constexpr auto device_status_ok = "\033[0n";
+/**
+ * @brief SGR reset does nothing visible, but the terminal
+ * still has to receive and parse it.
+ */
+constexpr auto invisible_payload_unit = "\033[m";
+constexpr size_t drain_payload_size = 128 * 1024;
+constexpr double status_report_timeout_seconds = 2.0;
+
+/**
+ * @brief Best quality first
+ */
+static const Auto_Tune_Settings candidates[] = {
+    {CHAFA_SYMBOL_TAG_ALL, 0.5},
+    {CHAFA_SYMBOL_TAG_ALL, 0.0},
+    {static_cast<ChafaSymbolTags>(CHAFA_SYMBOL_TAG_BLOCK | CHAFA_SYMBOL_TAG_BORDER | CHAFA_SYMBOL_TAG_SPACE), 0.0},
+    {static_cast<ChafaSymbolTags>(CHAFA_SYMBOL_TAG_BLOCK | CHAFA_SYMBOL_TAG_SPACE), 0.0},
+    {static_cast<ChafaSymbolTags>(CHAFA_SYMBOL_TAG_HALF | CHAFA_SYMBOL_TAG_SPACE), 0.0},
+};
+
+static double now_seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool write_all(int fd, const std::string &data)
+{
+    size_t written = 0;
+    while (written < data.length())
+    {
+        auto n = write(fd, data.c_str() + written, data.length() - written);
+        if (n < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            perror("write in measure_link_drain_rate");
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+/**
+ * @param input_out gets everything read that isn't the reply,
+ * keys pressed while we were waiting
+ */
+static bool wait_for_status_report(std::string &input_out)
+{
+    std::string received;
+    auto deadline = now_seconds() + status_report_timeout_seconds;
+    while (received.find(device_status_ok) == std::string::npos)
+    {
+        auto remaining_ms = static_cast<int>((deadline - now_seconds()) * 1000);
+        if (remaining_ms <= 0)
+        {
+            input_out += received;
+            return false;
+        }
+        struct pollfd poll_fd = {STDIN_FILENO, POLLIN, 0};
+        auto ret = poll(&poll_fd, 1, remaining_ms);
+        if (ret < 0 && errno != EINTR)
+        {
+            perror("poll in measure_link_drain_rate");
+            input_out += received;
+            return false;
+        }
+        if (ret <= 0)
+        {
+            continue;
+        }
+        char buffer[64];
+        auto n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            received.append(buffer, n);
+        }
+    }
+    auto reply = received.find(device_status_ok);
+    input_out += received.erase(reply, std::char_traits<char>::length(device_status_ok));
+    return true;
+}
+
+/**
+ * @return seconds until the terminal answered, or -1 on failure
+ */
+static double time_status_report_round_trip(const std::string &payload, std::string &input_out)
+{
+    auto start = now_seconds();
+    if (!write_all(STDOUT_FILENO, payload + device_status_report))
+    {
+        return -1;
+    }
+    if (!wait_for_status_report(input_out))
+    {
+        return -1;
+    }
+    return now_seconds() - start;
+}
+
+double measure_link_drain_rate(std::string &input_out)
+{
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+    {
+        return -1;
+    }
+    struct termios original;
+    if (tcgetattr(STDIN_FILENO, &original) == -1)
+    {
+        perror("tcgetattr in measure_link_drain_rate");
+        return -1;
+    }
+    auto raw = original;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    std::string payload;
+    payload.reserve(drain_payload_size + 8);
+    while (payload.length() < drain_payload_size)
+    {
+        payload += invisible_payload_unit;
+    }
+
+    auto round_trip = time_status_report_round_trip("", input_out);
+    auto round_trip_with_payload = round_trip < 0 ? -1 : time_status_report_round_trip(payload, input_out);
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &original);
+
+    if (round_trip < 0 || round_trip_with_payload < 0)
+    {
+        std::cerr << "auto tune: terminal did not answer the status report, can't measure the link" << std::endl;
+        return -1;
+    }
+    /**
+     * Anything faster than this is fast enough that
+     * it doesn't matter, and is within the noise.
+     */
+    auto drain_time = std::max(round_trip_with_payload - round_trip, 0.0005);
+    return payload.length() / drain_time;
+}
+
+std::string auto_tune_cache_key()
+{
+    char hostname[256] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+
+    auto get = [](const char *name)
+    {
+        auto value = std::getenv(name);
+        return std::string(value == nullptr ? "" : value);
+    };
+    /**
+     * Different ssh clients have different links to us,
+     * so the client address is part of the key
+     */
+    auto ssh_client = get("SSH_CLIENT");
+    ssh_client = ssh_client.substr(0, ssh_client.find(' '));
+
+    std::stringstream key;
+    key << hostname << "|" << get("TERM") << "|" << get("TERM_PROGRAM") << "|" << ssh_client;
+    return key.str();
+}
+
+static std::string auto_tune_cache_directory()
+{
+    auto cache_home = std::getenv("XDG_CACHE_HOME");
+    if (cache_home != nullptr && cache_home[0] != '\0')
+    {
+        return std::string(cache_home) + "/term.everything";
+    }
+    auto home = std::getenv("HOME");
+    if (home == nullptr)
+    {
+        return "";
+    }
+    return std::string(home) + "/.cache/term.everything";
+}
+
+bool load_auto_tune_settings(const std::string &key, Auto_Tune_Settings *settings_out)
+{
+    auto directory = auto_tune_cache_directory();
+    if (directory.empty())
+    {
+        return false;
+    }
+    std::ifstream file(directory + "/auto_tune");
+    std::string line;
+    auto found = false;
+    /**
+     * Later lines win, so keep reading after a match
+     */
+    while (std::getline(file, line))
+    {
+        auto tab = line.rfind('\t');
+        if (tab == std::string::npos)
+        {
+            continue;
+        }
+        auto tab_before = line.rfind('\t', tab - 1);
+        if (tab_before == std::string::npos || line.compare(0, tab_before, key) != 0 || tab_before != key.length())
+        {
+            continue;
+        }
+        settings_out->symbol_tags = static_cast<ChafaSymbolTags>(std::strtol(line.c_str() + tab_before + 1, nullptr, 10));
+        settings_out->work_factor = std::strtof(line.c_str() + tab + 1, nullptr);
+        found = true;
+    }
+    return found;
+}
+
+void save_auto_tune_settings(const std::string &key, const Auto_Tune_Settings &settings)
+{
+    auto directory = auto_tune_cache_directory();
+    if (directory.empty())
+    {
+        return;
+    }
+    auto parent = directory.substr(0, directory.rfind('/'));
+    mkdir(parent.c_str(), 0700);
+    mkdir(directory.c_str(), 0700);
+
+    std::ofstream file(directory + "/auto_tune", std::ios::app);
+    if (!file)
+    {
+        std::cerr << "auto tune: could not write the cache in " << directory << std::endl;
+        return;
+    }
+    file << key << "\t" << static_cast<long>(settings.symbol_tags) << "\t" << settings.work_factor << "\n";
+}
+
+/**
+ * @brief Something that looks a bit like a desktop: a gradient
+ * background with a few flat windows that have text-like detail in them.
+ * Flat colors alone would make every symbol set look equally cheap.
+ */
+static std::vector<uint8_t> make_synthetic_frame(uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 12345;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            auto pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            auto in_window = (x > width / 8 && x < width * 5 / 8 && y > height / 8 && y < height * 7 / 8) ||
+                             (x > width / 2 && x < width * 7 / 8 && y > height / 3 && y < height * 2 / 3);
+            seed = seed * 1103515245 + 12345;
+            auto text_like = in_window && (y / 4) % 3 == 0 && (seed >> 16) % 3 == 0;
+            pixel[0] = in_window ? (text_like ? 30 : 235) : static_cast<uint8_t>(x * 255 / width);
+            pixel[1] = in_window ? (text_like ? 30 : 235) : static_cast<uint8_t>(y * 255 / height);
+            pixel[2] = in_window ? (text_like ? 30 : 240) : 128;
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+Auto_Tune_Settings auto_tune(gint width_cells,
+                             gint height_cells,
+                             uint32_t image_width,
+                             uint32_t image_height,
+                             TermSize &term_size,
+                             bool session_type_is_x11,
+                             double link_drain_rate,
+                             double target_frame_time_seconds)
+{
+    auto frame = make_synthetic_frame(image_width, image_height);
+    auto chosen = candidates[std::size(candidates) - 1];
+
+    for (auto &candidate : candidates)
+    {
+        ChafaInfo chafa_info(width_cells,
+                             height_cells,
+                             term_size.width_of_a_cell_in_pixels,
+                             term_size.height_of_a_cell_in_pixels,
+                             session_type_is_x11,
+                             candidate);
+        /**
+         * Take the fastest of a few runs, the
+         * first one is warming up the caches.
+         */
+        auto convert_time = 1e9;
+        size_t output_bytes = 0;
+        for (auto i = 0; i < 3; i++)
+        {
+            auto start = now_seconds();
+            auto printable = chafa_info.convert_image(frame.data(), image_width, image_height, image_width * 4);
+            convert_time = std::min(convert_time, now_seconds() - start);
+            output_bytes = printable->len;
+            g_string_free(printable, TRUE);
+        }
+        auto drain_time = link_drain_rate > 0 ? output_bytes / link_drain_rate : 0;
+        if (convert_time + drain_time <= target_frame_time_seconds)
+        {
+            chosen = candidate;
+            break;
+        }
+    }
+    return chosen;
+}
@@ -0,0 +1,38 @@
+#include "connect_to_wayland_socket.h"
+#include "get_socket_path_from_name.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @return -1 on error, socket file descriptor on success
+ */
+static int connect_to_wayland_socket(const std::string &socket_name)
+{
+  auto socket_path = get_socket_path_from_name(socket_name);
+
+  auto socket_file_descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (socket_file_descriptor == -1)
+  {
+    return -1;
+  }
+
+  struct sockaddr_un address = {0};
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  if (connect(socket_file_descriptor, (struct sockaddr *)&address, sizeof(address)) == -1)
+  {
+    close(socket_file_descriptor);
+    return -1;
+  }
+  return socket_file_descriptor;
+}
+
+Value connect_to_wayland_socket_js(const CallbackInfo &info)
+{
+  auto socket_name = info[0].As<String>().Utf8Value();
+  return Number::New(info.Env(), connect_to_wayland_socket(socket_name));
+}
@@ -1,8 +1,10 @@
 #include "detect_terminal.h"
+#include "tmux_passthrough.h"
 
 void detect_terminal(ChafaTermInfo **term_info_out,
                      ChafaCanvasMode *mode_out,
-                     ChafaPixelMode *pixel_mode_out)
+                     ChafaPixelMode *pixel_mode_out,
+                     bool *tmux_passthrough_out)
 
 {
 
@@ -12,7 +14,24 @@ void detect_terminal(ChafaTermInfo **term_info_out,
 
     auto envp = g_get_environ();
 
-    
+    /**
+     * Inside of tmux, TERM is tmux's own TERM which can't
+     * draw images. So detect the outer terminal instead, and
+     * send the image sequences to it with passthrough.
+     */
+    auto using_tmux_passthrough = false;
+    auto &outer_term = tmux_outer_term();
+    if (!outer_term.empty())
+    {
+        envp = g_environ_setenv(envp, "TERM", outer_term.c_str(), TRUE);
+        envp = g_environ_unsetenv(envp, "TMUX");
+        auto term_program = g_environ_getenv(envp, "TERM_PROGRAM");
+        if (term_program != nullptr && std::string(term_program) == "tmux")
+        {
+            envp = g_environ_unsetenv(envp, "TERM_PROGRAM");
+        }
+        using_tmux_passthrough = true;
+    }
 
     auto term_info = chafa_term_db_detect(chafa_term_db_get_default(), envp);
     ChafaPixelMode pixel_mode;
@@ -56,6 +75,11 @@ void detect_terminal(ChafaTermInfo **term_info_out,
     *term_info_out = term_info;
     *mode_out = mode;
     *pixel_mode_out = pixel_mode;
+    /**
+     * Only the image sequences need passthrough, symbols
+     * are drawn by tmux itself.
+     */
+    *tmux_passthrough_out = using_tmux_passthrough && pixel_mode != CHAFA_PIXEL_MODE_SYMBOLS;
 
     /* Cleanup */
 
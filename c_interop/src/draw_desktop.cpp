@@ -3,6 +3,7 @@
 #include "Client_State.h"
 #include "chafa.h"
 
+#include <chrono>
 #include <iostream>
 
 #include "TermSize.h"
@@ -11,19 +12,43 @@
 #include <sstream>
 
 #include "ansi_escape_codes.h"
+#include "tmux_passthrough.h"
+
+/**
+ * @brief Even when nothing changed, draw everything this often,
+ * in case something else wrote over our output
+ */
+constexpr double max_seconds_between_full_frames = 1.0;
+/**
+ * @brief A change this soon after the last one is motion (dragging,
+ * scrolling, video), it can be drawn at the motion scale. After this
+ * long without a change, the desktop is drawn at full resolution again.
+ */
+constexpr double motion_settle_seconds = 0.25;
+
+static double now_seconds()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 Value draw_desktop_js(const CallbackInfo &info)
 {
 
   auto s = info[0].As<External<Draw_State>>().Data();
 
-  auto desktop_buffer = info[1].As<Buffer<uint8_t>>();
-
-  auto width = info[2].As<Number>().Uint32Value();
-  auto height = info[3].As<Number>().Uint32Value();
-  auto status_line = info[4].As<String>().Utf8Value();
+  auto status_line = info[1].As<String>().Utf8Value();
   auto have_status_line = status_line.length() > 0;
 
+  Snapshot_Publisher::Reader reader(s->snapshots);
+  auto snapshot = reader.enter();
+  if (snapshot == nullptr)
+  {
+    std::cerr << "draw_desktop: nothing has been published to draw" << std::endl;
+    return info.Env().Null();
+  }
+  auto width = snapshot->width;
+  auto height = snapshot->height;
+
   /* Get the terminal dimensions and determine the output size, preserving
    * aspect ratio */
   TermSize term_size;
@@ -41,35 +66,225 @@ Value draw_desktop_js(const CallbackInfo &info)
                              TRUE,
                              FALSE);
 
-  s->resize_chafa_info_if_needed(
+  auto new_chafa_info = s->resize_chafa_info_if_needed(
       width_cells,
       height_cells,
+      width,
+      height,
       term_size);
 
-  // auto printable = s->convert_current_desktop_to_ansi();
-  auto printable = s->chafa_info->convert_image(desktop_buffer.Data(),
-                                                width,
-                                                height,
-                                                width * 4);
+  auto now = now_seconds();
+  auto full_frame_due = new_chafa_info ||
+                        have_status_line != s->last_status_line.has_value() ||
+                        now - s->last_full_frame_time >= max_seconds_between_full_frames;
+
+  auto chafa_info = s->chafa_info;
+  auto cell_size_known = chafa_info->width_of_a_cell_in_pixels > 0 &&
+                         chafa_info->height_of_a_cell_in_pixels > 0;
+  auto draw_kitty_placeholders = s->kitty_placeholders != nullptr &&
+                                 chafa_info->pixel_mode == CHAFA_PIXEL_MODE_KITTY &&
+                                 cell_size_known;
+  auto draw_mosaic = s->mosaic_renderer != nullptr &&
+                     chafa_info->pixel_mode == CHAFA_PIXEL_MODE_SYMBOLS &&
+                     Mosaic_Renderer::can_draw(chafa_info->mode);
+  auto draw_kitty_windows = !draw_kitty_placeholders &&
+                            s->kitty_windows != nullptr &&
+                            chafa_info->pixel_mode == CHAFA_PIXEL_MODE_KITTY &&
+                            cell_size_known;
+
+  /**
+   * Kitty windows are drawn straight from the snapshot's
+   * textures, everything else from the composed desktop
+   */
+  size_t changed_tiles = 0;
+  std::string kitty_windows_output;
+  if (draw_kitty_windows)
+  {
+    kitty_windows_output = s->kitty_windows->draw(*snapshot,
+                                                  chafa_info->desktop_pixel_type() == CHAFA_PIXEL_BGRA8_UNASSOCIATED,
+                                                  width_cells,
+                                                  height_cells,
+                                                  chafa_info->width_of_a_cell_in_pixels,
+                                                  chafa_info->height_of_a_cell_in_pixels,
+                                                  status_line_height,
+                                                  full_frame_due);
+  }
+  else
+  {
+    changed_tiles = s->framebuffer.compose(*snapshot);
+  }
+  reader.leave();
+
+  /**
+   * Only kitty and iTerm2 scale images to the cells they
+   * are given, a smaller sixel image is drawn smaller
+   */
+  auto can_draw_motion_frame = s->motion_scale < 1 &&
+                               !draw_kitty_placeholders &&
+                               !draw_kitty_windows &&
+                               cell_size_known &&
+                               (chafa_info->pixel_mode == CHAFA_PIXEL_MODE_KITTY ||
+                                chafa_info->pixel_mode == CHAFA_PIXEL_MODE_ITERM2);
+  auto in_motion = changed_tiles > 0 && now - s->last_desktop_change_time < motion_settle_seconds;
+  auto settled = s->drew_motion_frame && changed_tiles == 0 && now - s->last_desktop_change_time >= motion_settle_seconds;
+  if (changed_tiles > 0)
+  {
+    s->last_desktop_change_time = now;
+  }
+
+  auto desktop_changed = changed_tiles > 0 || full_frame_due || settled || !kitty_windows_output.empty();
+  auto pixel_scale = 1.0;
 
   std::stringstream ss;
-  if (have_status_line)
+  if (have_status_line && (desktop_changed || status_line != s->last_status_line))
   {
     ss << escape_codes::move_cursor_to_home << status_line.c_str() << escape_codes::clear_line_after_cursor << std::endl;
   }
-  ss << printable->str;
+  s->last_status_line = have_status_line ? std::optional<std::string>(status_line) : std::nullopt;
+  auto status_line_bytes = static_cast<size_t>(ss.tellp());
+
+  if (desktop_changed && draw_kitty_windows)
+  {
+    s->last_full_frame_time = now;
+    ss << (chafa_info->tmux_passthrough
+               ? wrap_image_sequences_for_tmux(kitty_windows_output.c_str(), kitty_windows_output.length())
+               : kitty_windows_output);
+    /**
+     * Images only, a full repaint has no text
+     */
+    s->last_printable.clear();
+  }
+  else if (desktop_changed)
+  {
+    s->last_full_frame_time = now;
+    /**
+     * Chafa wants the whole image, it only gets
+     * the tiles that changed since last frame copied in
+     */
+    s->desktop_pixels.resize(static_cast<size_t>(width) * height * 4);
+    s->framebuffer.copy_changed_to(s->desktop_pixels.data());
+
+    if (draw_kitty_placeholders)
+    {
+      auto placeholders = s->kitty_placeholders->draw(s->desktop_pixels.data(),
+                                                      width,
+                                                      height,
+                                                      chafa_info->desktop_pixel_type() == CHAFA_PIXEL_BGRA8_UNASSOCIATED,
+                                                      width_cells,
+                                                      height_cells,
+                                                      chafa_info->width_of_a_cell_in_pixels,
+                                                      chafa_info->height_of_a_cell_in_pixels,
+                                                      status_line_height,
+                                                      full_frame_due);
+      /**
+       * Only the uploads need passthrough, the placeholder
+       * cells are text that tmux keeps track of itself
+       */
+      ss << (chafa_info->tmux_passthrough
+                 ? wrap_image_sequences_for_tmux(placeholders.c_str(), placeholders.length())
+                 : placeholders);
+      if (s->output_recorder != nullptr)
+      {
+        s->last_printable = s->kitty_placeholders->placeholder_text;
+      }
+    }
+    else if (draw_mosaic)
+    {
+      auto mosaic = s->mosaic_renderer->draw(s->desktop_pixels.data(),
+                                             width,
+                                             height,
+                                             chafa_info->desktop_pixel_type() == CHAFA_PIXEL_BGRA8_UNASSOCIATED,
+                                             chafa_info->mode,
+                                             width_cells,
+                                             height_cells,
+                                             status_line_height);
+      ss << mosaic;
+      if (s->output_recorder != nullptr)
+      {
+        s->last_printable = mosaic;
+      }
+    }
+    else
+    {
+      auto converter = chafa_info;
+      s->drew_motion_frame = can_draw_motion_frame && in_motion;
+      if (s->drew_motion_frame)
+      {
+        converter = s->get_motion_chafa_info();
+        pixel_scale = s->motion_scale;
+      }
+      auto printable = converter->convert_image(s->desktop_pixels.data(),
+                                                width,
+                                                height,
+                                                width * 4);
+      ss << printable->str;
+      if (s->output_recorder != nullptr)
+      {
+        s->last_printable.assign(printable->str, printable->len);
+      }
+      g_string_free(printable, TRUE);
+    }
+  }
 
   // ss << escape_codes::move_cursor_to_home
   //    << printable->str;
   auto out_string = ss.str();
 
-  fwrite(out_string.c_str(), sizeof(char), out_string.length(), stdout);
-  fflush(stdout);
-  g_string_free(printable, TRUE);
+  if (s->output_recorder != nullptr)
+  {
+    /**
+     * What a full repaint of this frame looks like, starting
+     * from the top left, to check what we emitted against.
+     */
+    std::stringstream reference;
+    reference << escape_codes::move_cursor_to_home;
+    if (have_status_line)
+    {
+      reference << status_line.c_str() << escape_codes::clear_line_after_cursor << std::endl;
+    }
+    reference << s->last_printable;
+    s->output_recorder->record_frame(term_size.width_cells,
+                                     term_size.height_cells,
+                                     reference.str(),
+                                     out_string);
+  }
+
+  if (s->output_profiler != nullptr)
+  {
+    s->output_profiler->profile_frame(out_string, status_line_bytes);
+  }
+
+  if (!out_string.empty())
+  {
+    fputs(escape_codes::begin_synchronized_update, stdout);
+    fwrite(out_string.c_str(), sizeof(char), out_string.length(), stdout);
+    fputs(escape_codes::end_synchronized_update, stdout);
+    fflush(stdout);
+  }
 
   auto out = Object::New(info.Env());
   out.Set("width_cells", Number::New(info.Env(), width_cells));
   out.Set("height_cells", Number::New(info.Env(), height_cells));
+  out.Set("bytes_written", Number::New(info.Env(), out_string.length()));
+  out.Set("desktop_bytes", Number::New(info.Env(), out_string.length() - status_line_bytes));
+  out.Set("pixel_scale", Number::New(info.Env(), pixel_scale));
 
   return out;
 }
+
+Value set_motion_scale_js(const CallbackInfo &info)
+{
+  auto s = info[0].As<External<Draw_State>>().Data();
+  s->set_motion_scale(info[1].As<Number>().DoubleValue());
+  return info.Env().Undefined();
+}
+
+Value write_output_profile_js(const CallbackInfo &info)
+{
+  auto s = info[0].As<External<Draw_State>>().Data();
+  if (s->output_profiler != nullptr)
+  {
+    s->output_profiler->write_report();
+  }
+  return info.Env().Undefined();
+}
@@ -1,6 +1,9 @@
 #include "init_draw_state.h"
 
 #include "Draw_State.h"
+#include "Thread_Pool.h"
+
+#include <algorithm>
 
 Value init_draw_state_js(const CallbackInfo &info)
 {
@@ -8,9 +11,87 @@ Value init_draw_state_js(const CallbackInfo &info)
 
   auto session_type_is_x11 = info[0].As<Boolean>().Value();
 
+  Draw_State_Options options;
+  if (info.Length() > 1 && info[1].IsObject())
+  {
+    auto js_options = info[1].As<Object>();
+    auto frame_time = js_options.Get("auto_tune_frame_time_seconds");
+    if (frame_time.IsNumber())
+    {
+      options.auto_tune_frame_time_seconds = frame_time.As<Number>().DoubleValue();
+    }
+    auto record_output_path = js_options.Get("record_output_path");
+    if (record_output_path.IsString())
+    {
+      options.record_output_path = record_output_path.As<String>().Utf8Value();
+    }
+    auto profile_output_path = js_options.Get("profile_output_path");
+    if (profile_output_path.IsString())
+    {
+      options.profile_output_path = profile_output_path.As<String>().Utf8Value();
+    }
+    auto kitty_placeholders = js_options.Get("kitty_placeholders");
+    if (kitty_placeholders.IsBoolean())
+    {
+      options.kitty_placeholders = kitty_placeholders.As<Boolean>().Value();
+    }
+    auto kitty_windows = js_options.Get("kitty_windows");
+    if (kitty_windows.IsBoolean())
+    {
+      options.kitty_windows = kitty_windows.As<Boolean>().Value();
+    }
+    auto render_mode = js_options.Get("render_mode");
+    Mosaic_Grid mosaic_grid;
+    if (render_mode.IsString() &&
+        mosaic_grid_from_name(render_mode.As<String>().Utf8Value(), &mosaic_grid))
+    {
+      options.mosaic_grid = mosaic_grid;
+    }
+    auto threads = js_options.Get("threads");
+    if (threads.IsNumber())
+    {
+      options.threads = threads.As<Number>().Uint32Value();
+    }
+  }
+
+  /**
+   * Before anything uses the pool. Chafa has its own threads, but
+   * both are only ever driven from this thread, one at a time, so
+   * each gets the same number of cores: the pool's workers and this
+   * thread, or chafa's threads while this one waits for them.
+   */
+  configure_thread_pool(options.threads);
+  chafa_set_n_threads(thread_pool().thread_count() + 1);
+
   auto draw_state = External<Draw_State>::New(
-      env, new Draw_State(session_type_is_x11),
+      env, new Draw_State(session_type_is_x11, options),
       [](Napi::Env env, Draw_State *data)
       { delete data; });
   return draw_state;
 }
+
+Value take_auto_tune_input_js(const CallbackInfo &info)
+{
+  auto env = info.Env();
+  auto draw_state = info[0].As<External<Draw_State>>().Data();
+  auto &input = draw_state->input_read_during_auto_tune;
+  auto out = Uint8Array::New(env, input.length());
+  std::copy(input.begin(), input.end(), out.Data());
+  input.clear();
+  return out;
+}
+
+Value get_thread_pool_stats_js(const CallbackInfo &info)
+{
+  auto env = info.Env();
+  auto stats = thread_pool().stats();
+  auto out = Object::New(env);
+  out.Set("threads", Number::New(env, stats.threads));
+  out.Set("tasks_run", Number::New(env, stats.tasks_run));
+  out.Set("tasks_stolen", Number::New(env, stats.tasks_stolen));
+  out.Set("tasks_expired", Number::New(env, stats.tasks_expired));
+  out.Set("tasks_run_while_waiting", Number::New(env, stats.tasks_run_while_waiting));
+  out.Set("queued", Number::New(env, stats.queued));
+  out.Set("utilization", Number::New(env, stats.utilization));
+  return out;
+}
@@ -0,0 +1,123 @@
+#include "kitty_graphics.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <unistd.h>
+
+/**
+ * @brief kitty's limit for one chunk of image data
+ */
+constexpr size_t max_chunk_bytes = 4096;
+
+uint32_t first_kitty_image_id()
+{
+    return 1 + (static_cast<uint32_t>(getpid()) % 2048) * kitty_image_ids_per_process;
+}
+
+static void append_base64(std::string &out, const uint8_t *data, size_t length)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3)
+    {
+        uint32_t n = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += alphabet[(n >> 18) & 63];
+        out += alphabet[(n >> 12) & 63];
+        out += alphabet[(n >> 6) & 63];
+        out += alphabet[n & 63];
+    }
+    if (i == length)
+    {
+        return;
+    }
+    uint32_t n = data[i] << 16;
+    if (i + 1 < length)
+    {
+        n |= data[i + 1] << 8;
+    }
+    out += alphabet[(n >> 18) & 63];
+    out += alphabet[(n >> 12) & 63];
+    out += i + 1 < length ? alphabet[(n >> 6) & 63] : '=';
+    out += '=';
+}
+
+void append_kitty_transmit(std::string &out,
+                           const std::string &keys,
+                           const uint8_t *rgba,
+                           uint32_t width,
+                           uint32_t height)
+{
+    std::string data;
+    append_base64(data, rgba, static_cast<size_t>(width) * height * 4);
+    for (size_t start = 0; start < data.length(); start += max_chunk_bytes)
+    {
+        auto last = start + max_chunk_bytes >= data.length();
+        out += "\033_G";
+        if (start == 0)
+        {
+            out += keys + ",f=32,s=" + std::to_string(width) + ",v=" + std::to_string(height) + ",";
+        }
+        out += last ? "m=0;" : "m=1;";
+        out.append(data, start, max_chunk_bytes);
+        out += "\033\\";
+    }
+}
+
+void scale_to_rgba(const uint8_t *source,
+                   uint32_t source_width,
+                   uint32_t source_height,
+                   size_t source_stride,
+                   uint32_t target_width,
+                   uint32_t target_height,
+                   uint32_t out_x,
+                   uint32_t out_y,
+                   uint32_t out_width,
+                   uint32_t out_height,
+                   bool swap_red_and_blue,
+                   uint8_t *out)
+{
+    /**
+     * Which source columns each target column averages,
+     * the same for every row
+     */
+    std::vector<uint32_t> source_x(out_width + 1);
+    for (uint32_t x = 0; x <= out_width; x++)
+    {
+        source_x[x] = static_cast<uint32_t>(static_cast<uint64_t>(out_x + x) * source_width / target_width);
+    }
+
+    auto out_pixel = out;
+    for (uint32_t y = out_y; y < out_y + out_height; y++)
+    {
+        auto y0 = static_cast<uint32_t>(static_cast<uint64_t>(y) * source_height / target_height);
+        auto y1 = std::max(static_cast<uint32_t>(static_cast<uint64_t>(y + 1) * source_height / target_height), y0 + 1);
+        for (uint32_t x = 0; x < out_width; x++)
+        {
+            auto x0 = source_x[x];
+            auto x1 = std::max(source_x[x + 1], x0 + 1);
+            /**
+             * Average when shrinking, so text
+             * doesn't lose every other line
+             */
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (auto sy = y0; sy < y1; sy++)
+            {
+                auto in_pixel = source + sy * source_stride + static_cast<size_t>(x0) * 4;
+                for (auto sx = x0; sx < x1; sx++, in_pixel += 4)
+                {
+                    sum[0] += in_pixel[0];
+                    sum[1] += in_pixel[1];
+                    sum[2] += in_pixel[2];
+                    sum[3] += in_pixel[3];
+                }
+            }
+            auto count = (y1 - y0) * (x1 - x0);
+            out_pixel[0] = static_cast<uint8_t>(sum[swap_red_and_blue ? 2 : 0] / count);
+            out_pixel[1] = static_cast<uint8_t>(sum[1] / count);
+            out_pixel[2] = static_cast<uint8_t>(sum[swap_red_and_blue ? 0 : 2] / count);
+            out_pixel[3] = static_cast<uint8_t>(sum[3] / count);
+            out_pixel += 4;
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include "mmap_fd.h"
 #include "Client_State.h"
+#include "Native_Buffer.h"
 #include <iostream>
+#include <unistd.h>
 
 Value mmap_shm_pool_js(const CallbackInfo &info)
 {
@@ -12,6 +14,10 @@ Value mmap_shm_pool_js(const CallbackInfo &info)
   if (client_state->shm_pool_memory.find(shm_pool_id) != client_state->shm_pool_memory.end())
   {
     std::cerr << "shm_pool_id already exists " << shm_pool_id << std::endl;
+    /**
+     * The fd was ours to keep, nothing else will close it
+     */
+    close(fd);
     return Boolean::New(info.Env(), false);
   }
 
@@ -73,6 +79,40 @@ Value unmmap_shm_pool_js(const CallbackInfo &info)
   return info.Env().Undefined();
 }
 
+Value create_shm_buffer_js(const CallbackInfo &info)
+{
+  auto env = info.Env();
+  auto client_state = info[0].As<External<ClientState>>().Data();
+  auto shm_pool_id = info[1].As<Number>().Uint32Value();
+  auto offset = info[2].As<Number>().Uint32Value();
+  auto width = info[3].As<Number>().Int32Value();
+  auto height = info[4].As<Number>().Int32Value();
+  auto stride = info[5].As<Number>().Int32Value();
+  auto format = info[6].As<Number>().Uint32Value();
+
+  auto pool_it = client_state->shm_pool_memory.find(shm_pool_id);
+  if (pool_it == client_state->shm_pool_memory.end() || pool_it->second->destroyed())
+  {
+    std::cerr << "create_shm_buffer: shm_pool_id does not exist in map, has it been created yet? id: " << shm_pool_id << std::endl;
+    return env.Null();
+  }
+
+  auto buffer = std::make_shared<const Native_Buffer>(
+      pool_it->second->mapping, offset, width, height, stride, format);
+  if (!buffer->valid())
+  {
+    std::cerr << "create_shm_buffer: buffer does not fit in pool " << shm_pool_id << std::endl;
+    return env.Null();
+  }
+  return native_buffer_to_js(env, buffer);
+}
+
+Value release_shm_buffer_js(const CallbackInfo &info)
+{
+  release_native_buffer_js_handle(info[0]);
+  return info.Env().Undefined();
+}
+
 // #include <fcntl.h>
 // #include <sys/mman.h>
 // #include <iostream>
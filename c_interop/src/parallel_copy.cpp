@@ -0,0 +1,179 @@
+#include "parallel_copy.h"
+#include "Thread_Pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Below this a copy is over before the
+ * other threads would have woken up
+ */
+constexpr size_t parallel_threshold_bytes = 1024 * 1024;
+constexpr size_t min_bytes_per_band = 256 * 1024;
+/**
+ * @brief About the size of a last level cache, a copy bigger
+ * than this would only evict itself on the way
+ */
+constexpr size_t non_temporal_threshold_bytes = 8 * 1024 * 1024;
+/**
+ * @brief copy_pixels splits its run into rows of this many bytes
+ */
+constexpr size_t contiguous_row_bytes = 64 * 1024;
+
+static void convert_pixels_scalar(uint8_t *destination,
+                                  const uint8_t *source,
+                                  size_t bytes,
+                                  Pixel_Conversion conversion)
+{
+    switch (conversion)
+    {
+    case Pixel_Conversion::none:
+        memcpy(destination, source, bytes);
+        break;
+    case Pixel_Conversion::swap_red_and_blue:
+        for (size_t i = 0; i + 4 <= bytes; i += 4)
+        {
+            destination[i] = source[i + 2];
+            destination[i + 1] = source[i + 1];
+            destination[i + 2] = source[i];
+            destination[i + 3] = source[i + 3];
+        }
+        break;
+    case Pixel_Conversion::force_opaque:
+        for (size_t i = 0; i + 4 <= bytes; i += 4)
+        {
+            destination[i] = source[i];
+            destination[i + 1] = source[i + 1];
+            destination[i + 2] = source[i + 2];
+            destination[i + 3] = 255;
+        }
+        break;
+    }
+}
+
+#if defined(__SSE2__)
+static inline __m128i convert_pixels_sse2(__m128i pixels, Pixel_Conversion conversion)
+{
+    switch (conversion)
+    {
+    case Pixel_Conversion::none:
+        return pixels;
+    case Pixel_Conversion::swap_red_and_blue:
+    {
+        /**
+         * Byte 0 and 2 of each pixel trade places, SSE2 has no byte
+         * shuffle so this is done with masks and 16 bit shifts
+         */
+        auto green_and_alpha = _mm_and_si128(pixels, _mm_set1_epi32(static_cast<int>(0xff00ff00)));
+        auto red = _mm_and_si128(_mm_srli_epi32(pixels, 16), _mm_set1_epi32(0x000000ff));
+        auto blue = _mm_slli_epi32(_mm_and_si128(pixels, _mm_set1_epi32(0x000000ff)), 16);
+        return _mm_or_si128(green_and_alpha, _mm_or_si128(red, blue));
+    }
+    case Pixel_Conversion::force_opaque:
+        return _mm_or_si128(pixels, _mm_set1_epi32(static_cast<int>(0xff000000)));
+    }
+    return pixels;
+}
+#endif
+
+static void convert_row(uint8_t *destination,
+                        const uint8_t *source,
+                        size_t bytes,
+                        Pixel_Conversion conversion,
+                        bool non_temporal)
+{
+#if defined(__SSE2__)
+    if ((conversion == Pixel_Conversion::none && !non_temporal) ||
+        reinterpret_cast<uintptr_t>(destination) % 4 != 0)
+    {
+        convert_pixels_scalar(destination, source, bytes, conversion);
+        return;
+    }
+    /**
+     * Streaming stores have to be aligned, do the
+     * pixels up to the first 16 byte boundary one by one
+     */
+    auto head = std::min(bytes, (16 - reinterpret_cast<uintptr_t>(destination) % 16) % 16);
+    convert_pixels_scalar(destination, source, head, conversion);
+    size_t i = head;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        pixels = convert_pixels_sse2(pixels, conversion);
+        if (non_temporal)
+        {
+            _mm_stream_si128(reinterpret_cast<__m128i *>(destination + i), pixels);
+        }
+        else
+        {
+            _mm_store_si128(reinterpret_cast<__m128i *>(destination + i), pixels);
+        }
+    }
+    convert_pixels_scalar(destination + i, source + i, bytes - i, conversion);
+#else
+    convert_pixels_scalar(destination, source, bytes, conversion);
+#endif
+}
+
+void copy_rows(uint8_t *destination,
+               size_t destination_stride,
+               const uint8_t *source,
+               size_t source_stride,
+               size_t row_bytes,
+               uint32_t rows,
+               Pixel_Conversion conversion)
+{
+    auto total_bytes = row_bytes * rows;
+    auto non_temporal = total_bytes >= non_temporal_threshold_bytes;
+
+    auto copy_band = [&](size_t begin, size_t end)
+    {
+        for (auto y = begin; y < end; y++)
+        {
+            convert_row(destination + y * destination_stride,
+                        source + y * source_stride,
+                        row_bytes,
+                        conversion,
+                        non_temporal);
+        }
+#if defined(__SSE2__)
+        if (non_temporal)
+        {
+            /**
+             * Streaming stores are weakly ordered, they have to land
+             * before the waiting thread is told this band is done
+             */
+            _mm_sfence();
+        }
+#endif
+    };
+
+    if (total_bytes < parallel_threshold_bytes || row_bytes == 0)
+    {
+        copy_band(0, rows);
+        return;
+    }
+    auto min_rows_per_band = std::max<size_t>(1, min_bytes_per_band / row_bytes);
+    thread_pool().parallel_for(rows, copy_band, min_rows_per_band);
+}
+
+void copy_pixels(uint8_t *destination,
+                 const uint8_t *source,
+                 size_t length,
+                 Pixel_Conversion conversion)
+{
+    auto rows = length / contiguous_row_bytes;
+    copy_rows(destination,
+              contiguous_row_bytes,
+              source,
+              contiguous_row_bytes,
+              contiguous_row_bytes,
+              static_cast<uint32_t>(rows),
+              conversion);
+    auto done = rows * contiguous_row_bytes;
+    convert_row(destination + done, source + done, length - done, conversion, false);
+}
@@ -0,0 +1,33 @@
+#include "publish_compositor_snapshot.h"
+#include "Draw_State.h"
+#include <iostream>
+
+Value publish_compositor_snapshot_js(const CallbackInfo &info)
+{
+  auto s = info[0].As<External<Draw_State>>().Data();
+  auto width = info[1].As<Number>().Uint32Value();
+  auto height = info[2].As<Number>().Uint32Value();
+  auto draw_list = info[3].As<Array>();
+
+  auto snapshot = new Compositor_Snapshot();
+  snapshot->width = width;
+  snapshot->height = height;
+  snapshot->draw_list.reserve(draw_list.Length());
+  for (uint32_t i = 0; i < draw_list.Length(); i++)
+  {
+    auto item = draw_list.Get(i).As<Object>();
+    auto handle = native_texture_from_js(item.Get("texture"));
+    if (handle == nullptr || handle->texture == nullptr)
+    {
+      std::cerr << "publish_compositor_snapshot: draw list item " << i << " has no texture" << std::endl;
+      continue;
+    }
+    snapshot->draw_list.push_back({
+        handle->texture,
+        item.Get("x").As<Number>().Int32Value(),
+        item.Get("y").As<Number>().Int32Value(),
+    });
+  }
+  s->snapshots.publish(snapshot);
+  return info.Env().Undefined();
+}
@@ -0,0 +1,230 @@
+#include "tmux_passthrough.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+/**
+ * @brief tmux drops any DCS sequence that overflows its input
+ * buffer, and old versions have a much smaller buffer than new ones,
+ * so keep each passthrough sequence small. 4096 is the same size
+ * kitty uses for its own image chunks.
+ */
+constexpr size_t tmux_passthrough_chunk_size = 4096;
+
+constexpr auto kitty_start = "\033_G";
+
+constexpr auto tmux_passthrough_start = "\033Ptmux;";
+constexpr auto string_terminator = "\033\\";
+
+bool inside_tmux()
+{
+    auto tmux = std::getenv("TMUX");
+    return tmux != nullptr && tmux[0] != '\0';
+}
+
+/**
+ * @brief Each run_tmux_command is a fork and exec
+ */
+static std::once_flag tmux_outer_term_once;
+static std::string cached_tmux_outer_term;
+
+static std::string run_tmux_command(const std::string &command)
+{
+    auto pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr)
+    {
+        perror("popen tmux");
+        return "";
+    }
+    std::string out;
+    char buffer[256];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+    {
+        out.append(buffer, read);
+    }
+    if (pclose(pipe) != 0)
+    {
+        return "";
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r'))
+    {
+        out.pop_back();
+    }
+    return out;
+}
+
+std::string tmux_display(const char *format)
+{
+    return run_tmux_command(std::string("tmux display-message -p '") + format + "' 2>/dev/null");
+}
+
+bool tmux_allows_passthrough()
+{
+    auto version = run_tmux_command("tmux -V 2>/dev/null");
+    auto value = run_tmux_command("tmux show-options -gv allow-passthrough 2>/dev/null");
+    if (value.empty())
+    {
+        /**
+         * Versions before 3.3 don't know about the option
+         * and always pass DCS sequences through. If we couldn't
+         * even get the version, then we can't talk to tmux at all.
+         */
+        return !version.empty();
+    }
+    return value == "on" || value == "all";
+}
+
+const std::string &tmux_outer_term()
+{
+    std::call_once(tmux_outer_term_once, []
+                   {
+        if (inside_tmux() && tmux_allows_passthrough())
+        {
+            cached_tmux_outer_term = tmux_display("#{client_termname}");
+        } });
+    return cached_tmux_outer_term;
+}
+
+static void append_passthrough_chunk(std::string &out, const char *data, size_t length)
+{
+    out += tmux_passthrough_start;
+    for (size_t i = 0; i < length; i++)
+    {
+        /**
+         * Inside of passthrough every ESC must be doubled
+         */
+        if (data[i] == '\033')
+        {
+            out += '\033';
+        }
+        out += data[i];
+    }
+    out += string_terminator;
+}
+
+/**
+ * @brief If an image sequence starts at data[i], returns the index
+ * one past its terminator, otherwise returns i.
+ */
+static size_t find_end_of_image_sequence(const char *data, size_t length, size_t i)
+{
+    if (data[i] != '\033' || i + 1 >= length)
+    {
+        return i;
+    }
+    auto introducer = data[i + 1];
+    auto is_kitty = introducer == '_';
+    auto is_sixel = introducer == 'P';
+    auto is_iterm2 = introducer == ']' && length - i >= 7 && std::strncmp(data + i + 2, "1337;", 5) == 0;
+    if (!is_kitty && !is_sixel && !is_iterm2)
+    {
+        return i;
+    }
+    for (auto j = i + 2; j < length; j++)
+    {
+        if (is_iterm2 && data[j] == '\a')
+        {
+            return j + 1;
+        }
+        if (data[j] == '\033' && j + 1 < length && data[j + 1] == '\\')
+        {
+            return j + 2;
+        }
+    }
+    /**
+     * Unterminated, wrap the rest of the output
+     */
+    return length;
+}
+
+/**
+ * @brief Splits one kitty command whose data is too big for one
+ * passthrough into a chunked transmission (m=1 on every chunk but
+ * the last), each chunk its own passthrough. Kitty puts the chunks
+ * back together, so anything tmux writes in between is harmless.
+ */
+static void append_kitty_in_chunks(std::string &out, const char *data, size_t length)
+{
+    auto body_start = std::strlen(kitty_start);
+    auto body = std::string(data + body_start, length - body_start - std::strlen(string_terminator));
+    auto semicolon = body.find(';');
+    if (semicolon == std::string::npos || body.length() - semicolon - 1 <= tmux_passthrough_chunk_size)
+    {
+        append_passthrough_chunk(out, data, length);
+        return;
+    }
+    /**
+     * If this was already a chunk of a bigger image,
+     * the last piece keeps saying more is coming
+     */
+    std::string keys;
+    auto more_after = false;
+    size_t key_start = 0;
+    while (key_start < semicolon)
+    {
+        auto key_end = std::min(body.find(',', key_start), semicolon);
+        auto key = body.substr(key_start, key_end - key_start);
+        if (key.rfind("m=", 0) == 0)
+        {
+            more_after = key == "m=1";
+        }
+        else if (!key.empty())
+        {
+            keys += key + ",";
+        }
+        key_start = key_end + 1;
+    }
+    auto payload = std::string_view(body).substr(semicolon + 1);
+    for (size_t start = 0; start < payload.length(); start += tmux_passthrough_chunk_size)
+    {
+        auto last = start + tmux_passthrough_chunk_size >= payload.length();
+        std::string chunk = kitty_start;
+        if (start == 0)
+        {
+            chunk += keys;
+        }
+        chunk += last && !more_after ? "m=0;" : "m=1;";
+        chunk += payload.substr(start, tmux_passthrough_chunk_size);
+        chunk += string_terminator;
+        append_passthrough_chunk(out, chunk.c_str(), chunk.length());
+    }
+}
+
+std::string wrap_image_sequences_for_tmux(const char *data, size_t length)
+{
+    std::string out;
+    out.reserve(length + length / 16);
+    size_t i = 0;
+    while (i < length)
+    {
+        auto end = find_end_of_image_sequence(data, length, i);
+        if (end == i)
+        {
+            out += data[i];
+            i++;
+            continue;
+        }
+        /**
+         * tmux can write its own output between two passthrough
+         * sequences, so only split where the image protocol allows
+         * it. Sixel and iTerm2 images can't be split, they go
+         * through whole.
+         */
+        auto terminated = end - i >= 2 + std::strlen(string_terminator) &&
+                          std::strncmp(data + end - 2, string_terminator, 2) == 0;
+        if (terminated && std::strncmp(data + i, kitty_start, std::strlen(kitty_start)) == 0)
+        {
+            append_kitty_in_chunks(out, data + i, end - i);
+        }
+        else
+        {
+            append_passthrough_chunk(out, data + i, end - i);
+        }
+        i = end;
+    }
+    return out;
+}
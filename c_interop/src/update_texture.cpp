@@ -0,0 +1,77 @@
+#include "update_texture.h"
+#include "Native_Texture.h"
+#include <cstring>
+#include <iostream>
+
+Value update_texture_js(const CallbackInfo &info)
+{
+  auto env = info.Env();
+  auto handle = native_texture_from_js(info[0]);
+  auto buffer = native_buffer_from_js(info[1]);
+
+  if (buffer == nullptr || !buffer->valid())
+  {
+    std::cerr << "update_texture: buffer has been released, cannot copy from it" << std::endl;
+    return env.Null();
+  }
+
+  if (handle == nullptr)
+  {
+    auto texture = std::make_shared<Native_Texture>(buffer->width, buffer->height);
+    if (!texture->copy_from(*buffer))
+    {
+      return env.Null();
+    }
+    return native_texture_to_js(env, texture);
+  }
+
+  /**
+   * Copy on write, a texture is only written in place if nothing
+   * else (a published snapshot, Kitty_Windows) has a reference to it.
+   */
+  auto writable = [&](const std::shared_ptr<Native_Texture> &texture)
+  {
+    return texture != nullptr &&
+           texture.use_count() == 1 &&
+           texture->width == static_cast<uint32_t>(buffer->width) &&
+           texture->height == static_cast<uint32_t>(buffer->height);
+  };
+  auto swapped = !writable(handle->texture);
+  if (swapped)
+  {
+    if (!writable(handle->spare))
+    {
+      handle->spare = std::make_shared<Native_Texture>(buffer->width, buffer->height);
+    }
+    std::swap(handle->texture, handle->spare);
+  }
+  if (!handle->texture->copy_from(*buffer))
+  {
+    /**
+     * The surface keeps showing what it showed
+     */
+    if (swapped)
+    {
+      std::swap(handle->texture, handle->spare);
+    }
+    return env.Null();
+  }
+  return info[0];
+}
+
+Value create_texture_js(const CallbackInfo &info)
+{
+  auto env = info.Env();
+  auto pixels = info[0].As<Buffer<uint8_t>>();
+  auto width = info[1].As<Number>().Uint32Value();
+  auto height = info[2].As<Number>().Uint32Value();
+
+  auto texture = std::make_shared<Native_Texture>(width, height);
+  if (pixels.ByteLength() < texture->pixels.size())
+  {
+    std::cerr << "create_texture: pixels are smaller than width * height * 4" << std::endl;
+    return env.Null();
+  }
+  memcpy(texture->pixels.data(), pixels.Data(), texture->pixels.size());
+  return native_texture_to_js(env, texture);
+}
@@ -0,0 +1,183 @@
+#include "yuv_to_bgra.h"
+#include "Thread_Pool.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief In output pixels, below this the other
+ * threads would only just be waking up
+ */
+constexpr size_t parallel_threshold_pixels = 256 * 1024;
+constexpr size_t min_pixels_per_band = 64 * 1024;
+
+/**
+ * @brief BT.601 limited range in 6 bit fixed point. Small enough
+ * that every product and sum fits in 16 bits, the SSE2 path does
+ * 8 pixels at a time with the same numbers.
+ *
+ * R = 1.164 (Y - 16) + 1.596 (V - 128)
+ * G = 1.164 (Y - 16) - 0.391 (U - 128) - 0.813 (V - 128)
+ * B = 1.164 (Y - 16) + 2.018 (U - 128)
+ */
+constexpr int16_t y_factor = 75;
+constexpr int16_t v_to_red = 102;
+constexpr int16_t u_to_green = 25;
+constexpr int16_t v_to_green = 52;
+constexpr int16_t u_to_blue = 129;
+constexpr int16_t rounding = 32;
+constexpr int fraction_bits = 6;
+
+bool is_yuv_format(uint32_t format)
+{
+    return format == wl_shm_format_yuyv || format == wl_shm_format_nv12;
+}
+
+size_t yuv_buffer_byte_length(uint32_t format, int32_t stride, int32_t height)
+{
+    auto luma = static_cast<size_t>(stride) * height;
+    if (format == wl_shm_format_nv12)
+    {
+        return luma + static_cast<size_t>(stride) * ((height + 1) / 2);
+    }
+    return luma;
+}
+
+size_t yuv_min_stride(uint32_t format, uint32_t width)
+{
+    auto even_width = (static_cast<size_t>(width) + 1) & ~static_cast<size_t>(1);
+    return format == wl_shm_format_nv12 ? even_width : even_width * 2;
+}
+
+static inline uint8_t clamp_to_byte(int value)
+{
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+static inline void yuv_pixel_to_bgra(int y, int u, int v, uint8_t *out)
+{
+    auto c = (y - 16) * y_factor + rounding;
+    auto d = u - 128;
+    auto e = v - 128;
+    out[0] = clamp_to_byte((c + u_to_blue * d) >> fraction_bits);
+    out[1] = clamp_to_byte((c - u_to_green * d - v_to_green * e) >> fraction_bits);
+    out[2] = clamp_to_byte((c + v_to_red * e) >> fraction_bits);
+    out[3] = 255;
+}
+
+#if defined(__SSE2__)
+/**
+ * @param y 8 luma values, 16 bits each
+ * @param chroma U0 V0 U1 V1 U2 V2 U3 V3, 16 bits each,
+ * every pair is shared by two pixels
+ */
+static inline void yuv_8_pixels_to_bgra(__m128i y, __m128i chroma, uint8_t *out)
+{
+    auto low_halves = _mm_set1_epi32(0x0000ffff);
+    auto u = _mm_or_si128(_mm_and_si128(chroma, low_halves), _mm_slli_epi32(chroma, 16));
+    auto v = _mm_or_si128(_mm_srli_epi32(chroma, 16), _mm_andnot_si128(low_halves, chroma));
+    u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+    auto c = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(y_factor)),
+                           _mm_set1_epi16(rounding));
+    /**
+     * Saturating, blue can go past 32767 for bright blue,
+     * which is past 255 either way
+     */
+    auto blue = _mm_adds_epi16(c, _mm_mullo_epi16(u, _mm_set1_epi16(u_to_blue)));
+    auto green = _mm_subs_epi16(_mm_subs_epi16(c, _mm_mullo_epi16(u, _mm_set1_epi16(u_to_green))),
+                                _mm_mullo_epi16(v, _mm_set1_epi16(v_to_green)));
+    auto red = _mm_adds_epi16(c, _mm_mullo_epi16(v, _mm_set1_epi16(v_to_red)));
+
+    auto zero = _mm_setzero_si128();
+    auto blue_8 = _mm_packus_epi16(_mm_srai_epi16(blue, fraction_bits), zero);
+    auto green_8 = _mm_packus_epi16(_mm_srai_epi16(green, fraction_bits), zero);
+    auto red_8 = _mm_packus_epi16(_mm_srai_epi16(red, fraction_bits), zero);
+    auto alpha_8 = _mm_set1_epi8(static_cast<char>(0xff));
+
+    auto blue_green = _mm_unpacklo_epi8(blue_8, green_8);
+    auto red_alpha = _mm_unpacklo_epi8(red_8, alpha_8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(blue_green, red_alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_unpackhi_epi16(blue_green, red_alpha));
+}
+#endif
+
+static void nv12_row_to_bgra(const uint8_t *luma, const uint8_t *chroma, uint32_t width, uint8_t *out)
+{
+    uint32_t x = 0;
+#if defined(__SSE2__)
+    auto zero = _mm_setzero_si128();
+    for (; x + 8 <= width; x += 8)
+    {
+        auto y = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(luma + x)), zero);
+        auto uv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(chroma + x)), zero);
+        yuv_8_pixels_to_bgra(y, uv, out + static_cast<size_t>(x) * 4);
+    }
+#endif
+    for (; x < width; x++)
+    {
+        auto pair = chroma + (x & ~1u);
+        yuv_pixel_to_bgra(luma[x], pair[0], pair[1], out + static_cast<size_t>(x) * 4);
+    }
+}
+
+static void yuyv_row_to_bgra(const uint8_t *row, uint32_t width, uint8_t *out)
+{
+    uint32_t x = 0;
+#if defined(__SSE2__)
+    auto low_bytes = _mm_set1_epi16(0x00ff);
+    for (; x + 8 <= width; x += 8)
+    {
+        /**
+         * Y0 U0 Y1 V0 Y2 U1 Y3 V1 ...
+         */
+        auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + static_cast<size_t>(x) * 2));
+        auto y = _mm_and_si128(pixels, low_bytes);
+        auto uv = _mm_srli_epi16(pixels, 8);
+        yuv_8_pixels_to_bgra(y, uv, out + static_cast<size_t>(x) * 4);
+    }
+#endif
+    for (; x < width; x++)
+    {
+        auto pair = row + static_cast<size_t>(x & ~1u) * 2;
+        yuv_pixel_to_bgra(row[static_cast<size_t>(x) * 2], pair[1], pair[3], out + static_cast<size_t>(x) * 4);
+    }
+}
+
+void yuv_to_bgra(uint32_t format,
+                 const uint8_t *source,
+                 int32_t source_stride,
+                 uint32_t width,
+                 uint32_t height,
+                 uint8_t *destination)
+{
+    auto chroma_plane = source + static_cast<size_t>(source_stride) * height;
+    auto out_stride = static_cast<size_t>(width) * 4;
+    auto convert_band = [&](size_t begin, size_t end)
+    {
+        for (auto y = begin; y < end; y++)
+        {
+            auto out = destination + y * out_stride;
+            auto row = source + y * source_stride;
+            if (format == wl_shm_format_nv12)
+            {
+                nv12_row_to_bgra(row, chroma_plane + (y / 2) * source_stride, width, out);
+            }
+            else
+            {
+                yuyv_row_to_bgra(row, width, out);
+            }
+        }
+    };
+
+    if (static_cast<size_t>(width) * height < parallel_threshold_pixels || width == 0)
+    {
+        convert_band(0, height);
+        return;
+    }
+    thread_pool().parallel_for(height, convert_band, std::max<size_t>(1, min_pixels_per_band / width));
+}
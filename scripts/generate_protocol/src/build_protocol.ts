@@ -1,22 +1,47 @@
 import { parseStringPromise } from "xml2js";
 import Bun from "bun";
-import { Protocol } from "./Protocol.ts";
+import { Interface, Protocol } from "./Protocol.ts";
 import prettier from "prettier";
 import { gen_interface_interface } from "./gen_interface_interface.ts";
 import { gen_enums } from "./gen_enums.ts";
 import { gen_events } from "./gen_events.ts";
 import { gen_request_handler } from "./gen_request_handler.ts";
+import { gen_imports, uses_global_ids } from "./gen_imports.ts";
 
-export const build_protocol = async (file_name: string) => {
+export interface Generated_Interface {
+  name: string;
+  version: number;
+  source: string;
+}
+
+/**
+ * Only what the module needs. Everything but the debug macro
+ * is a type, so loading one interface doesn't load the others.
+ */
+const gen_header = (int: Interface) => `/** This file has been generated by \`task generate-protocol\`  */
+import type { Sender } from "../Sender.ts";
+import type { Debug_Send_Message } from "../Send_Message.ts";
+import type { Object_ID, File_Descriptor, UInt32, Int32, Fixed, version } from "../wayland_types.ts";
+import type { DecodeState_Data } from "../Decode_State.ts";
+import type { Wayland_Client } from "../Wayland_Client.ts";
+import { wayland_debug_time_only, show_wayland_surface_and_buffer } from "../debug.ts" with { type: "macro" };
+import { debug_counter } from "./protocol_registry.ts";
+${uses_global_ids(int) ? `import { Global_Ids } from "../GlobalObjects.ts";` : ""}
+${gen_imports(int)}
+`;
+
+export const build_protocol = async (
+  file_name: string
+): Promise<Generated_Interface[]> => {
   const bob: Protocol = await parseStringPromise(
     await Bun.file(`${import.meta.dir}/../protocols/${file_name}`).text()
   );
 
-  let out = ``;
+  const out: Generated_Interface[] = [];
 
   for (const int of bob.protocol.interface) {
     const delegate_name = `${int.$.name}_delegate`;
-    let bob = `
+    let bob = `${gen_header(int)}
   export interface ${delegate_name} {
     ${gen_interface_interface(int)}
   }
@@ -45,13 +70,12 @@ export const build_protocol = async (file_name: string) => {
     ${gen_enums(int)}
 
 `;
-    out += bob;
+    out.push({
+      name: int.$.name,
+      version: Number(int.$.version),
+      source: await prettier.format(bob, { parser: "typescript" }),
+    });
   }
 
-  const out_file = await prettier.format(out, { parser: "typescript" });
-  // const out_file = out;
-
-  return out_file;
-
-  //   Bun.write(`${process.env["OUT_DIR"]}/${file_name}.ts`, out_file);
+  return out;
 };
@@ -0,0 +1,51 @@
+import { enum_name } from "./enum_name.ts";
+import { Interface } from "./Protocol.ts";
+
+/**
+ * Every interface lives in its own module, so the types
+ * it mentions from other interfaces (object args, new_ids,
+ * and enums like wl_output.transform) have to be imported.
+ *
+ * They are only ever used as types, so `import type` keeps
+ * them from loading the other modules at runtime.
+ */
+export const gen_imports = (i: Interface) => {
+  const modules = new Map<string, Set<string>>();
+  const add = (module_name: string, name: string) => {
+    if (module_name === i.$.name) {
+      return;
+    }
+    const names = modules.get(module_name) ?? new Set<string>();
+    names.add(name);
+    modules.set(module_name, names);
+  };
+  for (const message of [...(i.request ?? []), ...(i.event ?? [])]) {
+    for (const { $: arg } of message.arg ?? []) {
+      switch (arg.type) {
+        case "new_id":
+        case "object":
+          if (arg.interface) {
+            add(arg.interface, arg.interface);
+          }
+          break;
+        case "uint":
+          if (arg.enum?.includes(".")) {
+            const [interface_name] = arg.enum.split(".");
+            add(interface_name, enum_name(i.$.name, arg.enum));
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  return [...modules.entries()]
+    .map(
+      ([module_name, names]) =>
+        `import type { ${[...names].join(", ")} } from "./${module_name}.ts";`
+    )
+    .join("\n");
+};
+
+export const uses_global_ids = (i: Interface) =>
+  i.request?.some((req) => req.$.name === "release") ?? false;
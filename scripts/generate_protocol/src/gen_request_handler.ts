@@ -52,7 +52,7 @@ export const gen_request_handler = (i: Interface) => {
       }
 
       if(${debug_statement}) {
-        console.log(\`[\${debug_statement++}]: client#\${s.client_socket} ${i.$.name}@\${ message.object_id}.${req.$.name}(\`, ${debug_request_arguments}  );
+        console.log(\`[\${debug_counter.statement++}]: client#\${s.client_socket} ${i.$.name}@\${ message.object_id}.${req.$.name}(\`, ${debug_request_arguments}  );
 
       }
     
@@ -3,29 +3,70 @@ import { readdir } from "node:fs/promises";
 import { build_protocol } from "./build_protocol.ts";
 
 const files = await readdir(`${import.meta.dir}/../protocols`);
-const interfaces = await Promise.all(
-  files.map(async (file) => {
-    return build_protocol(file);
-  })
+const interfaces = (
+  await Promise.all(
+    files.map(async (file) => {
+      return build_protocol(file);
+    })
+  )
+).flat();
+
+const out_dir = process.env["OUT_DIR"];
+
+/**
+ * One module per interface, so that an interface
+ * is only loaded (and evaluated) when something uses it.
+ */
+await Promise.all(
+  interfaces.map((int) => Bun.write(`${out_dir}/${int.name}.ts`, int.source))
 );
 
-let out_file = `/** This file has been generated by \`task generate-protocol\`  */
-import { Sender } from "../Sender.ts";
-import { Debug_Send_Message } from "../Send_Message.ts";
-import { Object_ID, File_Descriptor, UInt32, Int32, Fixed, version } from "../wayland_types.ts";
-import {DecodeState_Data} from "../Decode_State.ts";
-import { Wayland_Client } from "../Wayland_Client.ts";
-import {wayland_debug_time_only, show_wayland_surface_and_buffer} from "../debug.ts" with {type: "macro"};
-import {Global_Ids} from "../GlobalObjects.ts";
+/**
+ * The registry is small and loaded eagerly, it only
+ * knows how to load the interfaces, it doesn't load them.
+ */
+let registry = `/** This file has been generated by \`task generate-protocol\`  */
 
-export let debug_statement = 0;
+/**
+ * Shared by all the interfaces, so WAYLAND_DEBUG output
+ * is numbered in order across all of them
+ */
+export const debug_counter = { statement: 0 };
 
+export const protocol_loaders = {
 `;
 for (const int of interfaces) {
-  out_file += int;
+  registry += `  ${int.name}: (): typeof import("./${int.name}.ts").${int.name} =>
+    require("./${int.name}.ts").${int.name},
+`;
 }
+registry += `};
 
-// const file_split = Bun.argv[2].split("/");
-// const file_name = file_split[file_split.length - 1];
+export type Protocol_Name = keyof typeof protocol_loaders;
 
-Bun.write(`${process.env["OUT_DIR"]}/wayland.xml.ts`, out_file);
+/**
+ * Loads the module of an interface on first use, later
+ * calls get the cached module.
+ */
+export const load_protocol = <T extends Protocol_Name>(
+  name: T
+): ReturnType<(typeof protocol_loaders)[T]> => protocol_loaders[name]() as any;
+
+export const protocol_versions: { [name in Protocol_Name]: number } = {
+${interfaces.map((int) => `  ${int.name}: ${int.version},`).join("\n")}
+};
+`;
+await Bun.write(`${out_dir}/protocol_registry.ts`, registry);
+
+/**
+ * Everything in one place, for scripts and for types.
+ * Importing this at runtime loads every interface, so
+ * src/ imports the interface modules directly instead.
+ */
+let barrel = `/** This file has been generated by \`task generate-protocol\`  */
+export { debug_counter } from "./protocol_registry.ts";
+`;
+for (const int of interfaces) {
+  barrel += `export * from "./${int.name}.ts";\n`;
+}
+await Bun.write(`${out_dir}/wayland.xml.ts`, barrel);
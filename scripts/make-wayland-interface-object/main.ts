@@ -41,7 +41,7 @@ if (!interfaceDeclaration) {
 }
 const is_global = process.env["GLOBAL"] == "1";
 let classContent = `
-import {${interfaceName} as d, ${object_name} as w} from "../protocols/wayland.xml.ts";
+import {${interfaceName} as d, ${object_name} as w} from "../protocols/${object_name}.ts";
 ${is_global ? "" : `import { Wayland_Client } from "../Wayland_Client.ts"`}
 import { Object_ID } from "../wayland_types.ts";
 
@@ -0,0 +1,277 @@
+/**
+ * Runs a command with its output going through an emulated slow
+ * link, like ssh over a 5 Mbit/s, 150 ms connection, without root
+ * or tc. Everything happens in this process:
+ *
+ * - The command's stdout is read only as fast as the link's send
+ *   buffer drains, so the command blocks on writes like it would
+ *   on a full socket.
+ * - Bytes leave at --bandwidth, then arrive --latency later, give
+ *   or take --jitter, in order like TCP.
+ * - What arrives goes to this terminal, or with --vt to an emulated
+ *   one (src/VT_Screen.ts) so it runs without a terminal, in CI.
+ *
+ * Frames are counted by the end of synchronized update marker
+ * (DEC mode 2026) that draw_desktop writes after every frame. On
+ * exit it reports frames sent and shown, frames per second as the
+ * viewer sees them, and how long frames took from being written to
+ * being shown.
+ *
+ * Usage: bun scripts/slow-link/main.ts [options] -- <command...>
+ *   --bandwidth <n>[k|m|g]bit  default 5mbit
+ *   --latency <ms>             one way, default 150
+ *   --jitter <ms>              default 0
+ *   --send-buffer <bytes>      default 262144, like a socket's
+ *   --vt <columns>x<rows>      draw to an emulated terminal
+ *   --duration <seconds>       stop the command after this long
+ */
+import Bun from "bun";
+import { VT_Screen } from "../../src/VT_Screen.ts";
+
+const end_of_frame = new TextEncoder().encode("\x1b[?2026l");
+
+/**
+ * Sent in pieces this big, so a frame trickles out
+ * over the link instead of arriving all at once
+ */
+const segment_bytes = 1460;
+
+const usage = () => {
+  console.error(
+    "Usage: bun scripts/slow-link/main.ts [--bandwidth 5mbit] [--latency 150] [--jitter 0] [--send-buffer 262144] [--vt 80x24] [--duration <seconds>] -- <command...>"
+  );
+  process.exit(1);
+};
+
+const parse_bandwidth = (text: string) => {
+  const match = /^(\d+(?:\.\d+)?)\s*([kmg]?)(?:bit)?$/i.exec(text);
+  if (!match) {
+    console.error(`--bandwidth ${text} is not like 5mbit`);
+    process.exit(1);
+  }
+  const scale = { "": 1, k: 1e3, m: 1e6, g: 1e9 }[match[2]!.toLowerCase()]!;
+  return Number(match[1]) * scale;
+};
+
+const parse_args = (argv: string[]) => {
+  const options = {
+    bits_per_second: 5e6,
+    latency: 0.15,
+    jitter: 0,
+    send_buffer_bytes: 256 * 1024,
+    vt: null as { columns: number; rows: number } | null,
+    duration: null as number | null,
+    command: [] as string[],
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i]!;
+    const value = () => argv[++i] ?? usage()!;
+    switch (arg) {
+      case "--bandwidth":
+        options.bits_per_second = parse_bandwidth(value());
+        break;
+      case "--latency":
+        options.latency = Number(value()) / 1000;
+        break;
+      case "--jitter":
+        options.jitter = Number(value()) / 1000;
+        break;
+      case "--send-buffer":
+        options.send_buffer_bytes = Number(value());
+        break;
+      case "--vt": {
+        const [columns, rows] = value().split("x").map(Number);
+        if (!columns || !rows) {
+          usage();
+        }
+        options.vt = { columns: columns!, rows: rows! };
+        break;
+      }
+      case "--duration":
+        options.duration = Number(value());
+        break;
+      case "--":
+        options.command = argv.slice(i + 1);
+        return options;
+      default:
+        usage();
+    }
+  }
+  return options;
+};
+
+/**
+ * Counts end of frame markers, including ones split
+ * between the end of one chunk and the start of the next
+ */
+class Frame_Counter {
+  matched = 0;
+
+  count = (data: Uint8Array) => {
+    let frames = 0;
+    for (const byte of data) {
+      if (byte === end_of_frame[this.matched]) {
+        this.matched++;
+        if (this.matched === end_of_frame.length) {
+          frames++;
+          this.matched = 0;
+        }
+      } else {
+        this.matched = byte === end_of_frame[0] ? 1 : 0;
+      }
+    }
+    return frames;
+  };
+}
+
+const now = () => performance.now() / 1000;
+
+const options = parse_args(Bun.argv.slice(2));
+if (options.command.length === 0) {
+  usage();
+}
+
+const screen = options.vt
+  ? new VT_Screen(options.vt.columns, options.vt.rows)
+  : null;
+
+const child = Bun.spawn(options.command, {
+  stdin: "inherit",
+  stdout: "pipe",
+  stderr: "inherit",
+  env: options.vt
+    ? {
+        ...process.env,
+        COLUMNS: String(options.vt.columns),
+        LINES: String(options.vt.rows),
+      }
+    : process.env,
+});
+
+const start = now();
+/**
+ * When the link is done sending what it has been given
+ */
+let link_free_at = start;
+let last_arrival = start;
+/**
+ * Bytes handed to the link that haven't been sent yet
+ */
+let unsent_bytes = 0;
+let bytes_sent = 0;
+
+const sent_frames = new Frame_Counter();
+const shown_frames = new Frame_Counter();
+/**
+ * When each frame that hasn't been shown yet was written
+ */
+const frame_written_at: number[] = [];
+const frame_latencies: number[] = [];
+let frames_written = 0;
+let first_frame_shown_at: number | null = null;
+let last_frame_shown_at = 0;
+
+let on_drained: (() => void) | null = null;
+
+const arrive = (segment: Uint8Array) => {
+  const frames = shown_frames.count(segment);
+  if (screen) {
+    screen.write(segment);
+  } else {
+    process.stdout.write(segment);
+  }
+  const t = now();
+  for (let i = 0; i < frames; i++) {
+    const written_at = frame_written_at.shift();
+    if (written_at !== undefined) {
+      frame_latencies.push(t - written_at);
+    }
+    first_frame_shown_at ??= t;
+    last_frame_shown_at = t;
+  }
+};
+
+const send = (data: Uint8Array) => {
+  const t = now();
+  const frames = sent_frames.count(data);
+  for (let i = 0; i < frames; i++) {
+    frame_written_at.push(t);
+  }
+  frames_written += frames;
+
+  for (let offset = 0; offset < data.length; offset += segment_bytes) {
+    const segment = data.subarray(offset, offset + segment_bytes);
+    link_free_at =
+      Math.max(link_free_at, t) + (segment.length * 8) / options.bits_per_second;
+    const jitter = (Math.random() * 2 - 1) * options.jitter;
+    /**
+     * In order, a late segment holds up the ones after it
+     */
+    const arrival = Math.max(
+      last_arrival,
+      link_free_at + options.latency + jitter
+    );
+    last_arrival = arrival;
+    const sent_at = link_free_at;
+
+    unsent_bytes += segment.length;
+    setTimeout(() => {
+      unsent_bytes -= segment.length;
+      bytes_sent += segment.length;
+      if (unsent_bytes <= options.send_buffer_bytes && on_drained) {
+        const resume = on_drained;
+        on_drained = null;
+        resume();
+      }
+    }, (sent_at - now()) * 1000);
+    setTimeout(() => arrive(segment), (arrival - now()) * 1000);
+  }
+};
+
+const percentile = (sorted: number[], p: number) =>
+  sorted.length === 0
+    ? 0
+    : sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))]!;
+
+const ms = (seconds: number) => `${(seconds * 1000).toFixed(0)}ms`;
+
+const report = () => {
+  const elapsed = now() - start;
+  const shown = frame_latencies.length;
+  const viewer_seconds =
+    first_frame_shown_at === null ? 0 : last_frame_shown_at - first_frame_shown_at;
+  const sorted = [...frame_latencies].sort((a, b) => a - b);
+  const lines = [
+    `link ${(options.bits_per_second / 1e6).toFixed(2)} Mbit/s, latency ${ms(options.latency)}, jitter ${ms(options.jitter)}`,
+    `${elapsed.toFixed(1)}s, ${bytes_sent} bytes sent, ${((bytes_sent * 8) / Math.max(elapsed, 1e-9) / 1e6).toFixed(2)} Mbit/s`,
+    `${frames_written} frames written, ${shown} shown, ${(shown > 1 ? (shown - 1) / viewer_seconds : 0).toFixed(1)} fps as the viewer sees it`,
+    `frame latency p50 ${ms(percentile(sorted, 0.5))}, p95 ${ms(percentile(sorted, 0.95))}, max ${ms(sorted.at(-1) ?? 0)}`,
+  ];
+  console.error(`\nslow-link: ${lines.join("\nslow-link: ")}`);
+};
+
+if (options.duration !== null) {
+  setTimeout(() => child.kill(), options.duration * 1000);
+}
+process.on("SIGINT", () => child.kill());
+
+const reader = child.stdout.getReader();
+while (true) {
+  const { done, value } = await reader.read();
+  if (done) {
+    break;
+  }
+  send(value);
+  if (unsent_bytes > options.send_buffer_bytes) {
+    await new Promise<void>((resolve) => {
+      on_drained = resolve;
+    });
+  }
+}
+await child.exited;
+/**
+ * Let what is still on the link arrive
+ */
+await Bun.sleep(Math.max(0, last_arrival - now()) * 1000 + 10);
+report();
+process.exit(child.exitCode ?? 0);
@@ -0,0 +1,570 @@
+/**
+ * A small wayland client that speaks the wire protocol by hand,
+ * so scripts/soak-test can run many of them without any apps
+ * installed. Each session connects, makes windows out of shm
+ * pools, draws frames into them, and then leaves, either
+ * tidily or by just closing the socket.
+ */
+import Bun from "bun";
+import {
+  closeSync,
+  existsSync,
+  ftruncateSync,
+  openSync,
+  unlinkSync,
+  writeSync,
+} from "node:fs";
+import { tmpdir } from "node:os";
+import { join } from "node:path";
+import c from "../../src/c_interop.ts";
+import {
+  get_message_and_file_descriptors,
+  send_message_and_file_descriptors,
+} from "../../src/c_promises.ts";
+
+/**
+ * Opcodes, from wayland.xml and xdg-shell.xml
+ */
+const request = {
+  wl_display: { sync: 0, get_registry: 1 },
+  wl_registry: { bind: 0 },
+  wl_compositor: { create_surface: 0 },
+  wl_shm: { create_pool: 0 },
+  wl_shm_pool: { create_buffer: 0, destroy: 1, resize: 2 },
+  wl_buffer: { destroy: 0 },
+  wl_surface: { destroy: 0, attach: 1, damage: 2, frame: 3, commit: 6 },
+  xdg_wm_base: { get_xdg_surface: 2, pong: 3 },
+  xdg_surface: { destroy: 0, get_toplevel: 1, ack_configure: 4 },
+  xdg_toplevel: { destroy: 0 },
+} as const;
+
+const event = {
+  wl_display: { error: 0, delete_id: 1 },
+  wl_registry: { global: 0 },
+  wl_callback: { done: 0 },
+  xdg_wm_base: { ping: 0 },
+  xdg_surface: { configure: 0 },
+} as const;
+
+const wl_display_id = 1;
+
+/**
+ * wl_shm_format argb8888 and xrgb8888
+ */
+const formats = [0, 1];
+
+const shm_directory = existsSync("/dev/shm") ? "/dev/shm" : tmpdir();
+
+/**
+ * Shm files are named after this, so the compositor's
+ * mappings of them can be counted in /proc/<pid>/maps
+ */
+export const shm_file_prefix = `soak-test-${process.pid}-`;
+
+let next_shm_file = 0;
+
+export const random_int = (min: number, max: number) =>
+  min + Math.floor(Math.random() * (max - min + 1));
+
+const text_encoder = new TextEncoder();
+const text_decoder = new TextDecoder();
+
+type Argument = number | string;
+
+const encode = (object_id: number, opcode: number, args: Argument[]) => {
+  let size = 8;
+  const strings = args.map((arg) => {
+    if (typeof arg === "number") {
+      size += 4;
+      return null;
+    }
+    const bytes = text_encoder.encode(arg);
+    /**
+     * Length, then the string with its NUL, padded to 4
+     */
+    size += 4 + ((bytes.length + 1 + 3) & ~3);
+    return bytes;
+  });
+  const message = new Uint8Array(size);
+  const view = new DataView(message.buffer);
+  view.setUint32(0, object_id, true);
+  view.setUint32(4, (size << 16) | opcode, true);
+  let offset = 8;
+  args.forEach((arg, i) => {
+    const bytes = strings[i];
+    if (bytes === null || bytes === undefined) {
+      view.setUint32(offset, (arg as number) >>> 0, true);
+      offset += 4;
+      return;
+    }
+    view.setUint32(offset, bytes.length + 1, true);
+    message.set(bytes, offset + 4);
+    offset += 4 + ((bytes.length + 1 + 3) & ~3);
+  });
+  return message;
+};
+
+const read_string = (body: DataView, offset: number) => {
+  const length = body.getUint32(offset, true);
+  const bytes = new Uint8Array(
+    body.buffer,
+    body.byteOffset + offset + 4,
+    Math.max(0, length - 1)
+  );
+  return text_decoder.decode(bytes);
+};
+
+/**
+ * Resolves to false if the promise took longer than timeout
+ */
+const within = (promise: Promise<unknown>, timeout_seconds: number) =>
+  Promise.race([
+    promise.then(() => true),
+    Bun.sleep(timeout_seconds * 1000).then(() => false),
+  ]);
+
+/**
+ * Frame intervals in 1 ms buckets, so a long
+ * run doesn't grow the script's own memory
+ */
+export class Interval_Histogram {
+  buckets = new Float64Array(2001);
+  count = 0;
+
+  add = (seconds: number) => {
+    this.buckets[Math.min(2000, Math.round(seconds * 1000))]!++;
+    this.count++;
+  };
+
+  /**
+   * @returns milliseconds
+   */
+  percentile = (p: number) => {
+    let seen = 0;
+    for (let ms = 0; ms < this.buckets.length; ms++) {
+      seen += this.buckets[ms]!;
+      if (seen > this.count * p) {
+        return ms;
+      }
+    }
+    return 0;
+  };
+}
+
+export class Soak_Stats {
+  sessions = 0;
+  abrupt_disconnects = 0;
+  windows = 0;
+  frames = 0;
+  frames_timed_out = 0;
+  pool_resizes = 0;
+  buffers_replaced = 0;
+  stray_file_descriptors = 0;
+  failed_connects = 0;
+  protocol_errors: string[] = [];
+  frame_intervals = new Interval_Histogram();
+}
+
+class Shm_Pool {
+  fd: number;
+  id: number;
+
+  constructor(
+    public client: Synthetic_Client,
+    public size: number
+  ) {
+    const path = join(shm_directory, `${shm_file_prefix}${next_shm_file++}`);
+    this.fd = openSync(path, "w+");
+    unlinkSync(path);
+    ftruncateSync(this.fd, size);
+    this.id = client.new_id();
+    client.send(
+      client.shm,
+      request.wl_shm.create_pool,
+      [this.id, size],
+      [this.fd]
+    );
+  }
+
+  grow = (size: number) => {
+    ftruncateSync(this.fd, size);
+    this.size = size;
+    this.client.send(this.id, request.wl_shm_pool.resize, [size]);
+  };
+
+  create_buffer = (offset: number, width: number, height: number) => {
+    const id = this.client.new_id();
+    const format = formats[random_int(0, formats.length - 1)]!;
+    this.client.send(this.id, request.wl_shm_pool.create_buffer, [
+      id,
+      offset,
+      width,
+      height,
+      width * 4,
+      format,
+    ]);
+    return { id, offset };
+  };
+
+  /**
+   * Draws a band of rows, enough that the
+   * compositor has something new to copy
+   */
+  draw = (offset: number, width: number, height: number, frame: number) => {
+    const rows = Math.min(height, 32);
+    const band = new Uint8Array(width * 4 * rows).fill(frame * 37);
+    const first_row = random_int(0, height - rows);
+    writeSync(this.fd, band, 0, band.length, offset + first_row * width * 4);
+  };
+
+  destroy = async (tidy: boolean) => {
+    if (tidy) {
+      this.client.send(this.id, request.wl_shm_pool.destroy, []);
+    }
+    /**
+     * Only once create_pool has gone out with it
+     */
+    await this.client.sending;
+    closeSync(this.fd);
+  };
+}
+
+export class Synthetic_Client {
+  socket = -1;
+  next_object_id = wl_display_id + 1;
+  /**
+   * The compositor closed the socket, get_message_and_file_descriptors
+   * closes it on our side too
+   */
+  closed_by_compositor = false;
+  open = false;
+
+  compositor = 0;
+  shm = 0;
+  wm_base = 0;
+  globals = new Map<string, { name: number; version: number }>();
+  handlers = new Map<number, (opcode: number, body: DataView) => void>();
+
+  read_buffer = new Uint8Array(64 * 1024);
+  read_file_descriptors = new Uint32Array(32);
+  unparsed = new Uint8Array(0);
+  reading: Promise<void> = Promise.resolve();
+  /**
+   * Requests go out in order, including the
+   * replies to pings sent from the read loop
+   */
+  sending: Promise<void> = Promise.resolve();
+
+  constructor(
+    public display_name: string,
+    public stats: Soak_Stats
+  ) {}
+
+  new_id = () => this.next_object_id++;
+
+  send = (
+    object_id: number,
+    opcode: number,
+    args: Argument[],
+    file_descriptors: number[] = []
+  ) => {
+    const message = encode(object_id, opcode, args);
+    this.sending = this.sending.then(async () => {
+      let offset = 0;
+      while (this.open && offset < message.length) {
+        const { should_continue, bytes_written } =
+          await send_message_and_file_descriptors(
+            this.socket,
+            message.subarray(offset),
+            Uint32Array.from(offset === 0 ? file_descriptors : [])
+          );
+        if (!should_continue) {
+          this.open = false;
+          return;
+        }
+        if (bytes_written === 0) {
+          await Bun.sleep(1);
+        }
+        offset += bytes_written;
+      }
+    });
+  };
+
+  read_loop = async () => {
+    while (this.open) {
+      const { should_continue, bytes_read, number_of_file_descriptors } =
+        await get_message_and_file_descriptors(
+          this.socket,
+          this.read_buffer,
+          this.read_file_descriptors
+        );
+      for (let i = 0; i < number_of_file_descriptors; i++) {
+        closeSync(this.read_file_descriptors[i]!);
+      }
+      if (!should_continue || bytes_read < 0) {
+        this.closed_by_compositor = true;
+        this.open = false;
+        return;
+      }
+      if (bytes_read > 0) {
+        this.consume(this.read_buffer.subarray(0, bytes_read));
+      }
+    }
+  };
+
+  consume = (data: Uint8Array) => {
+    const bytes = new Uint8Array(this.unparsed.length + data.length);
+    bytes.set(this.unparsed);
+    bytes.set(data, this.unparsed.length);
+    const view = new DataView(bytes.buffer);
+    let offset = 0;
+    while (offset + 8 <= bytes.length) {
+      const object_id = view.getUint32(offset, true);
+      const size_and_opcode = view.getUint32(offset + 4, true);
+      const size = size_and_opcode >>> 16;
+      if (size < 8 || offset + size > bytes.length) {
+        break;
+      }
+      const body = new DataView(bytes.buffer, offset + 8, size - 8);
+      this.handlers.get(object_id)?.(size_and_opcode & 0xffff, body);
+      offset += size;
+    }
+    this.unparsed = bytes.slice(offset);
+  };
+
+  on_display_event = (opcode: number, body: DataView) => {
+    switch (opcode) {
+      case event.wl_display.error:
+        this.stats.protocol_errors.push(
+          `object ${body.getUint32(0, true)} code ${body.getUint32(4, true)}: ${read_string(body, 8)}`
+        );
+        return;
+      case event.wl_display.delete_id:
+        this.handlers.delete(body.getUint32(0, true));
+        return;
+    }
+  };
+
+  /**
+   * @returns resolves on the callback's done event
+   */
+  callback = (make: (id: number) => void) => {
+    const { promise, resolve } = Promise.withResolvers<void>();
+    const id = this.new_id();
+    this.handlers.set(id, (opcode) => {
+      if (opcode === event.wl_callback.done) {
+        this.handlers.delete(id);
+        resolve();
+      }
+    });
+    make(id);
+    return promise;
+  };
+
+  round_trip = () =>
+    this.callback((id) =>
+      this.send(wl_display_id, request.wl_display.sync, [id])
+    );
+
+  bind = (interface_: string, version: number) => {
+    const global = this.globals.get(interface_);
+    if (!global) {
+      throw new Error(`The compositor has no ${interface_}`);
+    }
+    const id = this.new_id();
+    this.send(this.registry, request.wl_registry.bind, [
+      global.name,
+      interface_,
+      Math.min(version, global.version),
+      id,
+    ]);
+    return id;
+  };
+
+  registry = 0;
+
+  connect = async () => {
+    this.socket = c.connect_to_wayland_socket(this.display_name);
+    if (this.socket < 0) {
+      this.stats.failed_connects++;
+      return false;
+    }
+    this.open = true;
+    this.handlers.set(wl_display_id, this.on_display_event);
+    this.reading = this.read_loop();
+
+    this.registry = this.new_id();
+    this.handlers.set(this.registry, (opcode, body) => {
+      if (opcode !== event.wl_registry.global) {
+        return;
+      }
+      const name = body.getUint32(0, true);
+      const interface_ = read_string(body, 4);
+      const string_words = (body.getUint32(4, true) + 3) >>> 2;
+      const version = body.getUint32(8 + string_words * 4, true);
+      this.globals.set(interface_, { name, version });
+    });
+    this.send(wl_display_id, request.wl_display.get_registry, [this.registry]);
+    if (!(await within(this.round_trip(), 5))) {
+      return false;
+    }
+
+    this.compositor = this.bind("wl_compositor", 4);
+    this.shm = this.bind("wl_shm", 1);
+    this.wm_base = this.bind("xdg_wm_base", 1);
+    this.handlers.set(this.wm_base, (opcode, body) => {
+      if (opcode === event.xdg_wm_base.ping) {
+        this.send(this.wm_base, request.xdg_wm_base.pong, [
+          body.getUint32(0, true),
+        ]);
+      }
+    });
+    return true;
+  };
+
+  /**
+   * A toplevel that draws frames until it has drawn
+   * enough, or the session is cut short
+   */
+  run_window = async (tidy: boolean, deadline: number) => {
+    this.stats.windows++;
+    const width = random_int(32, 640);
+    const height = random_int(32, 480);
+    const buffer_bytes = width * height * 4;
+    const pool = new Shm_Pool(this, buffer_bytes * 2);
+    const buffers = [
+      pool.create_buffer(0, width, height),
+      pool.create_buffer(buffer_bytes, width, height),
+    ];
+
+    const surface = this.new_id();
+    this.send(this.compositor, request.wl_compositor.create_surface, [surface]);
+    const xdg_surface = this.new_id();
+    this.send(this.wm_base, request.xdg_wm_base.get_xdg_surface, [
+      xdg_surface,
+      surface,
+    ]);
+    const configured = Promise.withResolvers<void>();
+    this.handlers.set(xdg_surface, (opcode, body) => {
+      if (opcode === event.xdg_surface.configure) {
+        this.send(xdg_surface, request.xdg_surface.ack_configure, [
+          body.getUint32(0, true),
+        ]);
+        configured.resolve();
+      }
+    });
+    const toplevel = this.new_id();
+    this.send(xdg_surface, request.xdg_surface.get_toplevel, [toplevel]);
+    this.send(surface, request.wl_surface.commit, []);
+    await within(configured.promise, 5);
+
+    const frames = random_int(10, 300);
+    let last_done: number | null = null;
+    for (let frame = 0; frame < frames && this.open; frame++) {
+      if (!tidy && Math.random() < 1 / frames) {
+        /**
+         * Leave in the middle of drawing
+         */
+        break;
+      }
+      if (performance.now() / 1000 > deadline) {
+        break;
+      }
+      if (Math.random() < 0.02) {
+        /**
+         * Grow the pool and move a buffer into the new
+         * space, the old mapping has to go away once
+         * its buffers are released
+         */
+        const offset = pool.size;
+        pool.grow(pool.size + buffer_bytes);
+        const old = buffers.shift()!;
+        this.send(old.id, request.wl_buffer.destroy, []);
+        buffers.push(pool.create_buffer(offset, width, height));
+        this.stats.pool_resizes++;
+      } else if (Math.random() < 0.02) {
+        const old = buffers.shift()!;
+        this.send(old.id, request.wl_buffer.destroy, []);
+        buffers.push(pool.create_buffer(old.offset, width, height));
+        this.stats.buffers_replaced++;
+      }
+
+      const buffer = buffers[frame % buffers.length]!;
+      pool.draw(buffer.offset, width, height, frame);
+      this.send(surface, request.wl_surface.attach, [buffer.id, 0, 0]);
+      this.send(surface, request.wl_surface.damage, [0, 0, width, height]);
+      const done = this.callback((id) =>
+        this.send(surface, request.wl_surface.frame, [id])
+      );
+      this.send(surface, request.wl_surface.commit, []);
+      if (!(await within(done, 1))) {
+        this.stats.frames_timed_out++;
+        last_done = null;
+        continue;
+      }
+      const now = performance.now() / 1000;
+      if (last_done !== null) {
+        this.stats.frame_intervals.add(now - last_done);
+      }
+      last_done = now;
+      this.stats.frames++;
+    }
+
+    if (tidy && this.open) {
+      this.send(toplevel, request.xdg_toplevel.destroy, []);
+      this.send(xdg_surface, request.xdg_surface.destroy, []);
+      this.send(surface, request.wl_surface.destroy, []);
+      for (const buffer of buffers) {
+        this.send(buffer.id, request.wl_buffer.destroy, []);
+      }
+    }
+    this.handlers.delete(xdg_surface);
+    await pool.destroy(tidy && this.open);
+  };
+
+  /**
+   * One client's life, from connecting to disconnecting
+   */
+  run_session = async (deadline: number) => {
+    if (!(await this.connect())) {
+      await this.disconnect();
+      return;
+    }
+    this.stats.sessions++;
+    const tidy = Math.random() < 0.6;
+    const windows = random_int(1, 3);
+    await Promise.all(
+      Array.from({ length: windows }, () => this.run_window(tidy, deadline))
+    );
+    if (!tidy) {
+      this.stats.abrupt_disconnects++;
+    }
+    if (Math.random() < 0.1) {
+      /**
+       * An fd on a request to an object that doesn't exist, nothing
+       * claims it. Last, so it can't be mistaken for a later
+       * request's fd.
+       */
+      const fd = openSync("/dev/null", "r");
+      this.send(this.next_object_id + 1000, 0, [], [fd]);
+      await this.sending;
+      closeSync(fd);
+      this.stats.stray_file_descriptors++;
+    }
+    await this.disconnect();
+  };
+
+  disconnect = async () => {
+    await this.sending;
+    this.open = false;
+    /**
+     * The read loop gives up within 10 ms, close only after,
+     * so it can't read from an fd number that's been reused
+     */
+    await this.reading;
+    if (this.socket >= 0 && !this.closed_by_compositor) {
+      closeSync(this.socket);
+    }
+    this.socket = -1;
+  };
+}
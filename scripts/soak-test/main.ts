@@ -0,0 +1,230 @@
+/**
+ * Runs the compositor for a long time under synthetic clients
+ * (Synthetic_Client.ts) that connect, make shm pools, windows and
+ * buffers, resize and replace them, draw frames, and disconnect,
+ * some tidily and some by just closing the socket, so leaks that
+ * only show after hours show in minutes.
+ *
+ * Every --sample-seconds it reads the compositor's resident memory,
+ * open file descriptors and mappings of the clients' shm files from
+ * /proc. After --warmup, if the lowest value over the last quarter
+ * of the run is above the highest over the first quarter, it is
+ * growing without bound, and this exits with 1. Memory gets 10%
+ * slack for the allocator settling. Protocol errors fail it too,
+ * the clients only make valid requests.
+ *
+ * Usage: bun scripts/soak-test/main.ts [options]
+ *   --duration <seconds>        default 600
+ *   --clients <n>               at the same time, default 4
+ *   --sample-seconds <seconds>  default 5
+ *   --warmup <seconds>          not judged, default 60
+ *   --compositor <command>      default "bun src/index.ts", gets
+ *                               --wayland-display-name added
+ */
+import Bun from "bun";
+import { readdirSync, readFileSync, statSync } from "node:fs";
+import { join } from "node:path";
+import c from "../../src/c_interop.ts";
+import {
+  shm_file_prefix,
+  Soak_Stats,
+  Synthetic_Client,
+} from "./Synthetic_Client.ts";
+
+interface Sample {
+  seconds: number;
+  rss_kb: number;
+  file_descriptors: number;
+  shm_mappings: number;
+  mappings: number;
+}
+
+const usage = () => {
+  console.error(
+    'Usage: bun scripts/soak-test/main.ts [--duration 600] [--clients 4] [--sample-seconds 5] [--warmup 60] [--compositor "bun src/index.ts"]'
+  );
+  process.exit(1);
+};
+
+const parse_args = (argv: string[]) => {
+  const options = {
+    duration: 600,
+    clients: 4,
+    sample_seconds: 5,
+    warmup: 60,
+    compositor: ["bun", "src/index.ts"],
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i]!;
+    const value = () => argv[++i] ?? usage()!;
+    switch (arg) {
+      case "--duration":
+        options.duration = Number(value());
+        break;
+      case "--clients":
+        options.clients = Number(value());
+        break;
+      case "--sample-seconds":
+        options.sample_seconds = Number(value());
+        break;
+      case "--warmup":
+        options.warmup = Number(value());
+        break;
+      case "--compositor":
+        options.compositor = value().split(" ").filter(Boolean);
+        break;
+      default:
+        usage();
+    }
+  }
+  return options;
+};
+
+const now = () => performance.now() / 1000;
+
+const take_sample = (pid: number, seconds: number): Sample | null => {
+  try {
+    const status = readFileSync(`/proc/${pid}/status`, "utf8");
+    const maps = readFileSync(`/proc/${pid}/maps`, "utf8").split("\n");
+    return {
+      seconds,
+      rss_kb: Number(/VmRSS:\s+(\d+)/.exec(status)?.[1] ?? 0),
+      file_descriptors: readdirSync(`/proc/${pid}/fd`).length,
+      shm_mappings: maps.filter((line) => line.includes(shm_file_prefix))
+        .length,
+      mappings: maps.filter(Boolean).length,
+    };
+  } catch {
+    return null;
+  }
+};
+
+const format_sample = (sample: Sample) =>
+  `${sample.seconds.toFixed(0)}s rss ${(sample.rss_kb / 1024).toFixed(1)}MB, ${sample.file_descriptors} fds, ${sample.shm_mappings} shm mappings, ${sample.mappings} mappings`;
+
+/**
+ * @returns why it looks like a leak, or null
+ */
+const find_growth = (
+  samples: Sample[],
+  name: string,
+  value: (sample: Sample) => number,
+  slack: number
+) => {
+  const quarter = Math.floor(samples.length / 4);
+  const first = samples.slice(0, quarter).map(value);
+  const last = samples.slice(-quarter).map(value);
+  const first_max = Math.max(...first);
+  const last_min = Math.min(...last);
+  if (last_min > first_max * (1 + slack)) {
+    return `${name} grew: at most ${first_max} in the first quarter, at least ${last_min} in the last`;
+  }
+  return null;
+};
+
+const options = parse_args(Bun.argv.slice(2));
+
+const display_name = `soak-test-${process.pid}`;
+const compositor = Bun.spawn(
+  [...options.compositor, "--wayland-display-name", display_name],
+  {
+    cwd: join(import.meta.dir, "../.."),
+    stdin: "ignore",
+    stdout: "ignore",
+    stderr: "ignore",
+    env: { ...process.env, COLUMNS: "120", LINES: "40" },
+  }
+);
+let compositor_exited = false;
+compositor.exited.then(() => {
+  compositor_exited = true;
+});
+process.on("SIGINT", () => {
+  compositor.kill();
+  process.exit(1);
+});
+
+const socket_path = c.get_socket_path_from_name(display_name);
+const start = now();
+while (!statSync(socket_path, { throwIfNoEntry: false })) {
+  if (compositor_exited || now() - start > 30) {
+    console.error(`soak-test: the compositor didn't make ${socket_path}`);
+    compositor.kill();
+    process.exit(1);
+  }
+  await Bun.sleep(100);
+}
+
+const stats = new Soak_Stats();
+const deadline = now() + options.duration;
+
+const run_client = async () => {
+  while (now() < deadline && !compositor_exited) {
+    await new Synthetic_Client(display_name, stats).run_session(deadline);
+  }
+};
+const clients = Array.from({ length: options.clients }, run_client);
+
+const samples: Sample[] = [];
+while (now() < deadline && !compositor_exited) {
+  await Bun.sleep(options.sample_seconds * 1000);
+  const sample = take_sample(compositor.pid, now() - start);
+  if (!sample) {
+    break;
+  }
+  samples.push(sample);
+  console.error(
+    `soak-test: ${format_sample(sample)}, ${stats.sessions} sessions, ${stats.frames} frames`
+  );
+}
+await Promise.all(clients);
+
+/**
+ * With every client gone, what is left over
+ */
+await Bun.sleep(2000);
+const idle = take_sample(compositor.pid, now() - start);
+const exited_early = compositor_exited;
+compositor.kill();
+await compositor.exited;
+
+const failures: string[] = [];
+if (exited_early) {
+  failures.push(
+    `the compositor exited with ${compositor.signalCode ?? compositor.exitCode}`
+  );
+}
+if (stats.protocol_errors.length > 0) {
+  failures.push(
+    `${stats.protocol_errors.length} protocol errors, first: ${stats.protocol_errors[0]}`
+  );
+}
+const judged = samples.filter((sample) => sample.seconds >= options.warmup);
+if (judged.length >= 8) {
+  for (const failure of [
+    find_growth(judged, "rss", (sample) => sample.rss_kb, 0.1),
+    find_growth(judged, "fds", (sample) => sample.file_descriptors, 0),
+    find_growth(judged, "shm mappings", (sample) => sample.shm_mappings, 0),
+    find_growth(judged, "mappings", (sample) => sample.mappings, 0),
+  ]) {
+    if (failure) {
+      failures.push(failure);
+    }
+  }
+} else {
+  console.error(
+    `soak-test: only ${judged.length} samples after warmup, too few to judge growth`
+  );
+}
+
+const intervals = stats.frame_intervals;
+const lines = [
+  `${stats.sessions} sessions (${stats.abrupt_disconnects} abrupt), ${stats.windows} windows, ${stats.failed_connects} failed connects`,
+  `${stats.frames} frames, ${stats.frames_timed_out} timed out, interval p50 ${intervals.percentile(0.5)}ms, p99 ${intervals.percentile(0.99)}ms`,
+  `${stats.pool_resizes} pool resizes, ${stats.buffers_replaced} buffers replaced, ${stats.stray_file_descriptors} stray fds`,
+  ...(idle ? [`idle after: ${format_sample(idle)}`] : []),
+  ...failures.map((failure) => `FAIL ${failure}`),
+  failures.length === 0 ? "ok" : `${failures.length} failures`,
+];
+console.error(`soak-test: ${lines.join("\nsoak-test: ")}`);
+process.exit(failures.length === 0 ? 0 : 1);
@@ -0,0 +1,140 @@
+/**
+ * Replays a recording made with --record-output through
+ * an emulated terminal (src/VT_Screen.ts).
+ *
+ * The emitted bytes of every frame are written on top of the
+ * previous frames, like a real terminal would see them. Each
+ * frame's reference (a full repaint) is written to a fresh
+ * screen. If the two screens disagree on any cell the reference
+ * drew, then the emitted output would corrupt the picture.
+ *
+ * Also reports bytes and escape sequences by type, for both
+ * the emitted stream and the references, so output optimizations
+ * can be measured.
+ *
+ * Usage: bun scripts/vt-harness/main.ts <recording> [--verbose]
+ */
+import Bun from "bun";
+import {
+  VT_Screen,
+  VT_Sequence_Category,
+  VT_Sequence_Stats,
+} from "../../src/VT_Screen.ts";
+
+interface Recorded_Frame {
+  columns: number;
+  rows: number;
+  reference: Uint8Array;
+  emitted: Uint8Array;
+}
+
+const read_recording = (data: Uint8Array): Recorded_Frame[] => {
+  const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+  const frames: Recorded_Frame[] = [];
+  let frame: Partial<Recorded_Frame> = {};
+  let offset = 0;
+  while (offset + 5 <= data.length) {
+    const tag = String.fromCharCode(data[offset]!);
+    const length = view.getUint32(offset + 1, true);
+    const payload = data.subarray(offset + 5, offset + 5 + length);
+    offset += 5 + length;
+    if (payload.length < length) {
+      console.error("Recording is truncated, ignoring the last frame");
+      break;
+    }
+    switch (tag) {
+      case "S":
+        frame = {
+          columns: view.getUint32(offset - length, true),
+          rows: view.getUint32(offset - length + 4, true),
+        };
+        break;
+      case "R":
+        frame.reference = payload;
+        break;
+      case "E":
+        frame.emitted = payload;
+        frames.push(frame as Recorded_Frame);
+        break;
+      default:
+        console.error(`Unknown record ${tag}, is this a recording?`);
+        process.exit(1);
+    }
+  }
+  return frames;
+};
+
+const show_cell = (char: string, style: string) =>
+  `${JSON.stringify(char)} ${style.replace(/\|+$/, "") || "default"}`;
+
+const print_stats = (
+  title: string,
+  stats: Map<VT_Sequence_Category, VT_Sequence_Stats>
+) => {
+  const total = [...stats.values()].reduce((sum, s) => sum + s.bytes, 0);
+  console.log(`\n${title}: ${total} bytes`);
+  const sorted = [...stats.entries()].sort((a, b) => b[1].bytes - a[1].bytes);
+  for (const [category, { count, bytes }] of sorted) {
+    const percent = total === 0 ? 0 : (bytes / total) * 100;
+    console.log(
+      `  ${category.padEnd(8)} ${String(count).padStart(10)} sequences ${String(bytes).padStart(12)} bytes ${percent.toFixed(1).padStart(5)}%`
+    );
+  }
+};
+
+const path = Bun.argv[2];
+const verbose = Bun.argv.includes("--verbose");
+if (!path) {
+  console.error("Usage: bun scripts/vt-harness/main.ts <recording> [--verbose]");
+  process.exit(1);
+}
+
+const frames = read_recording(new Uint8Array(await Bun.file(path).arrayBuffer()));
+if (frames.length === 0) {
+  console.error("No frames in the recording");
+  process.exit(1);
+}
+
+const screen = new VT_Screen(frames[0]!.columns, frames[0]!.rows);
+const reference_stats = new Map<VT_Sequence_Category, VT_Sequence_Stats>();
+let bad_frames = 0;
+
+for (const [index, frame] of frames.entries()) {
+  if (frame.columns !== screen.columns || frame.rows !== screen.rows) {
+    screen.resize(frame.columns, frame.rows);
+  }
+  screen.write(frame.emitted);
+
+  const reference = new VT_Screen(frame.columns, frame.rows);
+  reference.stats = reference_stats;
+  reference.write(frame.reference);
+
+  const mismatches = screen.diff(reference);
+  if (mismatches.length === 0) {
+    continue;
+  }
+  bad_frames++;
+  console.log(
+    `frame ${index}: ${mismatches.length} cells differ from a full repaint`
+  );
+  for (const m of mismatches.slice(0, verbose ? mismatches.length : 5)) {
+    console.log(
+      `  row ${m.row} column ${m.column}: expected ${show_cell(m.expected.char, m.expected.style)}, got ${show_cell(m.actual.char, m.actual.style)}`
+    );
+  }
+}
+
+print_stats(`Emitted, ${frames.length} frames`, screen.stats);
+print_stats(`Full repaints, ${frames.length} frames`, reference_stats);
+
+const emitted_bytes = frames.reduce((sum, f) => sum + f.emitted.length, 0);
+const reference_bytes = frames.reduce((sum, f) => sum + f.reference.length, 0);
+console.log(
+  `\nEmitted ${((emitted_bytes / Math.max(1, reference_bytes)) * 100).toFixed(1)}% of the bytes of full repaints, ${(emitted_bytes / frames.length).toFixed(0)} bytes per frame`
+);
+
+if (bad_frames > 0) {
+  console.log(`\n${bad_frames} of ${frames.length} frames are corrupted`);
+  process.exit(1);
+}
+console.log(`\nAll ${frames.length} frames match a full repaint`);
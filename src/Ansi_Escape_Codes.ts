@@ -7,6 +7,11 @@ export enum Ansi_Escape_Codes {
 
   hide_cursor = "\x1b[?25l",
   show_cursor = "\x1b[?25h",
+  /**
+   * OSC 22, the shape of the terminal's mouse pointer
+   */
+  set_pointer_shape = "\x1b]22;",
+  default_pointer_shape = "\x1b]22;default\x1b\\",
   reset = "\x1b[0m",
   fgBlack = "\x1b[30m",
   bgWhite = "\x1b[47m",
@@ -0,0 +1,40 @@
+/**
+ * Picks the motion scale for --motion-scale auto: the biggest
+ * one at which a frame of the desktop still gets through the
+ * link to the terminal within one frame time.
+ *
+ * An image at scale s is about s * s the bytes of a full
+ * resolution one, so every frame drawn tells us roughly what
+ * a full resolution frame costs.
+ */
+const full_frame_bytes_alpha = 1 / 8;
+
+export class Auto_Motion_Scale {
+  /**
+   * Smoothed, null until the desktop was drawn
+   */
+  full_frame_bytes: number | null = null;
+
+  on_frame = (desktop_bytes: number, pixel_scale: number) => {
+    if (desktop_bytes <= 0) {
+      return;
+    }
+    const full = desktop_bytes / (pixel_scale * pixel_scale);
+    this.full_frame_bytes =
+      this.full_frame_bytes === null
+        ? full
+        : (1 - full_frame_bytes_alpha) * this.full_frame_bytes +
+          full_frame_bytes_alpha * full;
+  };
+
+  /**
+   * @param throughput bytes per second, null if not measured yet
+   */
+  pick = (throughput: number | null, frame_time_seconds: number) => {
+    if (throughput === null || this.full_frame_bytes === null) {
+      return 1;
+    }
+    const budget = throughput * frame_time_seconds;
+    return Math.min(1, Math.sqrt(budget / this.full_frame_bytes));
+  };
+}
@@ -1,31 +1,18 @@
-import {
-  Canvas,
-  CanvasRenderingContext2D,
-  createCanvas,
-  Image,
-  loadImage,
-} from "canvas";
+import { createCanvas, loadImage } from "canvas";
 import { Size } from "./Size.ts";
 import { Wayland_Client } from "./Wayland_Client.ts";
 import { wl_surface } from "./objects/wl_surface.ts";
 import { Buffer } from "buffer";
+import c, { Draw_Item, Draw_State, Native_Texture } from "./c_interop.ts";
+import { Pixels } from "./Terminal_Window.ts";
 //@ts-ignore
 import icon from "../resources/icon.png" with { type: "file" };
 
 export class Canvas_Desktop {
-  canvas: Canvas;
-  context: CanvasRenderingContext2D;
-  icon_image: Image | null = null;
+  icon_texture: Native_Texture | null = null;
   after_opening_timeout = false;
 
-  draw_image = (image: Image | null, x: number, y: number) => {
-    if (!image) {
-      return;
-    }
-    this.context.drawImage(image, x, y);
-  };
-
-  constructor(size: Size, will_show_app_right_at_startup: boolean) {
+  constructor(public size: Size, will_show_app_right_at_startup: boolean) {
     /**
      * If we will show an app right at startup,
      * we want to wait a bit before potentially
@@ -42,21 +29,34 @@ export class Canvas_Desktop {
       });
     }
 
-    this.canvas = createCanvas(size.width, size.height);
-
-    this.context = this.canvas.getContext("2d")!;
     Bun.file(icon)
       .arrayBuffer()
       .then(async (buffer) => {
-        this.icon_image = await loadImage(Buffer.from(buffer));
+        const image = await loadImage(Buffer.from(buffer));
+        /**
+         * Drawn once into a canvas to get the
+         * pixels in the layout textures use
+         */
+        const canvas = createCanvas(image.width, image.height);
+        canvas.getContext("2d").drawImage(image, 0, 0);
+        this.icon_texture = c.create_texture(
+          canvas.toBuffer("raw"),
+          image.width as Pixels,
+          image.height as Pixels
+        );
       });
   }
-  draw_clients = (clients: Set<Wayland_Client>) => {
+
+  /**
+   * Publishes the desktop for this frame,
+   * draw_desktop draws whatever was published last.
+   */
+  draw_clients = (clients: Set<Wayland_Client>, draw_state: Draw_State) => {
     /**
      * Do z sorting
      * of all drawable surfaces
      */
-    const sorted_surfaces: [wl_surface, Canvas][] = [];
+    const sorted_surfaces: wl_surface[] = [];
     for (const s of clients) {
       for (const surface_id of s.drawable_surfaces) {
         const surface = s.get_object(surface_id)?.delegate;
@@ -66,25 +66,37 @@ export class Canvas_Desktop {
         if (!surface.texture) {
           continue;
         }
-        if (!surface.texture.canvas) {
-          continue;
-        }
 
-        sorted_surfaces.push([surface, surface.texture.canvas]);
+        sorted_surfaces.push(surface);
       }
     }
     sorted_surfaces.sort((a, b) => {
-      return a[0].position.z - b[0].position.z;
+      return a.position.z - b.position.z;
     });
 
-    this.context.clearRect(0, 0, this.canvas.width, this.canvas.height);
+    const draw_list: Draw_Item[] = sorted_surfaces.map((surface) => ({
+      texture: surface.texture!.native,
+      x: surface.position.x as Pixels,
+      y: surface.position.y as Pixels,
+    }));
 
-    if (sorted_surfaces.length <= 0 && this.after_opening_timeout) {
-      this.draw_image(this.icon_image, 0, 0);
+    if (
+      draw_list.length <= 0 &&
+      this.after_opening_timeout &&
+      this.icon_texture
+    ) {
+      draw_list.push({
+        texture: this.icon_texture,
+        x: 0 as Pixels,
+        y: 0 as Pixels,
+      });
     }
 
-    for (const [surface, texture] of sorted_surfaces) {
-      this.context.drawImage(texture, surface.position.x, surface.position.y);
-    }
+    c.publish_compositor_snapshot(
+      draw_state,
+      this.size.width as Pixels,
+      this.size.height as Pixels,
+      draw_list
+    );
   };
 }
@@ -0,0 +1,122 @@
+/**
+ * Frame timing, and how long input takes to show up on
+ * screen. With --replay-input this is a repeatable
+ * "typing latency" or "scroll fps" benchmark.
+ */
+
+export interface Frame_Stats_Summary {
+  frames: number;
+  /**
+   * frames that wrote something to the terminal
+   */
+  frames_drawn: number;
+  seconds: number;
+  frames_per_second: number;
+  drawn_frames_per_second: number;
+  frame_time: Percentiles;
+  /**
+   * from reading input to the end of the first
+   * frame after it that drew something
+   */
+  input_latency: Percentiles;
+  bytes_written: number;
+}
+
+export interface Percentiles {
+  p50: number;
+  p95: number;
+  p99: number;
+  max: number;
+}
+
+const percentiles = (values: number[]): Percentiles => {
+  if (values.length === 0) {
+    return { p50: 0, p95: 0, p99: 0, max: 0 };
+  }
+  const sorted = [...values].sort((a, b) => a - b);
+  const at = (fraction: number) =>
+    sorted[Math.min(sorted.length - 1, Math.floor(fraction * sorted.length))]!;
+  return {
+    p50: at(0.5),
+    p95: at(0.95),
+    p99: at(0.99),
+    max: sorted[sorted.length - 1]!,
+  };
+};
+
+/**
+ * Percentiles are over the most recent samples,
+ * so a long session doesn't grow without bound
+ */
+const max_samples = 10_000;
+
+const add_sample = (samples: number[], value: number) => {
+  if (samples.length >= max_samples) {
+    samples.splice(0, max_samples / 2);
+  }
+  samples.push(value);
+};
+
+export class Frame_Stats {
+  start = performance.now() / 1000;
+  frames = 0;
+  frames_drawn = 0;
+  bytes_written = 0;
+  frame_times: number[] = [];
+  input_latencies: number[] = [];
+  /**
+   * Input read since the last drawn frame
+   */
+  pending_input_times: number[] = [];
+
+  on_input = (now: number = performance.now() / 1000) => {
+    this.pending_input_times.push(now);
+  };
+
+  /**
+   * @param frame_start seconds, same clock as performance.now() / 1000
+   */
+  on_frame = (
+    frame_start: number,
+    bytes_written: number,
+    now: number = performance.now() / 1000
+  ) => {
+    this.frames++;
+    add_sample(this.frame_times, now - frame_start);
+    if (bytes_written <= 0) {
+      return;
+    }
+    this.frames_drawn++;
+    this.bytes_written += bytes_written;
+    for (const input_time of this.pending_input_times) {
+      add_sample(this.input_latencies, now - input_time);
+    }
+    this.pending_input_times = [];
+  };
+
+  summary = (now: number = performance.now() / 1000): Frame_Stats_Summary => {
+    const seconds = now - this.start;
+    return {
+      frames: this.frames,
+      frames_drawn: this.frames_drawn,
+      seconds,
+      frames_per_second: seconds > 0 ? this.frames / seconds : 0,
+      drawn_frames_per_second: seconds > 0 ? this.frames_drawn / seconds : 0,
+      frame_time: percentiles(this.frame_times),
+      input_latency: percentiles(this.input_latencies),
+      bytes_written: this.bytes_written,
+    };
+  };
+}
+
+const ms = (seconds: number) => `${(seconds * 1000).toFixed(1)}ms`;
+const show_percentiles = (p: Percentiles) =>
+  `p50 ${ms(p.p50)} p95 ${ms(p.p95)} p99 ${ms(p.p99)} max ${ms(p.max)}`;
+
+export const format_frame_stats = (s: Frame_Stats_Summary) =>
+  [
+    `${s.frames} frames (${s.frames_drawn} drawn) in ${s.seconds.toFixed(2)}s, ${s.frames_per_second.toFixed(1)} fps, ${s.drawn_frames_per_second.toFixed(1)} drawn fps`,
+    `frame time     ${show_percentiles(s.frame_time)}`,
+    `input latency  ${show_percentiles(s.input_latency)}`,
+    `${(s.bytes_written / (1024 * 1024)).toFixed(2)}MB written`,
+  ].join("\n");
@@ -4,15 +4,10 @@ import { wl_seat, make_wl_seat } from "./objects/wl_seat.ts";
 import { wl_shm, make_wl_shm } from "./objects/wl_shm.ts";
 import { wl_keyboard, make_wl_keyboard } from "./objects/wl_keyboard.ts";
 import { wl_compositor, make_wl_compositor } from "./objects/wl_compositor.ts";
-import { zxdg_decoration_manager_v1, make_zxdg_decoration_manager_v1 } from "./objects/zxdg_decoration_manager_v1.ts";
-import { wl_pointer } from "./protocols/wayland.xml.ts";
 import { wl_subcompositor, make_wl_subcompositor } from "./objects/wl_subcompositor.ts";
 import { xdg_wm_base, make_xdg_wm_base } from "./objects/xdg_wm_base.ts";
-import { wl_data_device_manager, make_wl_data_device_manager } from "./objects/wl_data_device_manager.ts";
-import { pointer } from "./objects/wl_pointer.ts";
-import { zwp_xwayland_keyboard_grab_manager_v1, make_zwp_xwayland_keyboard_grab_manager_v1 } from "./objects/zwp_xwayland_keyboard_grab_manager_v1.ts";
-import { xwayland_shell_v1, make_xwayland_shell_v1 } from "./objects/xwayland_shell_v1.ts";
 import { wl_touch, make_wl_touch } from "./objects/wl_touch.ts";
+import { load_protocol } from "./protocols/protocol_registry.ts";
 export enum Global_Ids {
   wl_display = 1,
   wl_compositor = 0xff00_000,
@@ -29,7 +24,17 @@ export enum Global_Ids {
   wl_data_device,
   wl_touch,
   zxdg_decoration_manager_v1,
+  wp_cursor_shape_manager_v1,
+  wp_fifo_manager_v1,
+  wp_commit_timing_manager_v1,
 }
+/**
+ * Apps are spawned as soon as the socket is listening,
+ * so only the globals every client binds are imported up front.
+ * The rest (data device, decorations, cursor shapes, frame pacing,
+ * xwayland, keyboard grab)
+ * and the interfaces they create are loaded on the first bind.
+ */
 let seat: any;
 let display: any;
 let output: any;
@@ -44,6 +49,9 @@ let zwpXwaylandKeyboardGrabManager: any;
 let xwaylandShell: any;
 let wlTouch: any;
 let zxdgDecorationManager: any;
+let wpCursorShapeManager: any;
+let wpFifoManager: any;
+let wpCommitTimingManager: any;
 const globals = {
   get [1]() {
     if (!display) {
@@ -89,6 +97,7 @@ const globals = {
   },
   get [Global_Ids.wl_data_device_manager]() {
     if (!dataDeviceManager) {
+      const { make_wl_data_device_manager } = require("./objects/wl_data_device_manager.ts");
       dataDeviceManager = make_wl_data_device_manager();
     }
     return dataDeviceManager;
@@ -101,7 +110,7 @@ const globals = {
   },
   get [Global_Ids.wl_pointer]() {
     if (!wlPointer) {
-      const { wl_pointer: WlPointerProtocol } = require("./protocols/wayland.xml.ts");
+      const WlPointerProtocol = load_protocol("wl_pointer");
       const { pointer } = require("./objects/wl_pointer.ts");
       wlPointer = new WlPointerProtocol(pointer);
     }
@@ -109,12 +118,14 @@ const globals = {
   },
   get [Global_Ids.zwp_xwayland_keyboard_grab_manager_v1]() {
     if (!zwpXwaylandKeyboardGrabManager) {
+      const { make_zwp_xwayland_keyboard_grab_manager_v1 } = require("./objects/zwp_xwayland_keyboard_grab_manager_v1.ts");
       zwpXwaylandKeyboardGrabManager = make_zwp_xwayland_keyboard_grab_manager_v1();
     }
     return zwpXwaylandKeyboardGrabManager;
   },
   get [Global_Ids.xwayland_shell_v1]() {
     if (!xwaylandShell) {
+      const { make_xwayland_shell_v1 } = require("./objects/xwayland_shell_v1.ts");
       xwaylandShell = make_xwayland_shell_v1();
     }
     return xwaylandShell;
@@ -130,10 +141,32 @@ const globals = {
   },
   get [Global_Ids.zxdg_decoration_manager_v1]() {
     if (!zxdgDecorationManager) {
+      const { make_zxdg_decoration_manager_v1 } = require("./objects/zxdg_decoration_manager_v1.ts");
       zxdgDecorationManager = make_zxdg_decoration_manager_v1();
     }
     return zxdgDecorationManager;
   },
+  get [Global_Ids.wp_cursor_shape_manager_v1]() {
+    if (!wpCursorShapeManager) {
+      const { make_wp_cursor_shape_manager_v1 } = require("./objects/wp_cursor_shape_manager_v1.ts");
+      wpCursorShapeManager = make_wp_cursor_shape_manager_v1();
+    }
+    return wpCursorShapeManager;
+  },
+  get [Global_Ids.wp_fifo_manager_v1]() {
+    if (!wpFifoManager) {
+      const { make_wp_fifo_manager_v1 } = require("./objects/wp_fifo_manager_v1.ts");
+      wpFifoManager = make_wp_fifo_manager_v1();
+    }
+    return wpFifoManager;
+  },
+  get [Global_Ids.wp_commit_timing_manager_v1]() {
+    if (!wpCommitTimingManager) {
+      const { make_wp_commit_timing_manager_v1 } = require("./objects/wp_commit_timing_manager_v1.ts");
+      wpCommitTimingManager = make_wp_commit_timing_manager_v1();
+    }
+    return wpCommitTimingManager;
+  },
 };
 
 export class GlobalObjects {
@@ -176,6 +209,21 @@ export const advertised_global_objects_names = [
     id: Global_Ids.zxdg_decoration_manager_v1,
     version: 1,
   },
+  {
+    name: "wp_cursor_shape_manager_v1",
+    id: Global_Ids.wp_cursor_shape_manager_v1,
+    version: 1,
+  },
+  {
+    name: "wp_fifo_manager_v1",
+    id: Global_Ids.wp_fifo_manager_v1,
+    version: 1,
+  },
+  {
+    name: "wp_commit_timing_manager_v1",
+    id: Global_Ids.wp_commit_timing_manager_v1,
+    version: 1,
+  },
   /**
    * @TODO only advertise these to Xwayland clients
    */
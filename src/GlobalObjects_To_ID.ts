@@ -1,20 +1,21 @@
 import { Global_Ids } from "./GlobalObjects.ts";
-import {
-  wl_compositor,
-  wl_data_device_manager,
-  wl_display,
-  wl_keyboard,
-  wl_output,
-  wl_pointer,
-  wl_seat,
-  wl_shm,
-  wl_subcompositor,
-  wl_touch,
-  xdg_wm_base,
-  xwayland_shell_v1,
-  zwp_xwayland_keyboard_grab_manager_v1,
-  zxdg_decoration_manager_v1,
-} from "./protocols/wayland.xml.ts";
+import type { wl_compositor } from "./protocols/wl_compositor.ts";
+import type { wl_data_device_manager } from "./protocols/wl_data_device_manager.ts";
+import type { wl_display } from "./protocols/wl_display.ts";
+import type { wl_keyboard } from "./protocols/wl_keyboard.ts";
+import type { wl_output } from "./protocols/wl_output.ts";
+import type { wl_pointer } from "./protocols/wl_pointer.ts";
+import type { wl_seat } from "./protocols/wl_seat.ts";
+import type { wl_shm } from "./protocols/wl_shm.ts";
+import type { wl_subcompositor } from "./protocols/wl_subcompositor.ts";
+import type { wl_touch } from "./protocols/wl_touch.ts";
+import type { xdg_wm_base } from "./protocols/xdg_wm_base.ts";
+import type { xwayland_shell_v1 } from "./protocols/xwayland_shell_v1.ts";
+import type { zwp_xwayland_keyboard_grab_manager_v1 } from "./protocols/zwp_xwayland_keyboard_grab_manager_v1.ts";
+import type { zxdg_decoration_manager_v1 } from "./protocols/zxdg_decoration_manager_v1.ts";
+import type { wp_cursor_shape_manager_v1 } from "./protocols/wp_cursor_shape_manager_v1.ts";
+import type { wp_fifo_manager_v1 } from "./protocols/wp_fifo_manager_v1.ts";
+import type { wp_commit_timing_manager_v1 } from "./protocols/wp_commit_timing_manager_v1.ts";
 import { Object_ID } from "./wayland_types.ts";
 
 export type Global_ID_To_Object_ID<T extends Global_Ids> = Object_ID<
@@ -92,4 +93,16 @@ export type GlobalObjects_To_Object_Type_Union =
   | {
       id: Global_Ids.zxdg_decoration_manager_v1;
       object_type: zxdg_decoration_manager_v1;
+    }
+  | {
+      id: Global_Ids.wp_cursor_shape_manager_v1;
+      object_type: wp_cursor_shape_manager_v1;
+    }
+  | {
+      id: Global_Ids.wp_fifo_manager_v1;
+      object_type: wp_fifo_manager_v1;
+    }
+  | {
+      id: Global_Ids.wp_commit_timing_manager_v1;
+      object_type: wp_commit_timing_manager_v1;
     };
@@ -0,0 +1,82 @@
+/**
+ * Records the raw chunks read from stdin, with when they
+ * were read, and plays them back through the same decoding
+ * as live input. Interactive benchmarks (typing, scrolling,
+ * dragging a window) can then be run the same way every time.
+ *
+ * The file is a list of records: a float64 (little endian)
+ * of seconds since the recording started, a uint32 length,
+ * then that many bytes of stdin.
+ */
+import Bun from "bun";
+
+const record_header_size = 12;
+
+export interface Recorded_Input {
+  seconds: number;
+  chunk: Uint8Array;
+}
+
+export class Input_Recorder {
+  writer: ReturnType<ReturnType<typeof Bun.file>["writer"]>;
+  start = performance.now() / 1000;
+
+  constructor(path: string) {
+    this.writer = Bun.file(path).writer();
+  }
+
+  record = (chunk: Uint8Array) => {
+    const header = new DataView(new ArrayBuffer(record_header_size));
+    header.setFloat64(0, performance.now() / 1000 - this.start, true);
+    header.setUint32(8, chunk.length, true);
+    this.writer.write(new Uint8Array(header.buffer));
+    this.writer.write(chunk);
+    /**
+     * Input is small and rare, flush so a
+     * crash doesn't lose the end of it
+     */
+    this.writer.flush();
+  };
+}
+
+export const read_input_recording = async (
+  path: string
+): Promise<Recorded_Input[]> => {
+  const data = new Uint8Array(await Bun.file(path).arrayBuffer());
+  const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+  const inputs: Recorded_Input[] = [];
+  let offset = 0;
+  while (offset + record_header_size <= data.length) {
+    const seconds = view.getFloat64(offset, true);
+    const length = view.getUint32(offset + 8, true);
+    const chunk = data.subarray(
+      offset + record_header_size,
+      offset + record_header_size + length
+    );
+    offset += record_header_size + length;
+    if (chunk.length < length) {
+      console.error("Input recording is truncated, ignoring the last chunk");
+      break;
+    }
+    inputs.push({ seconds, chunk });
+  }
+  return inputs;
+};
+
+/**
+ * @param speed 1 for the recorded timing, 2 for twice as fast,
+ * 0 for as fast as possible (one chunk per turn of the event loop)
+ */
+export async function* replay_input(
+  path: string,
+  speed: number
+): AsyncGenerator<Uint8Array> {
+  const inputs = await read_input_recording(path);
+  const start = performance.now() / 1000;
+  for (const { seconds, chunk } of inputs) {
+    const wait =
+      speed > 0 ? seconds / speed - (performance.now() / 1000 - start) : 0;
+    await Bun.sleep(Math.max(0, wait * 1000));
+    yield chunk;
+  }
+}
@@ -0,0 +1,275 @@
+/**
+ * Estimates the round trip time and throughput of the path
+ * to the user's terminal (a local pty, or ssh from the other
+ * side of the world) by asking the terminal for a
+ * Device Status Report and timing the reply.
+ *
+ * A probe is sent right after a frame, so the terminal has
+ * to take in that frame before it can answer. The smallest
+ * recent round trip is the latency of the link, anything on
+ * top of that is time spent draining the frame.
+ *
+ * The reply can't say which probe it answers, but terminals
+ * answer in order, so every probe is remembered until its reply
+ * (even once it counts as lost), and a reply goes to the oldest.
+ */
+
+/**
+ * The terminal answers "\x1b[0n" (terminal ok)
+ */
+const device_status_report = "\x1b[5n";
+const device_status_ok = [0x1b, 0x5b, 0x30, 0x6e];
+
+/**
+ * Same as TCP (RFC 6298)
+ */
+const rtt_alpha = 1 / 8;
+const rtt_variance_beta = 1 / 4;
+const throughput_alpha = 1 / 8;
+
+/**
+ * Drain times shorter than this are within the noise,
+ * the link is faster than we can measure with one frame.
+ */
+const min_drain_seconds = 0.002;
+const min_rtt_window = 16;
+
+/**
+ * A lost probe is still waited on for its late reply this
+ * long, then forgotten, in case the terminal never answers
+ */
+const forget_probe_seconds = 60;
+
+interface Probe {
+  sent_at: number;
+  bytes_ahead: number;
+  lost: boolean;
+}
+
+export interface Link_Stats {
+  /**
+   * seconds, null until the first reply
+   */
+  smoothed_rtt: number | null;
+  rtt_variance: number | null;
+  min_rtt: number | null;
+  /**
+   * bytes per second, null until a frame took
+   * long enough to drain to measure
+   */
+  throughput: number | null;
+  probes_sent: number;
+  probes_lost: number;
+  bytes_written: number;
+}
+
+export class Link_Estimator {
+  probe_interval_seconds = 1;
+  /**
+   * A probe with no reply after this long is lost,
+   * (the terminal doesn't answer DSR, or the link stalled)
+   */
+  probe_timeout_seconds = 5;
+
+  /**
+   * Oldest first, every probe without a reply yet
+   */
+  probes: Probe[] = [];
+  last_probe_at = 0;
+  /**
+   * The end of the last chunk, if it could be
+   * the start of a reply split across reads
+   */
+  held_input: number[] = [];
+
+  recent_rtts: number[] = [];
+  smoothed_rtt: number | null = null;
+  rtt_variance: number | null = null;
+  throughput: number | null = null;
+
+  probes_sent = 0;
+  probes_lost = 0;
+  bytes_written = 0;
+
+  constructor(public enabled: boolean = process.stdout.isTTY === true) {}
+
+  /**
+   * Call after writing a frame to the terminal, with
+   * how many bytes the frame was. Might send a probe.
+   */
+  after_frame = (bytes_written: number, now: number = performance.now() / 1000) => {
+    this.bytes_written += bytes_written;
+    if (!this.enabled) {
+      return;
+    }
+    while (
+      this.probes.length > 0 &&
+      now - this.probes[0]!.sent_at > forget_probe_seconds
+    ) {
+      this.probes.shift();
+    }
+    const newest = this.probes[this.probes.length - 1];
+    if (newest && !newest.lost) {
+      if (now - newest.sent_at < this.probe_timeout_seconds) {
+        return;
+      }
+      this.probes_lost++;
+      newest.lost = true;
+    }
+    if (now - this.last_probe_at < this.probe_interval_seconds) {
+      return;
+    }
+    process.stdout.write(device_status_report);
+    this.probes.push({ sent_at: now, bytes_ahead: bytes_written, lost: false });
+    this.last_probe_at = now;
+    this.probes_sent++;
+  };
+
+  /**
+   * Only while a reply is on its way, a lone Escape at the end
+   * of a chunk would otherwise wait for the next key press
+   */
+  expecting_reply = () =>
+    this.probes.length > 0 &&
+    (this.smoothed_rtt !== null || this.probes_lost === 0);
+
+  /**
+   * Removes our probe replies from a chunk of stdin (so they are
+   * not read as key presses) and times them. Over ssh a reply can
+   * be split across reads, so a chunk that ends with the start of
+   * one has that start held back until the next chunk.
+   *
+   * @returns the chunk without the replies
+   */
+  strip_replies = (
+    chunk: Uint8Array,
+    now: number = performance.now() / 1000
+  ): Uint8Array => {
+    let data = chunk;
+    if (this.held_input.length > 0) {
+      data = new Uint8Array(this.held_input.length + chunk.length);
+      data.set(this.held_input);
+      data.set(chunk, this.held_input.length);
+      this.held_input = [];
+    }
+    const out: number[] = [];
+    let start = 0;
+    let index = this.find_reply(data, 0);
+    while (index !== -1) {
+      for (let i = start; i < index; i++) {
+        out.push(data[i]!);
+      }
+      this.on_reply(now);
+      start = index + device_status_ok.length;
+      index = this.find_reply(data, start);
+    }
+    let end = data.length;
+    if (this.expecting_reply()) {
+      const partial = this.partial_reply_length(data, start);
+      end -= partial;
+      for (let i = end; i < data.length; i++) {
+        this.held_input.push(data[i]!);
+      }
+    }
+    if (start === 0 && end === data.length) {
+      return data;
+    }
+    for (let i = start; i < end; i++) {
+      out.push(data[i]!);
+    }
+    return new Uint8Array(out);
+  };
+
+  /**
+   * @returns how many bytes at the end of data (after from)
+   * are the start of a reply
+   */
+  partial_reply_length = (data: Uint8Array, from: number) => {
+    for (let length = device_status_ok.length - 1; length > 0; length--) {
+      const first = data.length - length;
+      if (
+        first >= from &&
+        device_status_ok
+          .slice(0, length)
+          .every((byte, j) => data[first + j] === byte)
+      ) {
+        return length;
+      }
+    }
+    return 0;
+  };
+
+  find_reply = (chunk: Uint8Array, from: number) => {
+    for (let i = from; i + device_status_ok.length <= chunk.length; i++) {
+      if (device_status_ok.every((byte, j) => chunk[i + j] === byte)) {
+        return i;
+      }
+    }
+    return -1;
+  };
+
+  on_reply = (now: number) => {
+    const probe = this.probes.shift();
+    if (!probe || probe.lost) {
+      /**
+       * A late reply to a probe we already gave up on,
+       * the next reply is for the probe after it
+       */
+      return;
+    }
+    const rtt = now - probe.sent_at;
+
+    this.recent_rtts.push(rtt);
+    if (this.recent_rtts.length > min_rtt_window) {
+      this.recent_rtts.shift();
+    }
+
+    if (this.smoothed_rtt === null || this.rtt_variance === null) {
+      this.smoothed_rtt = rtt;
+      this.rtt_variance = rtt / 2;
+    } else {
+      this.rtt_variance =
+        (1 - rtt_variance_beta) * this.rtt_variance +
+        rtt_variance_beta * Math.abs(this.smoothed_rtt - rtt);
+      this.smoothed_rtt = (1 - rtt_alpha) * this.smoothed_rtt + rtt_alpha * rtt;
+    }
+
+    const drain_time = rtt - this.min_rtt()!;
+    if (drain_time < min_drain_seconds || probe.bytes_ahead === 0) {
+      return;
+    }
+    const sample = probe.bytes_ahead / drain_time;
+    this.throughput =
+      this.throughput === null
+        ? sample
+        : (1 - throughput_alpha) * this.throughput + throughput_alpha * sample;
+  };
+
+  min_rtt = () =>
+    this.recent_rtts.length === 0 ? null : Math.min(...this.recent_rtts);
+
+  stats = (): Link_Stats => ({
+    smoothed_rtt: this.smoothed_rtt,
+    rtt_variance: this.rtt_variance,
+    min_rtt: this.min_rtt(),
+    throughput: this.throughput,
+    probes_sent: this.probes_sent,
+    probes_lost: this.probes_lost,
+    bytes_written: this.bytes_written,
+  });
+}
+
+export const format_link_stats = (stats: Link_Stats) => {
+  if (stats.smoothed_rtt === null) {
+    return "";
+  }
+  const rtt = `rtt ${(stats.smoothed_rtt * 1000).toFixed(0)}ms`;
+  if (stats.throughput === null) {
+    return rtt;
+  }
+  const throughput =
+    stats.throughput >= 1024 * 1024
+      ? `${(stats.throughput / (1024 * 1024)).toFixed(1)}MB/s`
+      : `${(stats.throughput / 1024).toFixed(0)}KB/s`;
+  return `${rtt} ${throughput}`;
+};
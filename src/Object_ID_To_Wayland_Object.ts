@@ -1,58 +1,56 @@
-import {
-  wl_buffer as wl_buffer_id,
-  wl_compositor as wl_compositor_id,
-  wl_data_device_manager as wl_data_device_manager_id,
-  wl_data_device as wl_data_device_id,
-  wl_data_offer as wl_data_offer_id,
-  wl_data_source as wl_data_source_id,
-  wl_display as wl_display_id,
-  wl_keyboard as wl_keyboard_id,
-  wl_output as wl_output_id,
-  wl_pointer as wl_pointer_id,
-  wl_region as wl_region_id,
-  wl_registry as wl_registry_id,
-  wl_seat as wl_seat_id,
-  wl_shm as wl_shm_id,
-  wl_shm_pool as wl_shm_pool_id,
-  wl_subcompositor as wl_subcompositor_id,
-  wl_subsurface as wl_subsurface_id,
-  wl_surface as wl_surface_id,
-  xdg_popup as xdg_popup_id,
-  xdg_positioner as xdg_positioner_id,
-  xdg_surface as xdg_surface_id,
-  xdg_toplevel as xdg_toplevel_id,
-  xdg_wm_base as xdg_wm_base_id,
-  xwayland_shell_v1 as xwayland_shell_v1_id,
-  xwayland_surface_v1 as xwayland_surface_v1_id,
-  zwp_xwayland_keyboard_grab_manager_v1 as zwp_xwayland_keyboard_grab_manager_v1_id,
-  zwp_xwayland_keyboard_grab_v1 as zwp_xwayland_keyboard_grab_v1_id,
-} from "./protocols/wayland.xml.ts";
-import { wl_compositor } from "./objects/wl_compositor.ts";
-import { wl_data_device_manager } from "./objects/wl_data_device_manager.ts";
-import { wl_data_device } from "./objects/wl_data_device.ts";
-import { wl_data_offer } from "./objects/wl_data_offer.ts";
-import { wl_data_source } from "./objects/wl_data_source.ts";
-import { wl_display } from "./objects/wl_display.ts";
-import { wl_keyboard } from "./objects/wl_keyboard.ts";
-import { wl_output } from "./objects/wl_output.ts";
-import { wl_pointer } from "./objects/wl_pointer.ts";
-import { wl_region } from "./objects/wl_region.ts";
-import { wl_registry } from "./objects/wl_registry.ts";
-import { wl_seat } from "./objects/wl_seat.ts";
-import { wl_shm_pool } from "./objects/wl_shm_pool.ts";
-import { wl_shm } from "./objects/wl_shm.ts";
-import { wl_subcompositor } from "./objects/wl_subcompositor.ts";
-import { wl_subsurface } from "./objects/wl_subsurface.ts";
-import { wl_surface } from "./objects/wl_surface.ts";
-import { xdg_popup } from "./objects/xdg_popup.ts";
-import { xdg_positioner } from "./objects/xdg_positioner.ts";
-import { xdg_surface } from "./objects/xdg_surface.ts";
-import { xdg_toplevel } from "./objects/xdg_toplevel.ts";
-import { xdg_wm_base } from "./objects/xdg_wm_base.ts";
-import { xwayland_shell_v1 } from "./objects/xwayland_shell_v1.ts";
-import { xwayland_surface_v1 } from "./objects/xwayland_surface_v1.ts";
-import { zwp_xwayland_keyboard_grab_manager_v1 } from "./objects/zwp_xwayland_keyboard_grab_manager_v1.ts";
-import { zwp_xwayland_keyboard_grab_v1 } from "./objects/zwp_xwayland_keyboard_grab_v1.ts";
+import type { wl_buffer as wl_buffer_id } from "./protocols/wl_buffer.ts";
+import type { wl_compositor as wl_compositor_id } from "./protocols/wl_compositor.ts";
+import type { wl_data_device_manager as wl_data_device_manager_id } from "./protocols/wl_data_device_manager.ts";
+import type { wl_data_device as wl_data_device_id } from "./protocols/wl_data_device.ts";
+import type { wl_data_offer as wl_data_offer_id } from "./protocols/wl_data_offer.ts";
+import type { wl_data_source as wl_data_source_id } from "./protocols/wl_data_source.ts";
+import type { wl_display as wl_display_id } from "./protocols/wl_display.ts";
+import type { wl_keyboard as wl_keyboard_id } from "./protocols/wl_keyboard.ts";
+import type { wl_output as wl_output_id } from "./protocols/wl_output.ts";
+import type { wl_pointer as wl_pointer_id } from "./protocols/wl_pointer.ts";
+import type { wl_region as wl_region_id } from "./protocols/wl_region.ts";
+import type { wl_registry as wl_registry_id } from "./protocols/wl_registry.ts";
+import type { wl_seat as wl_seat_id } from "./protocols/wl_seat.ts";
+import type { wl_shm as wl_shm_id } from "./protocols/wl_shm.ts";
+import type { wl_shm_pool as wl_shm_pool_id } from "./protocols/wl_shm_pool.ts";
+import type { wl_subcompositor as wl_subcompositor_id } from "./protocols/wl_subcompositor.ts";
+import type { wl_subsurface as wl_subsurface_id } from "./protocols/wl_subsurface.ts";
+import type { wl_surface as wl_surface_id } from "./protocols/wl_surface.ts";
+import type { xdg_popup as xdg_popup_id } from "./protocols/xdg_popup.ts";
+import type { xdg_positioner as xdg_positioner_id } from "./protocols/xdg_positioner.ts";
+import type { xdg_surface as xdg_surface_id } from "./protocols/xdg_surface.ts";
+import type { xdg_toplevel as xdg_toplevel_id } from "./protocols/xdg_toplevel.ts";
+import type { xdg_wm_base as xdg_wm_base_id } from "./protocols/xdg_wm_base.ts";
+import type { xwayland_shell_v1 as xwayland_shell_v1_id } from "./protocols/xwayland_shell_v1.ts";
+import type { xwayland_surface_v1 as xwayland_surface_v1_id } from "./protocols/xwayland_surface_v1.ts";
+import type { zwp_xwayland_keyboard_grab_manager_v1 as zwp_xwayland_keyboard_grab_manager_v1_id } from "./protocols/zwp_xwayland_keyboard_grab_manager_v1.ts";
+import type { zwp_xwayland_keyboard_grab_v1 as zwp_xwayland_keyboard_grab_v1_id } from "./protocols/zwp_xwayland_keyboard_grab_v1.ts";
+import type { wl_compositor } from "./objects/wl_compositor.ts";
+import type { wl_data_device_manager } from "./objects/wl_data_device_manager.ts";
+import type { wl_data_device } from "./objects/wl_data_device.ts";
+import type { wl_data_offer } from "./objects/wl_data_offer.ts";
+import type { wl_data_source } from "./objects/wl_data_source.ts";
+import type { wl_display } from "./objects/wl_display.ts";
+import type { wl_keyboard } from "./objects/wl_keyboard.ts";
+import type { wl_output } from "./objects/wl_output.ts";
+import type { wl_pointer } from "./objects/wl_pointer.ts";
+import type { wl_region } from "./objects/wl_region.ts";
+import type { wl_registry } from "./objects/wl_registry.ts";
+import type { wl_seat } from "./objects/wl_seat.ts";
+import type { wl_shm_pool } from "./objects/wl_shm_pool.ts";
+import type { wl_shm } from "./objects/wl_shm.ts";
+import type { wl_subcompositor } from "./objects/wl_subcompositor.ts";
+import type { wl_subsurface } from "./objects/wl_subsurface.ts";
+import type { wl_surface } from "./objects/wl_surface.ts";
+import type { xdg_popup } from "./objects/xdg_popup.ts";
+import type { xdg_positioner } from "./objects/xdg_positioner.ts";
+import type { xdg_surface } from "./objects/xdg_surface.ts";
+import type { xdg_toplevel } from "./objects/xdg_toplevel.ts";
+import type { xdg_wm_base } from "./objects/xdg_wm_base.ts";
+import type { xwayland_shell_v1 } from "./objects/xwayland_shell_v1.ts";
+import type { xwayland_surface_v1 } from "./objects/xwayland_surface_v1.ts";
+import type { zwp_xwayland_keyboard_grab_manager_v1 } from "./objects/zwp_xwayland_keyboard_grab_manager_v1.ts";
+import type { zwp_xwayland_keyboard_grab_v1 } from "./objects/zwp_xwayland_keyboard_grab_v1.ts";
 
 import { Object_ID } from "./wayland_types.ts";
 import { Wayland_Object } from "./Wayland_Object.ts";
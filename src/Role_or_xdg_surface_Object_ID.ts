@@ -1,10 +1,8 @@
-import {
-  xdg_surface as protocol_xdg_surface,
-  xdg_popup,
-  wl_subsurface,
-  xdg_toplevel,
-  xwayland_surface_v1,
-} from "./protocols/wayland.xml.ts";
+import type { xdg_surface as protocol_xdg_surface } from "./protocols/xdg_surface.ts";
+import type { xdg_popup } from "./protocols/xdg_popup.ts";
+import type { wl_subsurface } from "./protocols/wl_subsurface.ts";
+import type { xdg_toplevel } from "./protocols/xdg_toplevel.ts";
+import type { xwayland_surface_v1 } from "./protocols/xwayland_surface_v1.ts";
 import { Object_ID } from "./wayland_types.ts";
 
 /**
@@ -0,0 +1,297 @@
+/**
+ * State synchronization over UDP, for lossy links (like mosh).
+ *
+ * The server (state_sync_server.ts) runs the compositor with its
+ * output going into a VT_Screen, and sends the client what that
+ * screen looks like now, never the bytes that got it there. The
+ * screen is cut into tiles of one row by tile_columns cells, every
+ * change to a tile gives it a new version, and a tile goes out as
+ * the difference from the version the client last acknowledged.
+ *
+ * Applying a tile is idempotent: the client applies it only if it
+ * has the version it was diffed from, and then has the new one. A
+ * lost datagram is not resent as it was, the next one diffs from
+ * the same acknowledged version to whatever is newest, so the
+ * client always converges on the latest frame instead of catching
+ * up on old ones.
+ *
+ * Input goes the other way as a byte stream with offsets, resent
+ * until the server acknowledges it, so keys are never lost or
+ * repeated.
+ *
+ * Every datagram is sealed with AES-128-GCM under a key the server
+ * makes up and prints, like MOSH_KEY. The key is meant to be used
+ * again, so a nonce must never repeat across runs either: it is the
+ * direction, 3 random bytes made up by each socket, and a sequence
+ * number that starts from the clock. The sequence numbers also let
+ * the receiver throw away replayed datagrams.
+ */
+import Bun from "bun";
+import { createCipheriv, createDecipheriv, randomBytes } from "node:crypto";
+
+export const default_state_sync_port = 60001;
+
+export const tile_columns = 32;
+
+/**
+ * Tiles are packed into datagrams up to about this
+ * much, under the usual 1500 byte MTU
+ */
+export const datagram_budget_bytes = 1200;
+
+export enum State_Sync_Message {
+  /**
+   * server -> client, tiles
+   */
+  screen = 1,
+  /**
+   * client -> server, acknowledged tiles and input
+   */
+  ack = 2,
+  /**
+   * server -> client, the command exited
+   */
+  goodbye = 3,
+}
+
+export enum State_Sync_Direction {
+  to_client = 0,
+  to_server = 1,
+}
+
+const nonce_bytes = 12;
+const tag_bytes = 16;
+const sequence_offset = 4;
+
+/**
+ * Datagrams can arrive this far out of order, anything
+ * older is taken as replayed
+ */
+const replay_window = 64n;
+
+export const make_state_sync_key = () => randomBytes(16).toString("base64");
+
+export class Byte_Writer {
+  bytes = new Uint8Array(256);
+  view = new DataView(this.bytes.buffer);
+  length = 0;
+
+  reserve = (more: number) => {
+    if (this.length + more <= this.bytes.length) {
+      return;
+    }
+    const bytes = new Uint8Array(
+      Math.max(this.bytes.length * 2, this.length + more)
+    );
+    bytes.set(this.bytes.subarray(0, this.length));
+    this.bytes = bytes;
+    this.view = new DataView(bytes.buffer);
+  };
+
+  u8 = (value: number) => {
+    this.reserve(1);
+    this.view.setUint8(this.length, value);
+    this.length += 1;
+  };
+
+  u16 = (value: number) => {
+    this.reserve(2);
+    this.view.setUint16(this.length, value);
+    this.length += 2;
+  };
+
+  u32 = (value: number) => {
+    this.reserve(4);
+    this.view.setUint32(this.length, value >>> 0);
+    this.length += 4;
+  };
+
+  /**
+   * u16 length, then the bytes
+   */
+  data = (data: Uint8Array) => {
+    this.u16(data.length);
+    this.reserve(data.length);
+    this.bytes.set(data, this.length);
+    this.length += data.length;
+  };
+
+  finish = () => this.bytes.slice(0, this.length);
+}
+
+export class Byte_Reader {
+  view: DataView;
+  offset = 0;
+
+  constructor(public bytes: Uint8Array) {
+    this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  }
+
+  u8 = () => this.view.getUint8((this.offset += 1) - 1);
+  u16 = () => this.view.getUint16((this.offset += 2) - 2);
+  u32 = () => this.view.getUint32((this.offset += 4) - 4);
+  data = () => {
+    const length = this.u16();
+    const data = this.bytes.subarray(this.offset, this.offset + length);
+    this.offset += length;
+    return data;
+  };
+}
+
+/**
+ * Milliseconds, wrapped to 32 bits, for round trip times
+ */
+export const timestamp_ms = () => Math.floor(performance.now()) >>> 0;
+
+/**
+ * A UDP socket whose datagrams are sealed, and some of which
+ * are dropped on purpose to try it out over loopback
+ */
+export class State_Sync_Socket {
+  key: Buffer;
+  nonce_prefix = randomBytes(sequence_offset - 1);
+  /**
+   * Microseconds since the epoch, so a socket made later with
+   * the same key starts past every sequence number used before
+   */
+  next_sequence = BigInt(Date.now()) * 1000n;
+  /**
+   * The newest sequence number received, and a bit for
+   * each of the replay_window before it that was
+   */
+  newest_received = -1n;
+  received_bits = 0n;
+  socket: Awaited<ReturnType<typeof Bun.udpSocket>> | null = null;
+  datagrams_sent = 0;
+  datagrams_dropped = 0;
+
+  constructor(
+    key: string,
+    public direction: State_Sync_Direction,
+    public drop_rate: number,
+    /**
+     * @param newest false if a datagram sent after this one already
+     * arrived, so where it came from is not where the peer is now
+     */
+    public on_payload: (
+      payload: Uint8Array,
+      address: string,
+      port: number,
+      newest: boolean
+    ) => void
+  ) {
+    this.key = Buffer.from(key, "base64");
+    if (this.key.length !== 16) {
+      throw new Error("The state sync key is 16 bytes of base64");
+    }
+  }
+
+  bind = async (port?: number) => {
+    this.socket = await Bun.udpSocket({
+      port,
+      socket: {
+        data: (_socket, data, port, address) => {
+          const opened = this.open(data);
+          if (opened) {
+            this.on_payload(opened.payload, address, port, opened.newest);
+          }
+        },
+      },
+    });
+    return this.socket.port;
+  };
+
+  send = (payload: Uint8Array, address: string, port: number) => {
+    this.datagrams_sent++;
+    if (Math.random() < this.drop_rate) {
+      this.datagrams_dropped++;
+      return;
+    }
+    this.socket?.send(this.seal(payload), port, address);
+  };
+
+  seal = (payload: Uint8Array) => {
+    const nonce = Buffer.alloc(nonce_bytes);
+    nonce[0] = this.direction;
+    this.nonce_prefix.copy(nonce, 1);
+    nonce.writeBigUInt64BE(this.next_sequence++, sequence_offset);
+    const cipher = createCipheriv("aes-128-gcm", this.key, nonce);
+    return Buffer.concat([
+      nonce,
+      cipher.update(payload),
+      cipher.final(),
+      cipher.getAuthTag(),
+    ]);
+  };
+
+  /**
+   * @returns whether the sequence number is new, and
+   * remembers it if it is
+   */
+  accept_sequence = (sequence: bigint) => {
+    if (sequence > this.newest_received) {
+      const shift = sequence - this.newest_received;
+      this.received_bits =
+        shift >= replay_window
+          ? 1n
+          : ((this.received_bits << shift) | 1n) &
+            ((1n << replay_window) - 1n);
+      this.newest_received = sequence;
+      return true;
+    }
+    const age = this.newest_received - sequence;
+    if (age >= replay_window || (this.received_bits >> age) & 1n) {
+      return false;
+    }
+    this.received_bits |= 1n << age;
+    return true;
+  };
+
+  /**
+   * @returns null for anything not sealed with our key,
+   * sent in our own direction, or replayed
+   */
+  open = (datagram: Uint8Array) => {
+    if (datagram.length < nonce_bytes + tag_bytes) {
+      return null;
+    }
+    const packet = Buffer.from(
+      datagram.buffer,
+      datagram.byteOffset,
+      datagram.byteLength
+    );
+    const nonce = packet.subarray(0, nonce_bytes);
+    if (nonce[0] === this.direction) {
+      return null;
+    }
+    let payload: Uint8Array;
+    try {
+      const decipher = createDecipheriv("aes-128-gcm", this.key, nonce);
+      decipher.setAuthTag(packet.subarray(packet.length - tag_bytes));
+      payload = new Uint8Array(
+        Buffer.concat([
+          decipher.update(
+            packet.subarray(nonce_bytes, packet.length - tag_bytes)
+          ),
+          decipher.final(),
+        ])
+      );
+    } catch {
+      return null;
+    }
+    /**
+     * Only after it is authentic, or anyone
+     * could push the window forward
+     */
+    const sequence = nonce.readBigUInt64BE(sequence_offset);
+    const newest = sequence > this.newest_received;
+    if (!this.accept_sequence(sequence)) {
+      return null;
+    }
+    return { payload, newest };
+  };
+
+  close = () => {
+    this.socket?.close();
+  };
+}
@@ -66,14 +66,15 @@ export class Status_Line {
   draw = (
     delta_time: number,
     app_title: string | null,
-    keys_held_down: Set<Linux_Event_Codes>
+    keys_held_down: Set<Linux_Event_Codes>,
+    link_stats: string = ""
   ) => {
     if (!this.show_status_line) {
       return "";
     }
     const text = this.line(
       keys_held_down
-    )`${this.b.escape} ${this.sponsor} | ${app_title ?? this.bugs} | `;
+    )`${this.b.escape} ${this.sponsor} | ${app_title ?? this.bugs} | ${link_stats}`;
 
     this.text_loop_time += delta_time;
     return text.slice(0, process.stdout.columns - 1);
@@ -1,9 +1,7 @@
-import {
-  xdg_toplevel,
-  wl_surface,
-  xdg_popup,
-  wl_subsurface,
-} from "./protocols/wayland.xml.ts";
+import { xdg_toplevel } from "./protocols/xdg_toplevel.ts";
+import { wl_surface } from "./protocols/wl_surface.ts";
+import { xdg_popup } from "./protocols/xdg_popup.ts";
+import { wl_subsurface } from "./protocols/wl_subsurface.ts";
 import { Object_ID } from "./wayland_types.ts";
 
 /**
@@ -1,67 +1,276 @@
-import {
-  wl_output_transform,
-  wl_region,
-  wl_buffer,
-  wl_surface,
-} from "./protocols/wayland.xml.ts";
+import { wl_output_transform } from "./protocols/wl_output.ts";
+import { wl_region } from "./protocols/wl_region.ts";
+import { wl_buffer } from "./protocols/wl_buffer.ts";
+import { wl_surface } from "./protocols/wl_surface.ts";
+import { wl_callback } from "./protocols/wl_callback.ts";
 import { Object_ID } from "./wayland_types.ts";
-import { xdg_surface as xdg_surface_state } from "./objects/xdg_surface.ts";
 
-export interface Surface_Update {
-  offset?: { x: number; y: number };
+/**
+ * Which fields of a Surface_Update have been set
+ * since the last commit.
+ */
+export enum Surface_Update_Field {
+  offset = 1 << 0,
+  damage = 1 << 1,
+  damage_buffer = 1 << 2,
+  buffer_scale = 1 << 3,
+  buffer_transform = 1 << 4,
+  input_region = 1 << 5,
+  opaque_region = 1 << 6,
+  buffer = 1 << 7,
+  add_sub_surface = 1 << 8,
+  xdg_surface_window_geometry = 1 << 9,
+  set_child_position = 1 << 10,
+  z_order_subsurfaces = 1 << 11,
+  xwayland_surface_v1_serial = 1 << 12,
+  fifo_barrier = 1 << 13,
+  fifo_wait = 1 << 14,
+  target_time = 1 << 15,
+  frame_callbacks = 1 << 16,
+}
+
+/**
+ * A list that keeps its entries around after being cleared,
+ * so pushing to it again reuses them instead of allocating.
+ */
+export class Reusable_List<T> {
+  items: T[] = [];
+  length = 0;
+
+  constructor(public make: () => T) {}
+
+  /**
+   * @returns the next entry, the caller overwrites all of its fields
+   */
+  push = (): T => {
+    if (this.length === this.items.length) {
+      this.items.push(this.make());
+    }
+    return this.items[this.length++]!;
+  };
+
+  clear = () => {
+    this.length = 0;
+  };
+}
+
+export interface Surface_Rect {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+export interface Child_Position {
+  child: Object_ID<wl_surface>;
+  x: number;
+  y: number;
+}
+
+export interface Z_Order_Update {
+  type: "above" | "below";
+  child_to_move: Object_ID<wl_surface>;
+  /**
+   * null means above or below the parent.
+   */
+  relative_to: Object_ID<wl_surface> | null;
+}
+
+const make_rect = (): Surface_Rect => ({ x: 0, y: 0, width: 0, height: 0 });
+
+/**
+ * The pending state of a wl_surface. Allocated once per
+ * surface and reused for every commit: setters write
+ * the fields and set the bit in `fields`, the commit
+ * reads the fields whose bit is set, then clears it.
+ *
+ * A field is only meaningful while its bit is set.
+ */
+export class Surface_Update {
+  fields = 0;
+
+  offset_x = 0;
+  offset_y = 0;
   /**
    * Damage is is surface local coordinates.
    */
-  damage?: { x: number; y: number; width: number; height: number }[];
+  damage = new Reusable_List<Surface_Rect>(make_rect);
   /**
    * Damage buffer is in buffer local coordinates.
    */
-  damage_buffer?: { x: number; y: number; width: number; height: number }[];
-  buffer_scale?: number;
-  buffer_transform?: wl_output_transform;
-  input_region?: Object_ID<wl_region> | null;
-  opaque_region?: Object_ID<wl_region> | null;
+  damage_buffer = new Reusable_List<Surface_Rect>(make_rect);
+  buffer_scale = 1;
+  buffer_transform: wl_output_transform = 0;
+  input_region: Object_ID<wl_region> | null = null;
+  opaque_region: Object_ID<wl_region> | null = null;
 
-  buffer?: Object_ID<wl_buffer> | null;
+  buffer: Object_ID<wl_buffer> | null = null;
 
   /**
-   * You should unshift when adding to
-   * this array so that the objects will
-   * be added in the correct order. (ie
-   * the ones added last will be on top)
+   * In the order the sub surfaces were created.
    */
-  add_sub_surface?: Object_ID<wl_surface>[];
+  add_sub_surface: Object_ID<wl_surface>[] = [];
 
-  xdg_surface_window_geometry?: xdg_surface_state["window_geometry"];
+  xdg_surface_window_geometry: Surface_Rect = make_rect();
 
   /**
    * set_child_position and z_oder_subsurfaces
    * take place whenever the parent surface is committed,
    * thus they are part of the SurfaceUpdate of the parent
    */
-  set_child_position?: {
-    child: Object_ID<wl_surface>;
-    x: number;
-    y: number;
-  }[];
+  set_child_position = new Reusable_List<Child_Position>(() => ({
+    child: 0 as Object_ID<wl_surface>,
+    x: 0,
+    y: 0,
+  }));
+  z_order_subsurfaces = new Reusable_List<Z_Order_Update>(() => ({
+    type: "above",
+    child_to_move: 0 as Object_ID<wl_surface>,
+    relative_to: null,
+  }));
+
+  xwayland_surface_v1_serial = { low: 0, hi: 0 };
+
+  /**
+   * From wp_commit_timer_v1, in seconds of CLOCK_MONOTONIC
+   */
+  target_time = 0;
+
   /**
-   * null means above or below the parent.
+   * From wl_surface.frame, they are done on the
+   * first frame after this update is applied
+   */
+  frame_callbacks: Object_ID<wl_callback>[] = [];
+
+  has = (field: Surface_Update_Field) => (this.fields & field) !== 0;
+
+  set_offset = (x: number, y: number) => {
+    this.offset_x = x;
+    this.offset_y = y;
+    this.fields |= Surface_Update_Field.offset;
+  };
+
+  add_damage = (
+    list: "damage" | "damage_buffer",
+    x: number,
+    y: number,
+    width: number,
+    height: number
+  ) => {
+    const rect = this[list].push();
+    rect.x = x;
+    rect.y = y;
+    rect.width = width;
+    rect.height = height;
+    this.fields |=
+      list === "damage"
+        ? Surface_Update_Field.damage
+        : Surface_Update_Field.damage_buffer;
+  };
+
+  set_buffer = (buffer: Object_ID<wl_buffer> | null) => {
+    this.buffer = buffer;
+    this.fields |= Surface_Update_Field.buffer;
+  };
+
+  set_buffer_scale = (scale: number) => {
+    this.buffer_scale = scale;
+    this.fields |= Surface_Update_Field.buffer_scale;
+  };
+
+  set_buffer_transform = (transform: wl_output_transform) => {
+    this.buffer_transform = transform;
+    this.fields |= Surface_Update_Field.buffer_transform;
+  };
+
+  set_input_region = (region: Object_ID<wl_region> | null) => {
+    this.input_region = region;
+    this.fields |= Surface_Update_Field.input_region;
+  };
+
+  set_opaque_region = (region: Object_ID<wl_region> | null) => {
+    this.opaque_region = region;
+    this.fields |= Surface_Update_Field.opaque_region;
+  };
+
+  push_sub_surface = (surface_id: Object_ID<wl_surface>) => {
+    this.add_sub_surface.push(surface_id);
+    this.fields |= Surface_Update_Field.add_sub_surface;
+  };
+
+  set_window_geometry = (
+    x: number,
+    y: number,
+    width: number,
+    height: number
+  ) => {
+    const geometry = this.xdg_surface_window_geometry;
+    geometry.x = x;
+    geometry.y = y;
+    geometry.width = width;
+    geometry.height = height;
+    this.fields |= Surface_Update_Field.xdg_surface_window_geometry;
+  };
+
+  set_child_position_of = (
+    child: Object_ID<wl_surface>,
+    x: number,
+    y: number
+  ) => {
+    const entry = this.set_child_position.push();
+    entry.child = child;
+    entry.x = x;
+    entry.y = y;
+    this.fields |= Surface_Update_Field.set_child_position;
+  };
+
+  place_child = (
+    type: "above" | "below",
+    child_to_move: Object_ID<wl_surface>,
+    relative_to: Object_ID<wl_surface> | null
+  ) => {
+    const entry = this.z_order_subsurfaces.push();
+    entry.type = type;
+    entry.child_to_move = child_to_move;
+    entry.relative_to = relative_to;
+    this.fields |= Surface_Update_Field.z_order_subsurfaces;
+  };
+
+  set_xwayland_serial = (low: number, hi: number) => {
+    this.xwayland_surface_v1_serial.low = low;
+    this.xwayland_surface_v1_serial.hi = hi;
+    this.fields |= Surface_Update_Field.xwayland_surface_v1_serial;
+  };
+
+  set_fifo_barrier = () => {
+    this.fields |= Surface_Update_Field.fifo_barrier;
+  };
+
+  set_fifo_wait = () => {
+    this.fields |= Surface_Update_Field.fifo_wait;
+  };
+
+  set_target_time = (seconds: number) => {
+    this.target_time = seconds;
+    this.fields |= Surface_Update_Field.target_time;
+  };
+
+  add_frame_callback = (callback: Object_ID<wl_callback>) => {
+    this.frame_callbacks.push(callback);
+    this.fields |= Surface_Update_Field.frame_callbacks;
+  };
+
+  /**
+   * Called by the commit once it has applied the update.
+   * Keeps every list's storage for the next one.
    */
-  z_order_subsurfaces?: (
-    | {
-        type: "above";
-        child_to_move: Object_ID<wl_surface>;
-        relative_to: Object_ID<wl_surface> | null;
-      }
-    | {
-        type: "below";
-        child_to_move: Object_ID<wl_surface>;
-        relative_to: Object_ID<wl_surface> | null;
-      }
-  )[];
-
-  xwayland_surfarface_v1_serial?: {
-    low: number;
-    hi: number;
+  clear = () => {
+    this.fields = 0;
+    this.damage.clear();
+    this.damage_buffer.clear();
+    this.add_sub_surface.length = 0;
+    this.frame_callbacks.length = 0;
+    this.set_child_position.clear();
+    this.z_order_subsurfaces.clear();
   };
 }
@@ -2,15 +2,17 @@ import Bun from "bun";
 import c, { Draw_State } from "./c_interop.ts";
 import { Wayland_Socket_Listener } from "./Wayland_Socket_Listener.ts";
 import { pointer } from "./objects/wl_pointer.ts";
+import { wl_callback } from "./protocols/wl_callback.ts";
 import {
-  wl_callback,
   wl_keyboard,
   wl_keyboard_key_state,
+} from "./protocols/wl_keyboard.ts";
+import {
   wl_pointer,
   wl_pointer_axis,
   wl_pointer_button_state,
-  xdg_toplevel,
-} from "./protocols/wayland.xml.ts";
+} from "./protocols/wl_pointer.ts";
+import { xdg_toplevel } from "./protocols/xdg_toplevel.ts";
 import { Global_Ids } from "./GlobalObjects.ts";
 import {
   convert_keycode_to_xbd_code,
@@ -19,11 +21,20 @@ import {
 import { never_default } from "./never_default.ts";
 import { Linux_Event_Codes } from "./Linux_Event_Codes.ts";
 import { Ansi_Escape_Codes } from "./Ansi_Escape_Codes.ts";
+import { Link_Estimator, format_link_stats } from "./Link_Estimator.ts";
+import { Input_Recorder, replay_input } from "./Input_Recording.ts";
+import { Frame_Stats, format_frame_stats } from "./Frame_Stats.ts";
+import { Auto_Motion_Scale } from "./Auto_Motion_Scale.ts";
 import { debug_turn_off_output } from "./debug_turn_off_output.ts" with { type: "macro" };
 import { Canvas_Desktop } from "./Canvas_Desktop.ts";
+import {
+  latch_surface_commits,
+  monotonic_seconds,
+} from "./latch_surface_commits.ts";
 import { Status_Line } from "./Status_Line.ts";
 import { on_exit } from "./on_exit.ts";
 import { Display_Server_Type } from "./get_display_server_type.ts";
+import type { Render_Mode } from "./parse_args.ts";
 
 export type Cells = number & { __brand: "cells" };
 export type Pixels = number & { __brand: "pixels" };
@@ -38,6 +49,60 @@ export interface Keys_Held_Down {
 
 const display_server_type = new Display_Server_Type();
 
+/**
+ * After the last replayed input, keep drawing this
+ * long so its effect is in the frame stats
+ */
+const replay_settle_seconds = 1;
+const ctrl_c = 0x03;
+
+export interface Terminal_Window_Options {
+  /**
+   * see --auto-tune
+   */
+  auto_tune?: boolean;
+  /**
+   * see --record-output
+   */
+  record_output?: string;
+  /**
+   * see --threads
+   */
+  threads?: number;
+  /**
+   * see --profile-output
+   */
+  profile_output?: string;
+  /**
+   * see --kitty-placeholders
+   */
+  kitty_placeholders?: boolean;
+  /**
+   * see --kitty-windows
+   */
+  kitty_windows?: boolean;
+  /**
+   * see --render-mode
+   */
+  render_mode?: Render_Mode;
+  /**
+   * see --motion-scale
+   */
+  motion_scale?: number | "auto";
+  /**
+   * see --record-input
+   */
+  record_input?: string;
+  /**
+   * see --replay-input
+   */
+  replay_input?: string;
+  /**
+   * see --replay-speed
+   */
+  replay_speed?: number;
+}
+
 export class Terminal_Window {
   virtual_monitor_size: Pixel_Size;
 
@@ -50,6 +115,31 @@ export class Terminal_Window {
 
   status_line = new Status_Line();
 
+  link_estimator: Link_Estimator;
+  frame_stats = new Frame_Stats();
+  printed_frame_stats = false;
+  wrote_output_profile = false;
+  /**
+   * The pointer shape last sent with OSC 22,
+   * null is the terminal's default
+   */
+  written_cursor_shape: string | null = null;
+  input_recorder: Input_Recorder | null = null;
+  /**
+   * null unless --motion-scale auto
+   */
+  auto_motion_scale: Auto_Motion_Scale | null = null;
+
+  /**
+   * Everything we measure about ourselves and the
+   * link to the terminal
+   */
+  stats = () => ({
+    link: this.link_estimator.stats(),
+    frames: this.frame_stats.summary(),
+    thread_pool: c.get_thread_pool_stats(),
+  });
+
   mode: "passthrough" | "menu" = "passthrough";
   /**
    * LinuxEvent Code to
@@ -81,15 +171,43 @@ export class Terminal_Window {
     public socket_listener: Wayland_Socket_Listener,
     public hide_status_bar: boolean,
     desktop_size: Pixel_Size,
-    will_show_app_right_at_startup: boolean
+    will_show_app_right_at_startup: boolean,
+    public options: Terminal_Window_Options = {}
   ) {
+    /**
+     * Nobody is there to answer status reports
+     * when the input comes from a recording
+     */
+    this.link_estimator = new Link_Estimator(
+      !options.replay_input && process.stdout.isTTY === true
+    );
+    if (options.record_input) {
+      this.input_recorder = new Input_Recorder(options.record_input);
+    }
     try {
       this.canvas_desktop = new Canvas_Desktop(
         desktop_size,
         will_show_app_right_at_startup
       );
       this.virtual_monitor_size = desktop_size;
-      this.draw_state = c.init_draw_state(display_server_type.type === "x11");
+      // Must be before raw mode and before anything reads stdin,
+      // auto tune measures the link by reading the terminal's replies
+      this.draw_state = c.init_draw_state(display_server_type.type === "x11", {
+        auto_tune_frame_time_seconds: options.auto_tune
+          ? this.desired_frame_time_seconds
+          : 0,
+        record_output_path: options.record_output,
+        threads: options.threads,
+        profile_output_path: options.profile_output,
+        kitty_placeholders: options.kitty_placeholders,
+        kitty_windows: options.kitty_windows,
+        render_mode: options.render_mode,
+      });
+      if (options.motion_scale === "auto") {
+        this.auto_motion_scale = new Auto_Motion_Scale();
+      } else if (options.motion_scale !== undefined) {
+        c.set_motion_scale(this.draw_state, options.motion_scale);
+      }
 
       // Set up terminal modes with error handling
       this.initializeTerminalMode();
@@ -103,10 +221,16 @@ export class Terminal_Window {
 
   private initializeTerminalMode(): void {
     try {
-      console.log("Setting raw mode...");
-      // Set raw mode first
-      process.stdin.setRawMode(true);
-      console.log("Raw mode set successfully");
+      /**
+       * stdin is not a terminal when input is piped in,
+       * like in CI under scripts/slow-link
+       */
+      if (process.stdin.isTTY) {
+        console.log("Setting raw mode...");
+        // Set raw mode first
+        process.stdin.setRawMode(true);
+        console.log("Raw mode set successfully");
+      }
 
       // Write ANSI escape codes with error handling
       if (!debug_turn_off_output()) {
@@ -125,7 +249,9 @@ export class Terminal_Window {
       console.error("Error initializing terminal mode:", error);
       // Attempt cleanup on error
       try {
-        process.stdin.setRawMode(false);
+        if (process.stdin.isTTY) {
+          process.stdin.setRawMode(false);
+        }
       } catch (cleanupError) {
         console.error("Error during cleanup:", cleanupError);
       }
@@ -144,156 +270,209 @@ export class Terminal_Window {
 
     process.stdout.write(Ansi_Escape_Codes.show_cursor);
 
+    if (this.written_cursor_shape !== null) {
+      process.stdout.write(Ansi_Escape_Codes.default_pointer_shape);
+    }
+
     process.stdout.write(Ansi_Escape_Codes.disable_mouse_tracking);
+
+    if (this.options.profile_output && !this.wrote_output_profile) {
+      this.wrote_output_profile = true;
+      c.write_output_profile(this.draw_state);
+    }
+
+    if (this.options.replay_input && !this.printed_frame_stats) {
+      this.printed_frame_stats = true;
+      console.error(format_frame_stats(this.frame_stats.summary()));
+    }
   };
   key_serial = 0;
 
   input_loop = async () => {
+    if (this.options.replay_input) {
+      this.live_input_during_replay_loop();
+      for await (const chunk of replay_input(
+        this.options.replay_input,
+        this.options.replay_speed ?? 1
+      )) {
+        this.handle_input_chunk(chunk);
+      }
+      /**
+       * Let the last input make it to the screen
+       */
+      await Bun.sleep(replay_settle_seconds * 1000);
+      process.exit(0);
+    }
+    const read_during_auto_tune = c.take_auto_tune_input(this.draw_state);
+    if (read_during_auto_tune.length > 0) {
+      this.input_recorder?.record(read_during_auto_tune);
+      this.handle_input_chunk(read_during_auto_tune);
+    }
     for await (const chunk of Bun.stdin.stream()) {
-      // console.log("chunk", chunk);
-
-      const codes = convert_keycode_to_xbd_code(chunk);
-
-      // if (codes.length === 0) {
-      //   console.log(chunk);
-      // }
-      // console.log("codes", codes);
-
-      const now = Date.now();
-
-      for (const code of codes) {
-        const new_key_serial = this.key_serial;
-        this.key_serial += 2;
-        for (const s of this.socket_listener.clients) {
-          s
-            .get_global_binds(Global_Ids.wl_keyboard)
-            ?.forEach((_version, keyboard_Id) => {
-              wl_keyboard.modifiers(
-                s,
-                keyboard_Id,
-                new_key_serial,
-                code.modifiers,
-                0,
-                0,
-                0
-              );
-            });
-        }
+      this.input_recorder?.record(chunk);
+      this.handle_input_chunk(chunk);
+    }
+  };
+
+  /**
+   * Live input is ignored while replaying,
+   * except ctrl+c which stops the replay.
+   */
+  live_input_during_replay_loop = async () => {
+    for await (const chunk of Bun.stdin.stream()) {
+      if (chunk.includes(ctrl_c)) {
+        process.exit(0);
+      }
+    }
+  };
+
+  handle_input_chunk = (chunk: Uint8Array) => {
+    // console.log("chunk", chunk);
+    this.frame_stats.on_input();
 
-        switch (code.type) {
-          case "key_code":
-            this.keys_pressed_this_frame.add(code.key_code);
-            for (const s of this.socket_listener.clients) {
-              s
-                .get_global_binds(Global_Ids.wl_keyboard)
-                ?.forEach((_version, keyboard_Id) => {
-                  wl_keyboard.key(
-                    s,
-                    keyboard_Id,
-                    new_key_serial,
-                    now,
-                    code.key_code,
-                    wl_keyboard_key_state.pressed
-                  );
-                  /**
-                   * There is no key up code in
-                   * ANSI escape codes, so
-                   * just say it is released
-                   * instantly
-                   */
-                  wl_keyboard.key(
-                    s,
-                    keyboard_Id,
-                    new_key_serial + 1,
-                    now,
-                    code.key_code,
-                    wl_keyboard_key_state.released
-                  );
-                });
-            }
-            break;
-          case "pointer_move": {
-            /**
-             * chafa maintains the aspect ratio
-             * so, if the aspect ratio doesn't
-             * match the virtual monitor the
-             * coords will be off
-             */
-
-            let x =
-              code.col *
-              (this.virtual_monitor_size.width /
-                (this.rendered_screen_size?.width_cells ??
-                  process.stdout.columns));
-
-            let y =
-              code.row *
-              (this.virtual_monitor_size.height /
-                (this.rendered_screen_size?.height_cells ??
-                  process.stdout.rows));
-
-            pointer.window_position.x = x;
-            pointer.window_position.y = y;
-            this.status_line.update_mouse_position(code);
-
-            for (const s of this.socket_listener.clients) {
-              s
-                .get_global_binds(Global_Ids.wl_pointer)
-                ?.forEach((version, pointer_id) => {
-                  wl_pointer.motion(s, pointer_id, Date.now(), x, y);
-
-                  wl_pointer.frame(s, version, pointer_id);
-                });
-            }
-            break;
+    const codes = convert_keycode_to_xbd_code(
+      this.link_estimator.strip_replies(chunk)
+    );
+
+    // if (codes.length === 0) {
+    //   console.log(chunk);
+    // }
+    // console.log("codes", codes);
+
+    const now = Date.now();
+
+    for (const code of codes) {
+      const new_key_serial = this.key_serial;
+      this.key_serial += 2;
+      for (const s of this.socket_listener.clients) {
+        s
+          .get_global_binds(Global_Ids.wl_keyboard)
+          ?.forEach((_version, keyboard_Id) => {
+            wl_keyboard.modifiers(
+              s,
+              keyboard_Id,
+              new_key_serial,
+              code.modifiers,
+              0,
+              0,
+              0
+            );
+          });
+      }
+
+      switch (code.type) {
+        case "key_code":
+          this.keys_pressed_this_frame.add(code.key_code);
+          for (const s of this.socket_listener.clients) {
+            s
+              .get_global_binds(Global_Ids.wl_keyboard)
+              ?.forEach((_version, keyboard_Id) => {
+                wl_keyboard.key(
+                  s,
+                  keyboard_Id,
+                  new_key_serial,
+                  now,
+                  code.key_code,
+                  wl_keyboard_key_state.pressed
+                );
+                /**
+                 * There is no key up code in
+                 * ANSI escape codes, so
+                 * just say it is released
+                 * instantly
+                 */
+                wl_keyboard.key(
+                  s,
+                  keyboard_Id,
+                  new_key_serial + 1,
+                  now,
+                  code.key_code,
+                  wl_keyboard_key_state.released
+                );
+              });
           }
-          case "pointer_button": {
-            this.status_line.handle_terminal_mouse_press(code);
-            for (const s of this.socket_listener.clients) {
-              s
-                .get_global_binds(Global_Ids.wl_pointer)
-                ?.forEach((version, pointer_id) => {
-                  wl_pointer.button(
-                    s,
-                    pointer_id,
-                    Date.now(),
-                    Date.now(),
-                    code.button,
-                    code.pressed
-                      ? wl_pointer_button_state.pressed
-                      : wl_pointer_button_state.released
-                  );
-                  wl_pointer.frame(s, version, pointer_id);
-                });
-            }
-            break;
+          break;
+        case "pointer_move": {
+          /**
+           * chafa maintains the aspect ratio
+           * so, if the aspect ratio doesn't
+           * match the virtual monitor the
+           * coords will be off
+           */
+
+          let x =
+            code.col *
+            (this.virtual_monitor_size.width /
+              (this.rendered_screen_size?.width_cells ??
+                process.stdout.columns));
+
+          let y =
+            code.row *
+            (this.virtual_monitor_size.height /
+              (this.rendered_screen_size?.height_cells ??
+                process.stdout.rows));
+
+          pointer.window_position.x = x;
+          pointer.window_position.y = y;
+          this.status_line.update_mouse_position(code);
+
+          for (const s of this.socket_listener.clients) {
+            s
+              .get_global_binds(Global_Ids.wl_pointer)
+              ?.forEach((version, pointer_id) => {
+                wl_pointer.motion(s, pointer_id, Date.now(), x, y);
+
+                wl_pointer.frame(s, version, pointer_id);
+              });
           }
-          case "pointer_wheel": {
-            const scale = code.modifiers & LINUX_MODIFIERS.alt ? 1 : 0.5;
-            const amount =
-              (scale *
-                ((code.up ? 1 : -1) * this.virtual_monitor_size.height)) /
-              (this.rendered_screen_size?.height_cells ?? process.stdout.rows);
-            for (const s of this.socket_listener.clients) {
-              s
-                .get_global_binds(Global_Ids.wl_pointer)
-                ?.forEach((version, pointer_id) => {
-                  wl_pointer.axis(
-                    s,
-                    pointer_id,
-                    Date.now(),
-                    wl_pointer_axis.vertical_scroll,
-                    amount
-                  );
-                  wl_pointer.frame(s, version, pointer_id);
-                });
-            }
-            break;
+          break;
+        }
+        case "pointer_button": {
+          this.status_line.handle_terminal_mouse_press(code);
+          for (const s of this.socket_listener.clients) {
+            s
+              .get_global_binds(Global_Ids.wl_pointer)
+              ?.forEach((version, pointer_id) => {
+                wl_pointer.button(
+                  s,
+                  pointer_id,
+                  Date.now(),
+                  Date.now(),
+                  code.button,
+                  code.pressed
+                    ? wl_pointer_button_state.pressed
+                    : wl_pointer_button_state.released
+                );
+                wl_pointer.frame(s, version, pointer_id);
+              });
           }
-
-          default:
-            never_default(code);
+          break;
         }
+        case "pointer_wheel": {
+          const scale = code.modifiers & LINUX_MODIFIERS.alt ? 1 : 0.5;
+          const amount =
+            (scale *
+              ((code.up ? 1 : -1) * this.virtual_monitor_size.height)) /
+            (this.rendered_screen_size?.height_cells ?? process.stdout.rows);
+          for (const s of this.socket_listener.clients) {
+            s
+              .get_global_binds(Global_Ids.wl_pointer)
+              ?.forEach((version, pointer_id) => {
+                wl_pointer.axis(
+                  s,
+                  pointer_id,
+                  Date.now(),
+                  wl_pointer_axis.vertical_scroll,
+                  amount
+                );
+                wl_pointer.frame(s, version, pointer_id);
+              });
+          }
+          break;
+        }
+
+        default:
+          never_default(code);
       }
     }
   };
@@ -317,6 +496,7 @@ export class Terminal_Window {
     this.input_loop();
     while (true) {
       const start_of_frame = Date.now() / 1000;
+      const frame_start = performance.now() / 1000;
       const delta_time = this.time_of_start_of_last_frame
         ? start_of_frame - this.time_of_start_of_last_frame
         : this.desired_frame_time_seconds;
@@ -329,6 +509,15 @@ export class Terminal_Window {
         s.frame_draw_requests = [];
       }
 
+      /**
+       * A commit targeting a time closer to this frame
+       * than to the next one is shown in this one
+       */
+      latch_surface_commits(
+        this.socket_listener.clients,
+        monotonic_seconds() + this.desired_frame_time_seconds / 2
+      );
+
       for (const s of this.socket_listener.clients) {
         const pointer_surface_id = pointer.pointer_surface_id.get(s);
         if (!pointer_surface_id) {
@@ -341,23 +530,48 @@ export class Terminal_Window {
           pointer_surface.position.z = 1000;
         }
       }
-      this.canvas_desktop.draw_clients(this.socket_listener.clients);
-
-      const desktop_buffer = this.canvas_desktop.canvas.toBuffer("raw");
+      if (pointer.cursor_shape !== this.written_cursor_shape) {
+        this.written_cursor_shape = pointer.cursor_shape;
+        process.stdout.write(
+          pointer.cursor_shape === null
+            ? Ansi_Escape_Codes.default_pointer_shape
+            : `${Ansi_Escape_Codes.set_pointer_shape}${pointer.cursor_shape}\x1b\\`
+        );
+      }
+      this.canvas_desktop.draw_clients(
+        this.socket_listener.clients,
+        this.draw_state
+      );
 
       const status_line = this.status_line.draw(
         delta_time,
         this.get_app_title(),
-        this.keys_pressed_this_frame
+        this.keys_pressed_this_frame,
+        format_link_stats(this.link_estimator.stats())
       );
       if (!debug_turn_off_output()) {
-        this.rendered_screen_size = c.draw_desktop(
+        const rendered = c.draw_desktop(
           this.draw_state,
-          desktop_buffer,
-          this.virtual_monitor_size.width,
-          this.virtual_monitor_size.height,
           this.hide_status_bar ? "" : status_line
         );
+        if (rendered) {
+          this.rendered_screen_size = rendered;
+          this.link_estimator.after_frame(rendered.bytes_written);
+          this.frame_stats.on_frame(frame_start, rendered.bytes_written);
+          if (this.auto_motion_scale) {
+            this.auto_motion_scale.on_frame(
+              rendered.desktop_bytes,
+              rendered.pixel_scale
+            );
+            c.set_motion_scale(
+              this.draw_state,
+              this.auto_motion_scale.pick(
+                this.link_estimator.throughput,
+                this.desired_frame_time_seconds
+              )
+            );
+          }
+        }
       }
 
       // const draw_time = Date.now();
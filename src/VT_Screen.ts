@@ -0,0 +1,793 @@
+/**
+ * A small VT (xterm) emulator: parses an output stream
+ * and keeps the resulting grid of cells. It only knows
+ * the sequences that we (and chafa) emit, plus the ones
+ * that move the cursor or erase, which is enough to tell
+ * if two output streams end up drawing the same screen.
+ *
+ * Image protocols (kitty, sixel, iTerm2) are parsed and
+ * counted but don't change the grid.
+ */
+
+export interface VT_Cell {
+  char: string;
+  /**
+   * Canonical form of the SGR state the cell was drawn with,
+   * two cells look the same if char and style are equal.
+   */
+  style: string;
+}
+
+export type VT_Sequence_Category =
+  | "text"
+  | "control"
+  | "cursor"
+  | "sgr"
+  | "erase"
+  | "scroll"
+  | "mode"
+  | "image"
+  | "osc"
+  | "other";
+
+export interface VT_Sequence_Stats {
+  count: number;
+  bytes: number;
+}
+
+export interface VT_Mismatch {
+  row: number;
+  column: number;
+  expected: VT_Cell;
+  actual: VT_Cell;
+}
+
+interface SGR_State {
+  fg: string;
+  bg: string;
+  bold: boolean;
+  dim: boolean;
+  italic: boolean;
+  underline: boolean;
+  blink: boolean;
+  inverse: boolean;
+  hidden: boolean;
+  strikethrough: boolean;
+}
+
+const default_sgr = (): SGR_State => ({
+  fg: "",
+  bg: "",
+  bold: false,
+  dim: false,
+  italic: false,
+  underline: false,
+  blink: false,
+  inverse: false,
+  hidden: false,
+  strikethrough: false,
+});
+
+const style_of = (sgr: SGR_State) =>
+  [
+    sgr.fg,
+    sgr.bg,
+    sgr.bold ? "b" : "",
+    sgr.dim ? "d" : "",
+    sgr.italic ? "i" : "",
+    sgr.underline ? "u" : "",
+    sgr.blink ? "k" : "",
+    sgr.inverse ? "r" : "",
+    sgr.hidden ? "h" : "",
+    sgr.strikethrough ? "s" : "",
+  ].join("|");
+
+/**
+ * The SGR parameters that draw a cell with this style, from a reset,
+ * the inverse of style_of
+ */
+export const sgr_of_style = (style: string) => {
+  const [fg = "", bg = "", ...flags] = style.split("|");
+  const color = (value: string, extended: number) =>
+    value.includes(";") ? `${extended};${value}` : value;
+  const flag_codes: Record<string, string> = {
+    b: "1",
+    d: "2",
+    i: "3",
+    u: "4",
+    k: "5",
+    r: "7",
+    h: "8",
+    s: "9",
+  };
+  return [
+    "0",
+    fg && color(fg, 38),
+    bg && color(bg, 48),
+    ...flags.map((flag) => flag_codes[flag] ?? ""),
+  ]
+    .filter(Boolean)
+    .join(";");
+};
+
+const enum Parse_State {
+  ground,
+  escape,
+  escape_intermediate,
+  csi,
+  /**
+   * OSC, DCS, APC, PM, SOS, all end with ST (or BEL for OSC)
+   */
+  string,
+}
+
+export class VT_Screen {
+  cells: VT_Cell[][] = [];
+  /**
+   * Cells that were written or erased since the last clear_touched,
+   * a full repaint only says something about the cells it touched.
+   */
+  touched: boolean[][] = [];
+  cursor = { row: 0, column: 0 };
+  saved_cursor = { row: 0, column: 0 };
+  scroll_top = 0;
+  scroll_bottom = 0;
+  stats = new Map<VT_Sequence_Category, VT_Sequence_Stats>();
+
+  sgr = default_sgr();
+  wrap_pending = false;
+
+  state = Parse_State.ground;
+  sequence: number[] = [];
+  string_kind = "";
+  string_escape = false;
+  utf8_bytes: number[] = [];
+  utf8_remaining = 0;
+
+  constructor(
+    public columns: number,
+    public rows: number
+  ) {
+    this.resize(columns, rows);
+  }
+
+  resize = (columns: number, rows: number) => {
+    const blank = this.blank_cell();
+    this.cells = Array.from({ length: rows }, (_, row) =>
+      Array.from(
+        { length: columns },
+        (_, column) => this.cells[row]?.[column] ?? blank
+      )
+    );
+    this.touched = Array.from({ length: rows }, (_, row) =>
+      Array.from(
+        { length: columns },
+        (_, column) => this.touched[row]?.[column] ?? false
+      )
+    );
+    this.columns = columns;
+    this.rows = rows;
+    this.scroll_top = 0;
+    this.scroll_bottom = rows - 1;
+    this.cursor.row = Math.min(this.cursor.row, rows - 1);
+    this.cursor.column = Math.min(this.cursor.column, columns - 1);
+  };
+
+  clear_touched = () => {
+    for (const row of this.touched) {
+      row.fill(false);
+    }
+  };
+
+  /**
+   * Cells that differ from the reference, only looking
+   * at the cells the reference touched.
+   */
+  diff = (reference: VT_Screen): VT_Mismatch[] => {
+    const out: VT_Mismatch[] = [];
+    const rows = Math.min(this.rows, reference.rows);
+    const columns = Math.min(this.columns, reference.columns);
+    for (let row = 0; row < rows; row++) {
+      for (let column = 0; column < columns; column++) {
+        if (!reference.touched[row]![column]) {
+          continue;
+        }
+        const expected = reference.cells[row]![column]!;
+        const actual = this.cells[row]![column]!;
+        if (expected.char !== actual.char || expected.style !== actual.style) {
+          out.push({ row, column, expected, actual });
+        }
+      }
+    }
+    return out;
+  };
+
+  row_text = (row: number) =>
+    this.cells[row]?.map((cell) => cell.char).join("") ?? "";
+
+  write = (data: Uint8Array | string) => {
+    const bytes =
+      typeof data === "string" ? new TextEncoder().encode(data) : data;
+    for (const byte of bytes) {
+      this.feed(byte);
+    }
+  };
+
+  count = (category: VT_Sequence_Category, bytes: number) => {
+    const stats = this.stats.get(category) ?? { count: 0, bytes: 0 };
+    stats.count++;
+    stats.bytes += bytes;
+    this.stats.set(category, stats);
+  };
+
+  blank_cell = (): VT_Cell => ({
+    char: " ",
+    /**
+     * Erasing uses the current background (like xterm)
+     */
+    style: style_of({ ...default_sgr(), bg: this.sgr?.bg ?? "" }),
+  });
+
+  feed = (byte: number) => {
+    switch (this.state) {
+      case Parse_State.ground:
+        this.feed_ground(byte);
+        return;
+      case Parse_State.escape:
+        this.feed_escape(byte);
+        return;
+      case Parse_State.escape_intermediate:
+        /**
+         * ESC ( B and friends, charset designation, one more byte
+         */
+        this.sequence.push(byte);
+        this.count("other", this.sequence.length);
+        this.state = Parse_State.ground;
+        return;
+      case Parse_State.csi:
+        this.sequence.push(byte);
+        if (byte >= 0x40 && byte <= 0x7e) {
+          this.execute_csi();
+          this.state = Parse_State.ground;
+        }
+        return;
+      case Parse_State.string:
+        this.sequence.push(byte);
+        this.feed_string(byte);
+        return;
+    }
+  };
+
+  feed_ground = (byte: number) => {
+    if (this.utf8_remaining > 0) {
+      if ((byte & 0xc0) === 0x80) {
+        this.utf8_bytes.push(byte);
+        this.utf8_remaining--;
+        if (this.utf8_remaining === 0) {
+          const text = new TextDecoder().decode(
+            new Uint8Array(this.utf8_bytes)
+          );
+          this.count("text", this.utf8_bytes.length);
+          this.print(text);
+        }
+        return;
+      }
+      /**
+       * Broken UTF-8, drop what we had
+       */
+      this.utf8_remaining = 0;
+      this.print("�");
+    }
+    if (byte === 0x1b) {
+      this.state = Parse_State.escape;
+      this.sequence = [byte];
+      return;
+    }
+    if (byte < 0x20 || byte === 0x7f) {
+      this.count("control", 1);
+      this.execute_control(byte);
+      return;
+    }
+    if (byte < 0x80) {
+      this.count("text", 1);
+      this.print(String.fromCharCode(byte));
+      return;
+    }
+    this.utf8_bytes = [byte];
+    this.utf8_remaining =
+      (byte & 0xe0) === 0xc0 ? 1 : (byte & 0xf0) === 0xe0 ? 2 : 3;
+  };
+
+  feed_escape = (byte: number) => {
+    this.sequence.push(byte);
+    const char = String.fromCharCode(byte);
+    switch (char) {
+      case "[":
+        this.state = Parse_State.csi;
+        return;
+      case "]":
+      case "P":
+      case "_":
+      case "^":
+      case "X":
+        this.state = Parse_State.string;
+        this.string_kind = char;
+        this.string_escape = false;
+        return;
+      case "(":
+      case ")":
+      case "*":
+      case "+":
+      case "#":
+        this.state = Parse_State.escape_intermediate;
+        return;
+    }
+    this.state = Parse_State.ground;
+    switch (char) {
+      case "7":
+        this.saved_cursor = { ...this.cursor };
+        this.count("cursor", 2);
+        return;
+      case "8":
+        this.cursor = { ...this.saved_cursor };
+        this.wrap_pending = false;
+        this.count("cursor", 2);
+        return;
+      case "D":
+        this.index();
+        this.count("scroll", 2);
+        return;
+      case "E":
+        this.cursor.column = 0;
+        this.index();
+        this.count("scroll", 2);
+        return;
+      case "M":
+        this.reverse_index();
+        this.count("scroll", 2);
+        return;
+      case "c":
+        this.sgr = default_sgr();
+        this.erase_rows(0, this.rows - 1);
+        this.cursor = { row: 0, column: 0 };
+        this.scroll_top = 0;
+        this.scroll_bottom = this.rows - 1;
+        this.count("erase", 2);
+        return;
+      default:
+        this.count("other", 2);
+        return;
+    }
+  };
+
+  feed_string = (byte: number) => {
+    if (this.string_escape) {
+      this.string_escape = false;
+      /**
+       * Inside of tmux passthrough ESC is doubled
+       */
+      if (byte === 0x1b && this.is_tmux_passthrough()) {
+        return;
+      }
+      if (byte === 0x5c) {
+        this.end_string();
+      }
+      return;
+    }
+    if (byte === 0x1b) {
+      this.string_escape = true;
+      return;
+    }
+    if (byte === 0x07 && this.string_kind === "]") {
+      this.end_string();
+    }
+  };
+
+  is_tmux_passthrough = () =>
+    this.string_kind === "P" &&
+    new TextDecoder().decode(new Uint8Array(this.sequence.slice(2, 7))) ===
+      "tmux;";
+
+  end_string = () => {
+    const introducer = new TextDecoder().decode(
+      new Uint8Array(this.sequence.slice(2, 7))
+    );
+    const is_image =
+      this.string_kind === "_" ||
+      this.string_kind === "P" ||
+      (this.string_kind === "]" && introducer === "1337;");
+    this.count(
+      is_image ? "image" : this.string_kind === "]" ? "osc" : "other",
+      this.sequence.length
+    );
+    this.state = Parse_State.ground;
+  };
+
+  params = () => {
+    const text = new TextDecoder().decode(
+      new Uint8Array(this.sequence.slice(2, -1))
+    );
+    const is_private = /^[?<=>]/.test(text);
+    const numbers = (is_private ? text.slice(1) : text)
+      .split(";")
+      .map((p) => (p === "" ? NaN : parseInt(p.split(":")[0]!, 10)));
+    return { text, is_private, numbers };
+  };
+
+  execute_csi = () => {
+    const final = String.fromCharCode(this.sequence[this.sequence.length - 1]!);
+    const { text, is_private, numbers } = this.params();
+    const n = (index: number, fallback: number) => {
+      const value = numbers[index];
+      return value === undefined || isNaN(value) || value === 0
+        ? fallback
+        : value;
+    };
+    const length = this.sequence.length;
+    this.wrap_pending = this.wrap_pending && final === "m";
+
+    switch (final) {
+      case "A":
+        this.move_to(this.cursor.row - n(0, 1), this.cursor.column);
+        this.count("cursor", length);
+        return;
+      case "B":
+        this.move_to(this.cursor.row + n(0, 1), this.cursor.column);
+        this.count("cursor", length);
+        return;
+      case "C":
+        this.move_to(this.cursor.row, this.cursor.column + n(0, 1));
+        this.count("cursor", length);
+        return;
+      case "D":
+        this.move_to(this.cursor.row, this.cursor.column - n(0, 1));
+        this.count("cursor", length);
+        return;
+      case "E":
+        this.move_to(this.cursor.row + n(0, 1), 0);
+        this.count("cursor", length);
+        return;
+      case "F":
+        this.move_to(this.cursor.row - n(0, 1), 0);
+        this.count("cursor", length);
+        return;
+      case "G":
+      case "`":
+        this.move_to(this.cursor.row, n(0, 1) - 1);
+        this.count("cursor", length);
+        return;
+      case "d":
+        this.move_to(n(0, 1) - 1, this.cursor.column);
+        this.count("cursor", length);
+        return;
+      case "H":
+      case "f":
+        this.move_to(n(0, 1) - 1, n(1, 1) - 1);
+        this.count("cursor", length);
+        return;
+      case "s":
+        this.saved_cursor = { ...this.cursor };
+        this.count("cursor", length);
+        return;
+      case "u":
+        this.cursor = { ...this.saved_cursor };
+        this.count("cursor", length);
+        return;
+      case "J":
+        this.erase_display(isNaN(numbers[0]!) ? 0 : numbers[0]!);
+        this.count("erase", length);
+        return;
+      case "K":
+        this.erase_line(isNaN(numbers[0]!) ? 0 : numbers[0]!);
+        this.count("erase", length);
+        return;
+      case "X":
+        this.erase_cells(
+          this.cursor.row,
+          this.cursor.column,
+          this.cursor.column + n(0, 1) - 1
+        );
+        this.count("erase", length);
+        return;
+      case "P":
+        this.delete_cells(n(0, 1));
+        this.count("erase", length);
+        return;
+      case "@":
+        this.insert_cells(n(0, 1));
+        this.count("erase", length);
+        return;
+      case "L":
+        this.insert_lines(n(0, 1));
+        this.count("scroll", length);
+        return;
+      case "M":
+        this.delete_lines(n(0, 1));
+        this.count("scroll", length);
+        return;
+      case "S":
+        this.scroll_up(n(0, 1));
+        this.count("scroll", length);
+        return;
+      case "T":
+        this.scroll_down(n(0, 1));
+        this.count("scroll", length);
+        return;
+      case "r":
+        if (is_private) {
+          this.count("mode", length);
+          return;
+        }
+        this.scroll_top = n(0, 1) - 1;
+        this.scroll_bottom = Math.min(n(1, this.rows), this.rows) - 1;
+        this.cursor = { row: 0, column: 0 };
+        this.count("scroll", length);
+        return;
+      case "m":
+        this.apply_sgr(text === "" ? [0] : numbers.map((v) => (isNaN(v) ? 0 : v)));
+        this.count("sgr", length);
+        return;
+      case "h":
+      case "l":
+        this.count("mode", length);
+        return;
+      default:
+        this.count("other", length);
+        return;
+    }
+  };
+
+  apply_sgr = (codes: number[]) => {
+    for (let i = 0; i < codes.length; i++) {
+      const code = codes[i]!;
+      if (code === 38 || code === 48) {
+        const target = code === 38 ? "fg" : "bg";
+        if (codes[i + 1] === 5) {
+          this.sgr[target] = `5;${codes[i + 2]}`;
+          i += 2;
+        } else if (codes[i + 1] === 2) {
+          this.sgr[target] = `2;${codes[i + 2]};${codes[i + 3]};${codes[i + 4]}`;
+          i += 4;
+        }
+        continue;
+      }
+      if ((code >= 30 && code <= 37) || (code >= 90 && code <= 97)) {
+        this.sgr.fg = `${code}`;
+        continue;
+      }
+      if ((code >= 40 && code <= 47) || (code >= 100 && code <= 107)) {
+        this.sgr.bg = `${code}`;
+        continue;
+      }
+      switch (code) {
+        case 0:
+          this.sgr = default_sgr();
+          break;
+        case 1:
+          this.sgr.bold = true;
+          break;
+        case 2:
+          this.sgr.dim = true;
+          break;
+        case 3:
+          this.sgr.italic = true;
+          break;
+        case 4:
+          this.sgr.underline = true;
+          break;
+        case 5:
+          this.sgr.blink = true;
+          break;
+        case 7:
+          this.sgr.inverse = true;
+          break;
+        case 8:
+          this.sgr.hidden = true;
+          break;
+        case 9:
+          this.sgr.strikethrough = true;
+          break;
+        case 22:
+          this.sgr.bold = false;
+          this.sgr.dim = false;
+          break;
+        case 23:
+          this.sgr.italic = false;
+          break;
+        case 24:
+          this.sgr.underline = false;
+          break;
+        case 25:
+          this.sgr.blink = false;
+          break;
+        case 27:
+          this.sgr.inverse = false;
+          break;
+        case 28:
+          this.sgr.hidden = false;
+          break;
+        case 29:
+          this.sgr.strikethrough = false;
+          break;
+        case 39:
+          this.sgr.fg = "";
+          break;
+        case 49:
+          this.sgr.bg = "";
+          break;
+        default:
+          break;
+      }
+    }
+  };
+
+  execute_control = (byte: number) => {
+    switch (byte) {
+      case 0x08:
+        this.wrap_pending = false;
+        this.cursor.column = Math.max(0, this.cursor.column - 1);
+        return;
+      case 0x09:
+        this.cursor.column = Math.min(
+          this.columns - 1,
+          (Math.floor(this.cursor.column / 8) + 1) * 8
+        );
+        return;
+      case 0x0a:
+      case 0x0b:
+      case 0x0c:
+        this.wrap_pending = false;
+        this.index();
+        return;
+      case 0x0d:
+        this.wrap_pending = false;
+        this.cursor.column = 0;
+        return;
+      default:
+        return;
+    }
+  };
+
+  print = (char: string) => {
+    if (this.wrap_pending) {
+      this.wrap_pending = false;
+      this.cursor.column = 0;
+      this.index();
+    }
+    const { row, column } = this.cursor;
+    this.cells[row]![column] = { char, style: style_of(this.sgr) };
+    this.touched[row]![column] = true;
+    if (column === this.columns - 1) {
+      this.wrap_pending = true;
+    } else {
+      this.cursor.column++;
+    }
+  };
+
+  move_to = (row: number, column: number) => {
+    this.wrap_pending = false;
+    this.cursor.row = Math.max(0, Math.min(this.rows - 1, row));
+    this.cursor.column = Math.max(0, Math.min(this.columns - 1, column));
+  };
+
+  index = () => {
+    if (this.cursor.row === this.scroll_bottom) {
+      this.scroll_up(1);
+      return;
+    }
+    this.cursor.row = Math.min(this.rows - 1, this.cursor.row + 1);
+  };
+
+  reverse_index = () => {
+    if (this.cursor.row === this.scroll_top) {
+      this.scroll_down(1);
+      return;
+    }
+    this.cursor.row = Math.max(0, this.cursor.row - 1);
+  };
+
+  blank_row = () => Array.from({ length: this.columns }, this.blank_cell);
+
+  /**
+   * Scrolling moves touched cells with the content,
+   * and the new blank rows count as touched.
+   */
+  scroll_region = (top: number, bottom: number, amount: number) => {
+    for (let i = 0; i < Math.abs(amount); i++) {
+      if (amount > 0) {
+        this.cells.splice(top, 1);
+        this.cells.splice(bottom, 0, this.blank_row());
+        this.touched.splice(top, 1);
+        this.touched.splice(bottom, 0, Array(this.columns).fill(true));
+      } else {
+        this.cells.splice(bottom, 1);
+        this.cells.splice(top, 0, this.blank_row());
+        this.touched.splice(bottom, 1);
+        this.touched.splice(top, 0, Array(this.columns).fill(true));
+      }
+    }
+  };
+
+  scroll_up = (amount: number) =>
+    this.scroll_region(this.scroll_top, this.scroll_bottom, amount);
+
+  scroll_down = (amount: number) =>
+    this.scroll_region(this.scroll_top, this.scroll_bottom, -amount);
+
+  insert_lines = (amount: number) => {
+    if (this.cursor.row < this.scroll_top || this.cursor.row > this.scroll_bottom) {
+      return;
+    }
+    this.scroll_region(this.cursor.row, this.scroll_bottom, -amount);
+  };
+
+  delete_lines = (amount: number) => {
+    if (this.cursor.row < this.scroll_top || this.cursor.row > this.scroll_bottom) {
+      return;
+    }
+    this.scroll_region(this.cursor.row, this.scroll_bottom, amount);
+  };
+
+  erase_cells = (row: number, from: number, to: number) => {
+    for (let column = from; column <= Math.min(to, this.columns - 1); column++) {
+      this.cells[row]![column] = this.blank_cell();
+      this.touched[row]![column] = true;
+    }
+  };
+
+  erase_rows = (from: number, to: number) => {
+    for (let row = from; row <= to; row++) {
+      this.erase_cells(row, 0, this.columns - 1);
+    }
+  };
+
+  erase_line = (mode: number) => {
+    const { row, column } = this.cursor;
+    switch (mode) {
+      case 0:
+        this.erase_cells(row, column, this.columns - 1);
+        return;
+      case 1:
+        this.erase_cells(row, 0, column);
+        return;
+      default:
+        this.erase_cells(row, 0, this.columns - 1);
+        return;
+    }
+  };
+
+  erase_display = (mode: number) => {
+    const { row } = this.cursor;
+    switch (mode) {
+      case 0:
+        this.erase_line(0);
+        this.erase_rows(row + 1, this.rows - 1);
+        return;
+      case 1:
+        this.erase_rows(0, row - 1);
+        this.erase_line(1);
+        return;
+      default:
+        this.erase_rows(0, this.rows - 1);
+        return;
+    }
+  };
+
+  delete_cells = (amount: number) => {
+    const { row, column } = this.cursor;
+    const line = this.cells[row]!;
+    line.splice(column, amount);
+    while (line.length < this.columns) {
+      line.push(this.blank_cell());
+    }
+    this.touched[row]!.fill(true, column);
+  };
+
+  insert_cells = (amount: number) => {
+    const { row, column } = this.cursor;
+    const line = this.cells[row]!;
+    line.splice(column, 0, ...Array.from({ length: amount }, this.blank_cell));
+    line.length = this.columns;
+    this.touched[row]!.fill(true, column);
+  };
+}
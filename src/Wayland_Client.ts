@@ -1,15 +1,14 @@
+import { closeSync } from "node:fs";
 import { File_Descriptor_Claim } from "./File_Descriptor_Claim.ts";
 import { Sender } from "./Sender.ts";
 import { Send_Message, is_debug_send_message } from "./Send_Message.ts";
 import { global_objects, Global_Ids } from "./GlobalObjects.ts";
 import { Message_Decoder } from "./Message_Decoder.ts";
 import { Wayland_Object } from "./Wayland_Object.ts";
-import {
-  wl_callback,
-  wl_display,
-  wl_surface,
-  xdg_toplevel,
-} from "./protocols/wayland.xml.ts";
+import { wl_callback } from "./protocols/wl_callback.ts";
+import { wl_display } from "./protocols/wl_display.ts";
+import { wl_surface } from "./protocols/wl_surface.ts";
+import { xdg_toplevel } from "./protocols/xdg_toplevel.ts";
 import { File_Descriptor, Object_ID, version } from "./wayland_types.ts";
 import {
   get_message_and_file_descriptors,
@@ -25,6 +24,22 @@ import { Role_or_xdg_surface_Object_ID } from "./Role_or_xdg_surface_Object_ID.t
 import { Surface_Role } from "./Surface_Role.ts";
 import { Object_ID_To_Wayland_Object } from "./Object_ID_To_Wayland_Object.ts";
 
+/**
+ * libwayland drops the connection if more file descriptors
+ * than this arrive in one message (MAX_FDS_OUT)
+ */
+const max_file_descriptors_per_send = 28;
+/**
+ * A client with more than this queued and not yet written
+ * isn't reading its socket, it is dropped (libwayland
+ * drops clients whose buffer overflows too)
+ */
+const max_pending_bytes = 1024 * 1024;
+/**
+ * A client whose socket stays full this long is dropped
+ */
+const unwritable_timeout_seconds = 10;
+
 export class Wayland_Client implements File_Descriptor_Claim, Sender {
   drawable_surfaces = new Set<Object_ID<wl_surface>>();
 
@@ -120,6 +135,12 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
 
   frame_draw_requests: Object_ID<wl_callback>[] = [];
 
+  /**
+   * Surfaces with commits held back by fifo-v1 or commit-timing-v1,
+   * or with a fifo barrier that the next frame clears
+   */
+  waiting_surfaces = new Set<Object_ID<wl_surface>>();
+
   // object_state: Object_State = {};
 
   send_error = (object_id: Object_ID, code: number, message: string) => {
@@ -135,8 +156,11 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
   message_buffer = new Uint8Array(1024);
   file_descriptor_buffer = new Uint32Array(255);
 
-  send_message_buffer = new Uint8Array(1024);
-  send_file_descriptor_buffer = new Uint32Array(255);
+  /**
+   * Grows to fit the largest batch of messages
+   */
+  send_message_buffer = new Uint8Array(4096);
+  send_file_descriptor_buffer = new Uint32Array(max_file_descriptors_per_send);
 
   objects: Map<Object_ID, Wayland_Object<any>> = new Map();
   _global_binds: Map<Global_Ids, Map<Object_ID, version>> = new Map();
@@ -211,6 +235,20 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
   //   );
   // };
   pending_message: Send_Message[] = [];
+  /**
+   * Bytes sent but not yet written to the socket,
+   * both queued and in the batch being written
+   */
+  pending_bytes = 0;
+  /**
+   * True while write_pending_messages is running, there
+   * is only ever one writer per client so order is kept.
+   */
+  writing = false;
+  /**
+   * False once the client has gone away
+   */
+  connected = true;
 
   message_decoder = new Message_Decoder();
 
@@ -226,16 +264,8 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
   }
 
   main_loop = async () => {
-    while (true) {
-      for (const message of this.pending_message) {
-        const should_continue = await this.send_pending_messages(message);
-        if (!should_continue) {
-          return;
-        }
-      }
-
-      this.pending_message = [];
-
+    let socket_closed = false;
+    while (this.connected) {
       const message = await get_message_and_file_descriptors(
         this.client_socket,
         this.message_buffer,
@@ -243,73 +273,216 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
       );
       const should_continue = this.parse_messages(message);
       if (!should_continue) {
-        return;
+        /**
+         * The native side closes the socket when reading fails
+         */
+        socket_closed = true;
+        this.disconnect();
+      }
+    }
+    if (!socket_closed) {
+      /**
+       * Writing dropped the client, hang up on it
+       * once no write is using the socket
+       */
+      this.hang_up_after_write = true;
+      if (!this.writing) {
+        this.hang_up();
       }
     }
+    /**
+     * A read that was waiting when writing found the
+     * client gone can still have brought file descriptors
+     */
+    this.close_unclaimed_file_descriptors();
+  };
+
+  /**
+   * Set when the socket should be closed, but
+   * write_pending_messages is still using it
+   */
+  hang_up_after_write = false;
+  hang_up = () => {
+    this.hang_up_after_write = false;
+    try {
+      closeSync(this.client_socket);
+    } catch {}
+  };
+
+  /**
+   * Everything that has to happen once, whether reading
+   * or writing is what finds out the client is gone
+   */
+  disconnect = () => {
+    this.connected = false;
+    this.pending_message = [];
+    this.pending_bytes = 0;
+    this.close_unclaimed_file_descriptors();
+  };
+
+  /**
+   * File descriptors sent with requests we never got to, or
+   * sent to objects that didn't take them. Nothing else
+   * will close them once the client is gone.
+   */
+  close_unclaimed_file_descriptors = () => {
+    for (const fd of this.unclaimed_file_descriptors) {
+      try {
+        closeSync(fd);
+      } catch {}
+    }
+    this.unclaimed_file_descriptors = [];
   };
 
   /**
    *
-   * Adds the message to the pending message queue
+   * Adds the message to the pending message queue,
+   * and starts writing it out if we aren't already.
    */
   send = (data: Send_Message) => {
+    /**
+     * Nothing will ever be written to a client that went away.
+     * File descriptors in messages are only lent to us (the
+     * keymap goes to every keyboard), they aren't ours to close.
+     */
+    if (!this.connected) {
+      return;
+    }
     this.pending_message.push(data);
+    this.pending_bytes += 8 + data.data.length;
+    if (this.pending_bytes > max_pending_bytes) {
+      console.error(
+        `client#${this.client_socket} is not reading its socket, dropping it`
+      );
+      this.disconnect();
+      return;
+    }
+    if (this.writing) {
+      return;
+    }
+    this.writing = true;
+    /**
+     * Wait until the end of the current task, so everything
+     * sent while handling a batch of requests (or a frame)
+     * goes out together.
+     */
+    queueMicrotask(this.write_pending_messages);
+  };
+
+  write_pending_messages = async () => {
+    while (this.connected && this.pending_message.length > 0) {
+      const messages = this.pending_message;
+      this.pending_message = [];
+      let start = 0;
+      while (this.connected && start < messages.length) {
+        const batch = this.encode_batch(messages, start);
+        const should_continue = await this.write_batch(
+          batch.length,
+          batch.number_of_file_descriptors
+        );
+        if (!should_continue) {
+          this.disconnect();
+          break;
+        }
+        this.pending_bytes -= batch.length;
+        start = batch.end;
+      }
+    }
+    this.writing = false;
+    if (this.hang_up_after_write) {
+      this.hang_up();
+    }
   };
+
   /**
+   * Copies messages[start...] into send_message_buffer, until
+   * we run out of messages or a message would need more file
+   * descriptors than fit in one sendmsg.
    *
-   * @param message
-   * @returns Returns if we should continue listening or sending on this socket any more
-   * returns falsy mostly if the client has disconnected
+   * File descriptors are sent with the first bytes of the
+   * batch, so they arrive before (or with) the message that
+   * uses them.
    */
-  send_pending_messages = async (message: Send_Message): Promise<boolean> => {
-    if (wayland_debug_time_only()) {
-      if (is_debug_send_message(message)) {
-        console.log(
-          `client#${this.client_socket} -> ${message.object_name}@${message.object_id}.${message.message_name}(${message.message_args.map(({ signature, value }) => `${signature} = ${value}`).join(", ")})`
-        );
+  encode_batch = (messages: Send_Message[], start: number) => {
+    let length = 0;
+    let number_of_file_descriptors = 0;
+    let end = start;
+    for (; end < messages.length; end++) {
+      const message = messages[end]!;
+      if (message.file_descriptor != null) {
+        if (number_of_file_descriptors === max_file_descriptors_per_send) {
+          break;
+        }
+        this.send_file_descriptor_buffer[number_of_file_descriptors] =
+          message.file_descriptor;
+        number_of_file_descriptors++;
+      }
+      if (wayland_debug_time_only()) {
+        if (is_debug_send_message(message)) {
+          console.log(
+            `client#${this.client_socket} -> ${message.object_name}@${message.object_id}.${message.message_name}(${message.message_args.map(({ signature, value }) => `${signature} = ${value}`).join(", ")})`
+          );
+        }
+      }
+      /**
+       * 8 bytes is the header length + the length of the message
+       * #### Header is
+       * - 4 bytes for object_id
+       * - 2 bytes for opcode
+       * - 2 bytes for size
+       */
+      const message_length = 8 + message.data.length;
+      this.ensure_send_capacity(length + message_length);
+      const buffer = this.send_message_buffer;
+      buffer[length + 0] = message.object_id & 0xff;
+      buffer[length + 1] = (message.object_id >> 8) & 0xff;
+      buffer[length + 2] = (message.object_id >> 16) & 0xff;
+      buffer[length + 3] = (message.object_id >> 24) & 0xff;
+      buffer[length + 4] = message.opcode & 0xff;
+      buffer[length + 5] = (message.opcode >> 8) & 0xff;
+      buffer[length + 6] = message_length & 0xff;
+      buffer[length + 7] = (message_length >> 8) & 0xff;
+      if (message.data.length > 0) {
+        buffer.set(message.data, length + 8);
       }
+      length += message_length;
     }
-    /**
-     * 8 bytes is the header length + the length of the message
-     * #### Header is
-     * - 4 bytes for object_id
-     * - 2 bytes for opcode
-     * - 2 bytes for size
-     */
-    const length = 8 + message.data.length;
-
-    this.send_message_buffer.set(
-      new Uint8Array([
-        message.object_id & 0xff,
-        (message.object_id >> 8) & 0xff,
-        (message.object_id >> 16) & 0xff,
-        (message.object_id >> 24) & 0xff,
-        message.opcode & 0xff,
-        (message.opcode >> 8) & 0xff,
-        length & 0xff,
-        (length >> 8) & 0xff,
-      ])
-    );
-    if (message.data.length > 0) {
-      this.send_message_buffer.set(message.data, 8);
+    return { end, length, number_of_file_descriptors };
+  };
+
+  ensure_send_capacity = (length: number) => {
+    if (length <= this.send_message_buffer.length) {
+      return;
+    }
+    let new_length = this.send_message_buffer.length;
+    while (new_length < length) {
+      new_length *= 2;
     }
-    this.send_file_descriptor_buffer[0] = message.file_descriptor ?? 0;
+    const new_buffer = new Uint8Array(new_length);
+    new_buffer.set(this.send_message_buffer);
+    this.send_message_buffer = new_buffer;
+  };
 
+  /**
+   *
+   * @returns Returns if we should continue listening or sending on this socket any more
+   * returns falsy mostly if the client has disconnected
+   */
+  write_batch = async (
+    length: number,
+    number_of_file_descriptors: number
+  ): Promise<boolean> => {
     let offset = 0;
-    while (true) {
-      if (offset > 0) {
-        console.log("\nsending more data\n");
-      }
+    let last_progress = performance.now();
+    while (offset < length) {
       const data_view = this.send_message_buffer.subarray(offset, length);
       /**
-       * only send the file descriptor on the first message
+       * only send the file descriptors with the first bytes
        */
-      const file_descriptor_view =
-        offset == 0 && message.file_descriptor != null
-          ? this.send_file_descriptor_buffer.subarray(0, 1)
-          : this.send_file_descriptor_buffer.subarray(0, 0);
-
-      this.send_message_buffer.subarray();
+      const file_descriptor_view = this.send_file_descriptor_buffer.subarray(
+        0,
+        offset == 0 ? number_of_file_descriptors : 0
+      );
 
       const { should_continue, bytes_written } =
         await send_message_and_file_descriptors(
@@ -321,11 +494,31 @@ export class Wayland_Client implements File_Descriptor_Claim, Sender {
       if (!should_continue) {
         return false;
       }
+      if (bytes_written === 0) {
+        /**
+         * Dropped while we waited, by send going over max_pending_bytes
+         */
+        if (!this.connected) {
+          return false;
+        }
+        if (
+          performance.now() - last_progress >
+          unwritable_timeout_seconds * 1000
+        ) {
+          console.error(
+            `client#${this.client_socket} has not read its socket in ${unwritable_timeout_seconds}s, dropping it`
+          );
+          return false;
+        }
+        /**
+         * The client's socket stayed full while the native side
+         * waited for it to be writable, wait again
+         */
+        continue;
+      }
 
+      last_progress = performance.now();
       offset += bytes_written;
-      if (offset >= length) {
-        break;
-      }
     }
     return true;
   };
@@ -1,13 +1,14 @@
-import { wl_surface } from "./protocols/wayland.xml.ts";
+import { wl_surface } from "./protocols/wl_surface.ts";
 import { Object_ID } from "./wayland_types.ts";
 import { Wayland_Client } from "./Wayland_Client.ts";
 import { Pending_Buffer_Updates } from "./objects/wl_surface.ts";
+import { Reusable_List, Surface_Update_Field as F } from "./Surface_Update.ts";
 
 export const apply_wl_surface_double_buffered_state = (
   s: Wayland_Client,
   surface_object_id: Object_ID<wl_surface>,
   sync_set_by_parent: boolean,
-  accumulator: Pending_Buffer_Updates[],
+  accumulator: Reusable_List<Pending_Buffer_Updates>,
   z_index: number
 ) => {
   /**
@@ -19,26 +20,22 @@ export const apply_wl_surface_double_buffered_state = (
   }
 
   const update = surface.pending_update;
-  if (update.buffer !== undefined) {
-    accumulator.push({
-      buffer: update.buffer,
-      surface: surface_object_id,
-      z_index,
-    });
+  const fields = update.fields;
+  if (fields & F.buffer) {
+    const pending = accumulator.push();
+    pending.buffer = update.buffer;
+    pending.surface = surface_object_id;
+    pending.z_index = z_index;
   }
-  if (update.buffer_scale !== undefined) {
+  if (fields & F.buffer_scale) {
     surface.buffer_scale = update.buffer_scale;
   }
-  if (update.buffer_transform !== undefined) {
+  if (fields & F.buffer_transform) {
     surface.buffer_transform = update.buffer_transform;
   }
-  if (update.damage !== undefined || update.damage_buffer !== undefined) {
-    surface.damaged = true;
-  } else {
-    surface.damaged = false;
-  }
+  surface.damaged = (fields & (F.damage | F.damage_buffer)) !== 0;
 
-  if (update.offset !== undefined) {
+  if (fields & F.offset) {
     /**
      * @TODO Docs say:
      * The x and y arguments specify the location of the new pending
@@ -52,8 +49,8 @@ export const apply_wl_surface_double_buffered_state = (
      * So I think this means I should add the offset to the current offset
      * of the surface, not just set it to the offset.
      */
-    surface.offset.x += update.offset.x;
-    surface.offset.y += update.offset.y;
+    surface.offset.x += update.offset_x;
+    surface.offset.y += update.offset_y;
     /**
      * From the docs:
      * On wl_surface.offset requests to the pointer surface, hotspot_x and hotspot_y are decremented by the x and y parameters passed to the request. The offset must be applied by wl_surface.commit as usual.
@@ -63,7 +60,7 @@ export const apply_wl_surface_double_buffered_state = (
     //   surface.role.data.hotspot.y -= update.offset.y;
     // }
   }
-  if (update.input_region !== undefined) {
+  if (fields & F.input_region) {
     if (
       surface.input_region !== null &&
       surface.input_region !== update.input_region
@@ -77,7 +74,7 @@ export const apply_wl_surface_double_buffered_state = (
     }
     surface.input_region = update.input_region;
   }
-  if (update.opaque_region !== undefined) {
+  if (fields & F.opaque_region) {
     if (
       surface.opaque_region !== null &&
       surface.opaque_region !== update.opaque_region
@@ -92,14 +89,15 @@ export const apply_wl_surface_double_buffered_state = (
     surface.opaque_region = update.opaque_region;
   }
 
-  if (update.add_sub_surface !== undefined) {
-    for (const sub_surface_id of update.add_sub_surface!) {
+  if (fields & F.add_sub_surface) {
+    for (const sub_surface_id of update.add_sub_surface) {
       surface.children_in_draw_order.unshift(sub_surface_id);
     }
   }
 
-  if (update.set_child_position !== undefined) {
-    for (const child_position of update.set_child_position) {
+  if (fields & F.set_child_position) {
+    for (let i = 0; i < update.set_child_position.length; i++) {
+      const child_position = update.set_child_position.items[i]!;
       const index_of_child = surface.children_in_draw_order.indexOf(
         child_position.child
       );
@@ -118,15 +116,14 @@ export const apply_wl_surface_double_buffered_state = (
         continue;
       }
 
-      sub_surface.position = {
-        x: child_position.x,
-        y: child_position.y,
-      };
+      sub_surface.position.x = child_position.x;
+      sub_surface.position.y = child_position.y;
     }
   }
 
-  if (update.z_order_subsurfaces !== undefined) {
-    for (const z_oder_update of update.z_order_subsurfaces) {
+  if (fields & F.z_order_subsurfaces) {
+    for (let i = 0; i < update.z_order_subsurfaces.length; i++) {
+      const z_oder_update = update.z_order_subsurfaces.items[i]!;
       const index_of_child = surface.children_in_draw_order.indexOf(
         z_oder_update.child_to_move
       );
@@ -157,12 +154,17 @@ export const apply_wl_surface_double_buffered_state = (
     }
   }
 
-  if (update.xdg_surface_window_geometry) {
+  if (fields & F.xdg_surface_window_geometry) {
     const xdg_surface_state_id = surface.xdg_surface_state;
     if (xdg_surface_state_id) {
       const xdg_surface_state = s.get_object(xdg_surface_state_id)?.delegate;
       if (xdg_surface_state) {
-        xdg_surface_state.window_geometry = update.xdg_surface_window_geometry;
+        const geometry = xdg_surface_state.window_geometry;
+        const pending = update.xdg_surface_window_geometry;
+        geometry.x = pending.x;
+        geometry.y = pending.y;
+        geometry.width = pending.width;
+        geometry.height = pending.height;
       }
       // xdg_surface_state.window_geometry = update.xdg_surface_window_geometry;
     }
@@ -195,17 +197,36 @@ export const apply_wl_surface_double_buffered_state = (
   //   }
   //   delete surface.role.data.pending_state;
   // }
-  if (surface.pending_update.xwayland_surfarface_v1_serial) {
+  if (fields & F.xwayland_surface_v1_serial) {
     if (surface.role?.type === "xwayland_surface_v1") {
       surface.role.data ??= {
         serial: null,
       };
-      surface.role.data.serial =
-        surface.pending_update.xwayland_surfarface_v1_serial;
+      surface.role.data.serial ??= { low: 0, hi: 0 };
+      surface.role.data.serial.low = update.xwayland_surface_v1_serial.low;
+      surface.role.data.serial.hi = update.xwayland_surface_v1_serial.hi;
+    }
+  }
+
+  if (fields & F.fifo_barrier) {
+    /**
+     * Cleared by the next frame, see latch_surface_commits
+     */
+    surface.fifo_barrier = true;
+    s.waiting_surfaces.add(surface_object_id);
+  }
+
+  if (fields & F.frame_callbacks) {
+    /**
+     * Only now, a queued commit's callbacks
+     * wait until its content is shown
+     */
+    for (const callback of update.frame_callbacks) {
+      s.add_frame_draw_request(callback);
     }
   }
 
-  surface.pending_update = {};
+  update.clear();
 
   /**
    * Apply updates to children
@@ -1,4 +1,5 @@
-import { wl_shm_pool } from "./protocols/wayland.xml.ts";
+import { wl_shm_pool } from "./protocols/wl_shm_pool.ts";
+import { wl_shm_format } from "./protocols/wl_shm.ts";
 import { File_Descriptor, Object_ID } from "./wayland_types.ts";
 
 export type Client_State = object & {
@@ -9,6 +10,48 @@ export type Draw_State = object & {
   __brand: "Draw_State";
 };
 
+/**
+ * A wl_buffer's pixels, holds a reference to the pool
+ * mapping the buffer was created in. The mapping stays
+ * alive until every buffer in it is released, so native
+ * threads can keep reading it after the pool is resized
+ * or destroyed.
+ */
+export type Native_Buffer = object & {
+  __brand: "Native_Buffer";
+};
+
+/**
+ * Our copy of a surface's pixels. Copy on write, once it is
+ * in a published snapshot, update_texture writes into a spare
+ * one that no snapshot holds anymore.
+ */
+export type Native_Texture = object & {
+  __brand: "Native_Texture";
+};
+
+export interface Thread_Pool_Stats {
+  threads: number;
+  tasks_run: number;
+  tasks_stolen: number;
+  /**
+   * Skipped for missing their deadline
+   */
+  tasks_expired: number;
+  tasks_run_while_waiting: number;
+  queued: number;
+  /**
+   * 0 to 1, since the last call
+   */
+  utilization: number;
+}
+
+export interface Draw_Item {
+  texture: Native_Texture;
+  x: Pixels;
+  y: Pixels;
+}
+
 export interface C_Interop {
   set_raw_mode(): void;
   reset_mode(): void;
@@ -16,6 +59,11 @@ export interface C_Interop {
   listen_to_wayland_socket(socket_name: string): number | null;
 
   get_socket_path_from_name(socket_name: string): string;
+  /**
+   * Connects like a client, for scripts/soak-test
+   * @returns the socket, -1 on error
+   */
+  connect_to_wayland_socket(socket_name: string): number;
   close_wayland_socket(
     socket_name: string,
     socket_file_descriptor: number
@@ -108,6 +156,28 @@ export interface C_Interop {
     shm_pool_id: Object_ID<wl_shm_pool>
   ): undefined;
 
+  /**
+   * Makes a buffer in the pool's current mapping.
+   * @returns null if the pool doesn't exist or
+   * the buffer doesn't fit in it
+   */
+  create_shm_buffer(
+    client_state: Client_State,
+    shm_pool_id: Object_ID<wl_shm_pool>,
+    offset: number,
+    width: number,
+    height: number,
+    stride: number,
+    format: wl_shm_format
+  ): Native_Buffer | null;
+
+  /**
+   * Drops the reference now, rather than
+   * whenever the handle is garbage collected.
+   * The handle can't be used after this.
+   */
+  release_shm_buffer(buffer: Native_Buffer): undefined;
+
   /**
    * @returns true if successful, false if not
    */
@@ -121,25 +191,134 @@ export interface C_Interop {
    * @returns true on success, false on failure
    */
   memcopy_buffer_to_uint8array(
-    client_state: Client_State,
-    pool_id: Object_ID<wl_shm_pool>,
-    pool_offset: number,
+    buffer: Native_Buffer,
     destination: Uint8ClampedArray,
     flip_colors: boolean
   ): boolean;
 
-  draw_desktop(
+  /**
+   * Copies a buffer into a texture, in place or into the
+   * texture's spare if nothing else holds them and they are
+   * the same size.
+   * @returns the texture to use from now on, null on failure
+   */
+  update_texture(
+    texture: Native_Texture | null,
+    buffer: Native_Buffer
+  ): Native_Texture | null;
+
+  /**
+   * @param pixels BGRA premultiplied, like canvas.toBuffer("raw")
+   */
+  create_texture(
+    pixels: Buffer,
+    width: Pixels,
+    height: Pixels
+  ): Native_Texture | null;
+
+  /**
+   * Hands the desktop for this frame to the native side.
+   * Readers keep seeing the previous snapshot until they
+   * are done with it.
+   * @param draw_list bottom first
+   */
+  publish_compositor_snapshot(
     draw_state: Draw_State,
-    desktop: Buffer,
     width: Pixels,
     height: Pixels,
+    draw_list: Draw_Item[]
+  ): undefined;
+
+  /**
+   * Draws the last published snapshot
+   * @returns null if nothing has been published yet
+   */
+  draw_desktop(
+    draw_state: Draw_State,
     status_line: string
   ): {
     width_cells: Cells;
     height_cells: Cells;
-  };
+    /**
+     * How many bytes were written to the terminal
+     */
+    bytes_written: number;
+    /**
+     * The part of bytes_written that is the desktop,
+     * 0 if only the status line was drawn
+     */
+    desktop_bytes: number;
+    /**
+     * 1, or the motion scale if the desktop
+     * was drawn at a lower resolution
+     */
+    pixel_scale: number;
+  } | null;
+
+  /**
+   * While the desktop is changing, make kitty and iTerm2 images at
+   * this fraction of the terminal's resolution and let the terminal
+   * scale them up. 1 turns it off. Rounded to eighths, at least 1/4.
+   */
+  set_motion_scale(draw_state: Draw_State, scale: number): undefined;
+
+  init_draw_state(
+    session_type_is_x11: boolean,
+    options?: {
+      /**
+       * If > 0, on the first frame pick the symbol set and work factor
+       * that can be converted and sent to this terminal within this
+       * frame time. The result is cached per host and terminal.
+       */
+      auto_tune_frame_time_seconds?: number;
+      /**
+       * Record every frame written to the terminal
+       * to this file, for scripts/vt-harness
+       */
+      record_output_path?: string;
+      /**
+       * Sort every byte written to the terminal by what it is
+       * for, see write_output_profile
+       */
+      profile_output_path?: string;
+      /**
+       * Threads in the native thread pool,
+       * 0 or missing for one per core
+       */
+      threads?: number;
+      /**
+       * On terminals that draw kitty images, place them
+       * with Unicode placeholder cells instead
+       */
+      kitty_placeholders?: boolean;
+      /**
+       * On terminals that draw kitty images, send every surface
+       * as its own image and move it with placements
+       */
+      kitty_windows?: boolean;
+      /**
+       * When drawing with symbols, draw with a fixed grid of
+       * sextants, octants or braille instead of chafa
+       */
+      render_mode?: string;
+    }
+  ): Draw_State;
 
-  init_draw_state(session_type_is_x11: boolean): Draw_State;
+  /**
+   * Keys pressed while auto tune measured the link in init_draw_state,
+   * they were read from stdin along with the terminal's replies.
+   * Empty after the first call.
+   */
+  take_auto_tune_input(draw_state: Draw_State): Uint8Array;
+
+  get_thread_pool_stats(): Thread_Pool_Stats;
+
+  /**
+   * Writes the totals of the output profile to profile_output_path,
+   * per frame numbers are in profile_output_path + ".frames.csv".
+   * Does nothing if profiling is off.
+   */
+  write_output_profile(draw_state: Draw_State): undefined;
   
   // macOS-specific functions
   get_display_info(): any;
@@ -1,11 +1,10 @@
 import cpp from "./c_interop.ts";
 import { never_default } from "./never_default.ts";
-import { wl_surface as w, wl_buffer } from "./protocols/wayland.xml.ts";
+import { wl_surface as w } from "./protocols/wl_surface.ts";
+import { wl_buffer } from "./protocols/wl_buffer.ts";
 import { Object_ID } from "./wayland_types.ts";
 import { Wayland_Client } from "./Wayland_Client.ts";
 import { pointer } from "./objects/wl_pointer.ts";
-import { Map_State } from "./objects/wl_shm_pool.ts";
-import { createCanvas, ImageData } from "canvas";
 
 export const copy_buffer_to_wl_surface_texture = (
   s: Wayland_Client,
@@ -38,22 +37,21 @@ export const copy_buffer_to_wl_surface_texture = (
     return;
   }
 
-  if (pool.map_state === Map_State.destroyed) {
+  const buffer_info = pool.buffers.get(buffer_id);
+  if (!buffer_info) {
+    debugger;
+    console.error("Could not get buffer_info, cant' commit!");
+    return;
+  }
+  if (!buffer_info.native) {
     console.error(
-      "Could not get pool.buffer_pointer, cant' commit! pool",
+      "Buffer has no memory, cant' commit! pool",
       pool.wl_shm_pool_object_id,
       "buffer",
       buffer_id
     );
     return;
   }
-
-  const buffer_info = pool.buffers.get(buffer_id);
-  if (!buffer_info) {
-    debugger;
-    console.error("Could not get buffer_info, cant' commit!");
-    return;
-  }
   let x: number = surface.offset.x;
   let y: number = surface.offset.y;
   if (!surface.role) {
@@ -129,47 +127,24 @@ export const copy_buffer_to_wl_surface_texture = (
   surface.position.y = y;
   surface.position.z = z_index;
 
-  if (
-    surface.texture &&
-    (surface.texture.stride != buffer_info.stride ||
-      (surface.texture && surface.texture.height != buffer_info.height) ||
-      (surface.texture && surface.texture.width != buffer_info.width))
-  ) {
-    surface.texture = null;
-  }
-  if (!surface.texture) {
-    const buf = new Uint8ClampedArray(buffer_info.stride * buffer_info.height);
-    const sample = new ImageData(buf, buffer_info.width, buffer_info.height);
-    const canvas = createCanvas(buffer_info.width, buffer_info.height);
-    surface.texture = {
-      stride: buffer_info.stride,
-      width: buffer_info.width,
-      height: buffer_info.height,
-      buf,
-      canvas,
-      data: sample,
-    };
-  }
-
-  const success = cpp.memcopy_buffer_to_uint8array(
-    s.client_state,
-    pool.wl_shm_pool_object_id,
-    buffer_info.offset,
-    surface.texture.buf,
-    true
+  const native = cpp.update_texture(
+    surface.texture?.native ?? null,
+    buffer_info.native
   );
 
-  if (!success) {
+  if (!native) {
     /**
      * @TODO on failure should we remove the buffer?
      * or the texture? or both?
      */
-    console.error("Failed to copy buffer to uint8 array");
+    console.error("Failed to copy buffer to texture");
     return;
   }
-  surface.texture.canvas
-    .getContext("2d")
-    .putImageData(surface.texture.data, 0, 0);
+  surface.texture = {
+    width: buffer_info.width,
+    height: buffer_info.height,
+    native,
+  };
 
   s.drawable_surfaces.add(surface_id);
 };
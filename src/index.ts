@@ -3,7 +3,7 @@ import { Terminal_Window } from "./Terminal_Window.ts";
 import { virtual_monitor_size } from "./virtual_monitor_size.ts";
 //@ts-ignore
 import { set_virtual_monitor_size } from "./set_virtual_monitor_size.ts";
-import { parse_args } from "./parse_args.ts";
+import { parse_args, type Render_Mode } from "./parse_args.ts";
 import { start_xwayland_if_necessary } from "./start_xwayland_if_necessary.ts";
 import { spawn } from "child_process";
 
@@ -19,7 +19,23 @@ const terminal_window = new Terminal_Window(
   listener,
   args.values["hide-status-bar"],
   virtual_monitor_size,
-  will_show_app_right_at_startup
+  will_show_app_right_at_startup,
+  {
+    auto_tune: args.values["auto-tune"],
+    record_output: args.values["record-output"],
+    threads: Number(args.values["threads"] ?? 0),
+    profile_output: args.values["profile-output"],
+    kitty_placeholders: args.values["kitty-placeholders"],
+    kitty_windows: args.values["kitty-windows"],
+    render_mode: args.values["render-mode"] as Render_Mode,
+    motion_scale:
+      args.values["motion-scale"] === "auto"
+        ? "auto"
+        : Number(args.values["motion-scale"]),
+    record_input: args.values["record-input"],
+    replay_input: args.values["replay-input"],
+    replay_speed: Number(args.values["replay-speed"]),
+  }
 );
 
 listener.main_loop();
@@ -0,0 +1,191 @@
+import { wl_surface } from "./protocols/wl_surface.ts";
+import { wl_buffer } from "./protocols/wl_buffer.ts";
+import { Object_ID } from "./wayland_types.ts";
+import { Wayland_Client } from "./Wayland_Client.ts";
+import { Pending_Buffer_Updates } from "./objects/wl_surface.ts";
+import {
+  Reusable_List,
+  Surface_Update,
+  Surface_Update_Field as F,
+} from "./Surface_Update.ts";
+import { apply_wl_surface_double_buffered_state } from "./apply_wl_surface_double_buffered_state.ts";
+import { copy_buffer_to_wl_surface_texture } from "./copy_buffer_to_wl_surface_texture.ts";
+
+/**
+ * Commits are handled one at a time, so they
+ * all share one list of buffers to copy.
+ */
+const pending_buffer_texture_updates = new Reusable_List<Pending_Buffer_Updates>(
+  () => ({ surface: 0 as Object_ID<wl_surface>, buffer: null, z_index: 0 })
+);
+
+/**
+ * A surface can't have more commits than this waiting, each holds
+ * a buffer the client can't reuse. The oldest is applied early.
+ */
+const max_queued_updates = 4;
+/**
+ * A target time further ahead than this is moved up to
+ * it, so a commit can't hold its buffer indefinitely
+ */
+const max_target_time_ahead_seconds = 1;
+
+/**
+ * The clock of wp_commit_timer_v1 timestamps. Without wp_presentation
+ * to say otherwise that is CLOCK_MONOTONIC, which hrtime reads.
+ */
+export const monotonic_seconds = () => Number(process.hrtime.bigint()) / 1e9;
+
+/**
+ * Copies the buffers in the list to their surfaces and releases them.
+ * When a surface is in the list more than once, only its last buffer
+ * is copied, the ones before it would never be shown.
+ */
+const copy_and_release_buffers = (
+  s: Wayland_Client,
+  list: Reusable_List<Pending_Buffer_Updates>
+) => {
+  const { items, length } = list;
+  for (let i = 0; i < length; i++) {
+    const { surface, buffer, z_index } = items[i]!;
+    let superseded = false;
+    for (let j = i + 1; j < length; j++) {
+      if (items[j]!.surface === surface) {
+        superseded = true;
+        break;
+      }
+    }
+    if (!superseded) {
+      copy_buffer_to_wl_surface_texture(s, surface, z_index, buffer);
+    }
+  }
+  for (let i = 0; i < length; i++) {
+    const { buffer } = items[i]!;
+    /**
+     * @TODO Is there every an occasion where the buffer would
+     * be used more than once, ie can we always release it here?
+     */
+    if (buffer) {
+      wl_buffer.release(s, buffer);
+    }
+  }
+};
+
+/**
+ * Applies a commit that was queued, adding its
+ * buffer to pending_buffer_texture_updates
+ */
+const apply_queued_update = (
+  s: Wayland_Client,
+  surface_id: Object_ID<wl_surface>,
+  update: Surface_Update
+) => {
+  const surface = s.get_object(surface_id)!.delegate;
+  const pending_update = surface.pending_update;
+  surface.pending_update = update;
+  apply_wl_surface_double_buffered_state(
+    s,
+    surface_id,
+    false,
+    pending_buffer_texture_updates,
+    0
+  );
+  surface.pending_update = pending_update;
+  surface.spare_updates.push(update);
+};
+
+/**
+ * wl_surface.commit. Applies the pending state now, unless it has
+ * to wait for a fifo barrier or a target time, or an earlier commit
+ * of the surface is already waiting. Then it is queued, content
+ * updates are applied in the order they were committed.
+ */
+export const commit_surface = (
+  s: Wayland_Client,
+  surface_id: Object_ID<wl_surface>
+) => {
+  const surface = s.get_object(surface_id)?.delegate;
+  if (!surface) {
+    return;
+  }
+  const update = surface.pending_update;
+  if (update.has(F.target_time)) {
+    update.target_time = Math.min(
+      update.target_time,
+      monotonic_seconds() + max_target_time_ahead_seconds
+    );
+  }
+  if (
+    surface.queued_updates.length > 0 ||
+    (update.has(F.fifo_wait) && surface.fifo_barrier) ||
+    (update.has(F.target_time) && update.target_time > monotonic_seconds())
+  ) {
+    surface.queued_updates.push(update);
+    surface.pending_update = surface.spare_updates.pop() ?? new Surface_Update();
+    s.waiting_surfaces.add(surface_id);
+    if (surface.queued_updates.length <= max_queued_updates) {
+      return;
+    }
+    pending_buffer_texture_updates.clear();
+    while (surface.queued_updates.length > max_queued_updates) {
+      const oldest = surface.queued_updates.shift()!;
+      apply_queued_update(s, surface_id, oldest);
+    }
+    copy_and_release_buffers(s, pending_buffer_texture_updates);
+    return;
+  }
+
+  pending_buffer_texture_updates.clear();
+  apply_wl_surface_double_buffered_state(
+    s,
+    surface_id,
+    false,
+    pending_buffer_texture_updates,
+    0
+  );
+  copy_and_release_buffers(s, pending_buffer_texture_updates);
+};
+
+/**
+ * Called once per frame, before the desktop is published. Clears
+ * the fifo barriers set since the last frame, then applies the
+ * queued commits that are ready: every one whose target time is
+ * before the deadline, and at most one per barrier. Of several
+ * ready commits only the last buffer is copied.
+ *
+ * @param deadline seconds of CLOCK_MONOTONIC, commits targeting
+ * a time before it are shown this frame
+ */
+export const latch_surface_commits = (
+  clients: Iterable<Wayland_Client>,
+  deadline: number
+) => {
+  for (const s of clients) {
+    for (const surface_id of s.waiting_surfaces) {
+      const surface = s.get_object(surface_id)?.delegate;
+      if (!surface) {
+        s.waiting_surfaces.delete(surface_id);
+        continue;
+      }
+      surface.fifo_barrier = false;
+
+      pending_buffer_texture_updates.clear();
+      while (surface.queued_updates.length > 0) {
+        const update = surface.queued_updates[0]!;
+        if (update.has(F.fifo_wait) && surface.fifo_barrier) {
+          break;
+        }
+        if (update.has(F.target_time) && update.target_time > deadline) {
+          break;
+        }
+        surface.queued_updates.shift();
+        apply_queued_update(s, surface_id, update);
+      }
+      copy_and_release_buffers(s, pending_buffer_texture_updates);
+
+      if (surface.queued_updates.length === 0 && !surface.fifo_barrier) {
+        s.waiting_surfaces.delete(surface_id);
+      }
+    }
+  }
+};
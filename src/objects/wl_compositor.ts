@@ -1,9 +1,8 @@
-import {
-  wl_compositor_delegate as d,
-} from "../protocols/wayland.xml.ts";
+import { wl_compositor_delegate as d } from "../protocols/wl_compositor.ts";
 
 import { wl_region } from "./wl_region.ts";
 import { wl_surface as wl_surface_class } from "./wl_surface.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_compositor implements d {
   wl_compositor_create_surface: d["wl_compositor_create_surface"] = (
@@ -65,6 +64,6 @@ export class wl_compositor implements d {
 }
 
 export function make_wl_compositor() {
-  const { wl_compositor: WlCompositorProtocol } = require("../protocols/wayland.xml.ts");
+  const WlCompositorProtocol = load_protocol("wl_compositor");
   return new WlCompositorProtocol(new wl_compositor());
 }
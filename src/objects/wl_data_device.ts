@@ -2,8 +2,8 @@ import { auto_release } from "../auto_release.ts";
 import {
   wl_data_device_delegate as d,
   wl_data_device as w,
-  wl_seat,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_data_device.ts";
+import { wl_seat } from "../protocols/wl_seat.ts";
 import { Object_ID } from "../wayland_types.ts";
 
 export class wl_data_device implements d {
@@ -1,9 +1,8 @@
-import {
-  wl_data_device_manager_delegate as d,
-} from "../protocols/wayland.xml.ts";
+import { wl_data_device_manager_delegate as d } from "../protocols/wl_data_device_manager.ts";
 
 import { wl_data_device } from "./wl_data_device.ts";
 import { wl_data_source } from "./wl_data_source.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_data_device_manager implements d {
   wl_data_device_manager_create_data_source: d["wl_data_device_manager_create_data_source"] =
@@ -27,6 +26,6 @@ export class wl_data_device_manager implements d {
 }
 
 export function make_wl_data_device_manager() {
-  const { wl_data_device_manager: WlDataDeviceManagerProtocol } = require("../protocols/wayland.xml.ts");
+  const WlDataDeviceManagerProtocol = load_protocol("wl_data_device_manager");
   return new WlDataDeviceManagerProtocol(new wl_data_device_manager());
 }
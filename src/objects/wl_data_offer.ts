@@ -1,8 +1,9 @@
+import { closeSync } from "node:fs";
 import { auto_release } from "../auto_release.ts";
 import {
   wl_data_offer_delegate as d,
   wl_data_offer as w,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_data_offer.ts";
 
 export class wl_data_offer implements d {
   wl_data_offer_accept: d["wl_data_offer_accept"] = (
@@ -17,9 +18,16 @@ export class wl_data_offer implements d {
     _s,
     _object_id,
     _mime_type,
-    _fd
+    fd
   ) => {
     /** @TODO: Implement wl_data_offer_receive */
+    /**
+     * Nothing is written yet, closing our end
+     * at least lets the client see end of file
+     */
+    if (typeof fd === "number") {
+      closeSync(fd);
+    }
   };
   wl_data_offer_destroy: d["wl_data_offer_destroy"] = auto_release;
   wl_data_offer_finish: d["wl_data_offer_finish"] = (_s, _object_id) => {
@@ -2,8 +2,8 @@ import { auto_release } from "../auto_release.ts";
 import {
   wl_data_source_delegate as d,
   wl_data_source as w,
-  wl_data_device_manager_dnd_action,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_data_source.ts";
+import { wl_data_device_manager_dnd_action } from "../protocols/wl_data_device_manager.ts";
 
 export class wl_data_source implements d {
   mime_types: string[] = [];
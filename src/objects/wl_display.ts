@@ -1,10 +1,9 @@
 import { advertised_global_objects_names } from "../GlobalObjects.ts";
-import {
-  wl_display_delegate as d,
-  wl_registry as wl_registry_funcs,
-  wl_callback,
-} from "../protocols/wayland.xml.ts";
+import { wl_display_delegate as d } from "../protocols/wl_display.ts";
+import { wl_registry as wl_registry_funcs } from "../protocols/wl_registry.ts";
+import { wl_callback } from "../protocols/wl_callback.ts";
 import { wl_registry } from "./wl_registry.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_display implements d {
   wl_display_sync: d["wl_display_sync"] = (s, _object_id, callback) => {
@@ -32,6 +31,6 @@ export class wl_display implements d {
 }
 
 export function make_wl_display() {
-  const { wl_display: WlDisplayProtocol } = require("../protocols/wayland.xml.ts");
+  const WlDisplayProtocol = load_protocol("wl_display");
   return new WlDisplayProtocol(new wl_display());
 }
@@ -1,7 +1,7 @@
 import {
   wl_keyboard_delegate as d,
   wl_keyboard_keymap_format,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_keyboard.ts";
 import { Wayland_Client } from "../Wayland_Client.ts";
 import c, { Get_FD_Flags } from "../c_interop.ts";
 import { File_Descriptor, Object_ID } from "../wayland_types.ts";
@@ -10,6 +10,7 @@ import server_file from "../../resources/server-1.xkb" with { type: "file" };
 import { mkdtempSync } from "node:fs";
 import { tmpdir } from "node:os";
 import { auto_release } from "../auto_release.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_keyboard implements d {
   key_map_fd: Promise<{ fd: File_Descriptor; size: number } | null>;
@@ -38,7 +39,7 @@ export class wl_keyboard implements d {
       console.error("key_map_fd is null");
       return;
     }
-    const { wl_keyboard: WlKeyboardProtocol } = require("../protocols/wayland.xml.ts");
+    const WlKeyboardProtocol = load_protocol("wl_keyboard");
     WlKeyboardProtocol.keymap(
       s,
       object_id,
@@ -51,6 +52,6 @@ export class wl_keyboard implements d {
 }
 
 export function make_wl_keyboard() {
-  const { wl_keyboard: WlKeyboardProtocol } = require("../protocols/wayland.xml.ts");
+  const WlKeyboardProtocol = load_protocol("wl_keyboard");
   return new WlKeyboardProtocol(new wl_keyboard());
 }
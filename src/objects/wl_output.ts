@@ -4,9 +4,10 @@ import {
   wl_output_transform,
   wl_output_subpixel,
   wl_output_mode,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_output.ts";
 import { virtual_monitor_size } from "../virtual_monitor_size.ts";
 import { version } from "../wayland_types.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_output implements d {
   version: version = 1;
@@ -19,7 +20,7 @@ export class wl_output implements d {
     version
   ) => {
     this.version = version;
-    const { wl_output: WlOutputProtocol } = require("../protocols/wayland.xml.ts");
+    const WlOutputProtocol = load_protocol("wl_output");
 
     WlOutputProtocol.scale(s, version, new_id, 1);
     WlOutputProtocol.name(s, version, new_id, "mon-os world");
@@ -50,6 +51,6 @@ export class wl_output implements d {
 }
 
 export function make_wl_output() {
-  const { wl_output: WlOutputProtocol } = require("../protocols/wayland.xml.ts");
+  const WlOutputProtocol = load_protocol("wl_output");
   return new WlOutputProtocol(new wl_output());
 }
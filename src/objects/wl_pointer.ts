@@ -3,8 +3,8 @@ import {
   wl_pointer_delegate as d,
   wl_pointer as w,
   wl_pointer_error,
-  wl_surface,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_pointer.ts";
+import { wl_surface } from "../protocols/wl_surface.ts";
 
 import { Object_ID } from "../wayland_types.ts";
 import { Wayland_Client } from "../Wayland_Client.ts";
@@ -20,6 +20,37 @@ export class wl_pointer implements d {
     y: 0,
   };
 
+  /**
+   * The CSS name of the shape set with wp_cursor_shape_device_v1,
+   * null while a client draws its own cursor surface. The terminal
+   * shows it as its own mouse pointer, so a shape costs no pixels.
+   */
+  cursor_shape: string | null = null;
+
+  /**
+   * The cursor surface of the client stops being one, it
+   * is no longer drawn
+   */
+  drop_cursor_surface = (s: Wayland_Client) => {
+    const pointer_surface_id = this.pointer_surface_id.get(s) ?? null;
+    if (pointer_surface_id === null) {
+      return;
+    }
+    const old_pointer_surface = s.get_object(pointer_surface_id)?.delegate;
+    if (old_pointer_surface) {
+      old_pointer_surface.texture = null;
+      if (old_pointer_surface.role?.type === "cursor") {
+        old_pointer_surface.role = null;
+      }
+    }
+    this.pointer_surface_id.set(s, null);
+  };
+
+  set_cursor_shape = (s: Wayland_Client, shape: string) => {
+    this.drop_cursor_surface(s);
+    this.cursor_shape = shape;
+  };
+
   // last_pointer_enter_serial: number = 0;
 
   wl_pointer_set_cursor: d["wl_pointer_set_cursor"] = (
@@ -38,17 +69,10 @@ export class wl_pointer implements d {
     //   console.error("Ignoring set cursor for stale serial");
     //   return;
     // }
-    const pointer_surface_id = this.pointer_surface_id.get(s) ?? null;
-    if (pointer_surface_id !== null && pointer_surface_id !== surface_id) {
-      const old_pointer_surface = s.get_object(pointer_surface_id)?.delegate;
-      if (old_pointer_surface) {
-        old_pointer_surface.texture = null;
-        // old_pointer_surface.destroy_texture(s, pointer_surface_id);
-        if (old_pointer_surface?.role?.type === "cursor") {
-          old_pointer_surface.role = null;
-        }
-      }
+    if ((this.pointer_surface_id.get(s) ?? null) !== surface_id) {
+      this.drop_cursor_surface(s);
     }
+    this.cursor_shape = null;
 
     this.pointer_surface_id.set(s, surface_id);
 
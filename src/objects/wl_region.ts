@@ -1,7 +1,7 @@
 import {
   wl_region_delegate as d,
   wl_region as w,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_region.ts";
 import { auto_release } from "../auto_release.ts";
 
 export class wl_region implements d {
@@ -2,7 +2,7 @@ import { Global_Ids } from "../GlobalObjects.ts";
 import {
   wl_registry_delegate as d,
   wl_registry as w,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_registry.ts";
 import { Object_ID, version } from "../wayland_types.ts";
 import { wayland_debug_time_only } from "../debug.ts" with { type: "macro" };
 
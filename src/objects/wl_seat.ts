@@ -4,8 +4,9 @@ import {
   wl_seat_delegate as d,
   wl_seat_capability,
   wl_seat_error,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_seat.ts";
 import { version } from "../wayland_types.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_seat implements d {
   version: version = 1;
@@ -37,7 +38,7 @@ export class wl_seat implements d {
     version
   ) => {
     this.version = version;
-    const { wl_seat: WlSeatProtocol } = require("../protocols/wayland.xml.ts");
+    const WlSeatProtocol = load_protocol("wl_seat");
     WlSeatProtocol.capabilities(
       s,
       new_id,
@@ -48,6 +49,6 @@ export class wl_seat implements d {
 }
 
 export const make_wl_seat = () => {
-  const { wl_seat: WlSeatProtocol } = require("../protocols/wayland.xml.ts");
+  const WlSeatProtocol = load_protocol("wl_seat");
   return new WlSeatProtocol(new wl_seat());
 };
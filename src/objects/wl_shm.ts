@@ -2,8 +2,9 @@ import { auto_release } from "../auto_release.ts";
 import {
   wl_shm_delegate as d,
   wl_shm_format,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_shm.ts";
 import { wl_shm_pool } from "./wl_shm_pool.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_shm implements d {
   wl_shm_create_pool: d["wl_shm_create_pool"] = (
@@ -26,12 +27,19 @@ export class wl_shm implements d {
    */
   wl_shm_release: d["wl_shm_release"] = auto_release;
   wl_shm_on_bind: d["wl_shm_on_bind"] = (s, _name, _interface_, new_id) => {
-    const { wl_shm: WlShmProtocol } = require("../protocols/wayland.xml.ts");
+    const WlShmProtocol = load_protocol("wl_shm");
     WlShmProtocol.format(s, new_id, wl_shm_format.argb8888);
+    WlShmProtocol.format(s, new_id, wl_shm_format.xrgb8888);
+    /**
+     * Video players can hand over decoded frames as they are,
+     * the conversion to BGRA happens natively on copy
+     */
+    WlShmProtocol.format(s, new_id, wl_shm_format.nv12);
+    WlShmProtocol.format(s, new_id, wl_shm_format.yuyv);
   };
 }
 
 export function make_wl_shm() {
-  const { wl_shm: WlShmProtocol } = require("../protocols/wayland.xml.ts");
+  const WlShmProtocol = load_protocol("wl_shm");
   return new WlShmProtocol(new wl_shm());
 }
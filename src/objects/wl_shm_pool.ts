@@ -1,25 +1,18 @@
 import {
   wl_shm_pool_delegate as d,
   wl_shm_pool as w,
-  wl_buffer_delegate,
-} from "../protocols/wayland.xml.ts";
-
-import {
-  wl_buffer_delegate as buffer_delegate,
-  wl_buffer,
-  wl_shm_format,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_shm_pool.ts";
+import { wl_buffer_delegate, wl_buffer } from "../protocols/wl_buffer.ts";
+import { wl_shm_format } from "../protocols/wl_shm.ts";
 
 import { Wayland_Client } from "../Wayland_Client.ts";
-import c from "../c_interop.ts";
+import c, { Native_Buffer } from "../c_interop.ts";
 import { never_default } from "../never_default.ts";
 import { File_Descriptor, Object_ID } from "../wayland_types.ts";
 
 export enum Map_State {
   destroyed,
   mmapped,
-
-  destroy_when_buffers_empty,
 }
 
 export interface BufferInfo {
@@ -28,9 +21,14 @@ export interface BufferInfo {
   height: number;
   stride: number;
   format: wl_shm_format;
+  /**
+   * Keeps the mapping the buffer was made in alive,
+   * null if the buffer could not be made
+   */
+  native: Native_Buffer | null;
 }
 
-export class wl_shm_pool implements d, buffer_delegate {
+export class wl_shm_pool implements d, wl_buffer_delegate {
   map_state: Map_State;
   buffers = new Map<Object_ID<wl_buffer>, BufferInfo>();
 
@@ -54,6 +52,18 @@ export class wl_shm_pool implements d, buffer_delegate {
       height,
       stride,
       format,
+      native:
+        this.map_state === Map_State.mmapped
+          ? c.create_shm_buffer(
+              s.client_state,
+              this.wl_shm_pool_object_id,
+              offset,
+              width,
+              height,
+              stride,
+              format
+            )
+          : null,
       // data,
       // texture,
     });
@@ -72,18 +82,21 @@ export class wl_shm_pool implements d, buffer_delegate {
    * @returns false because wl_shm_pool hndles remove objet by itself
    */
   wl_shm_pool_destroy: d["wl_shm_pool_destroy"] = (s, _object_id) => {
-    const buffers_empty = this.buffers.size <= 0;
     switch (this.map_state) {
       case Map_State.destroyed:
-      case Map_State.destroy_when_buffers_empty:
+        /**
+         * The map or a resize failed, the memory is gone
+         * but the object is still there until now
+         */
+        s.remove_object(this.wl_shm_pool_object_id);
         return false;
       case Map_State.mmapped:
-        if (buffers_empty) {
-          this.on_destroy_shm_pool(s);
-          return false;
-        }
-        this.map_state = Map_State.destroy_when_buffers_empty;
-
+        /**
+         * The buffers still hold the memory they
+         * were made in, it is unmapped when the last
+         * one is released.
+         */
+        this.on_destroy_shm_pool(s);
         return false;
       default:
         never_default(this.map_state);
@@ -95,7 +108,6 @@ export class wl_shm_pool implements d, buffer_delegate {
       case Map_State.destroyed:
         return;
       case Map_State.mmapped:
-      case Map_State.destroy_when_buffers_empty:
         const success = c.remap_shm_pool(
           s.client_state,
           this.wl_shm_pool_object_id,
@@ -190,7 +202,7 @@ export class wl_shm_pool implements d, buffer_delegate {
   ) => {};
 
   wl_buffer_destroy: wl_buffer_delegate["wl_buffer_destroy"] = (
-    s,
+    _s,
     buffer_object_id
   ) => {
     /**
@@ -204,21 +216,11 @@ export class wl_shm_pool implements d, buffer_delegate {
       );
       return true;
     }
-    this.buffers.delete(buffer_object_id);
-    switch (this.map_state) {
-      case Map_State.destroyed:
-      case Map_State.mmapped:
-        return true;
-      case Map_State.destroy_when_buffers_empty:
-        if (this.buffers.size > 0) {
-          return true;
-        }
-        this.on_destroy_shm_pool(s);
-
-        return true;
-      default:
-        never_default(this.map_state);
-        return true;
+    const native = this.buffers.get(buffer_object_id)!.native;
+    if (native) {
+      c.release_shm_buffer(native);
     }
+    this.buffers.delete(buffer_object_id);
+    return true;
   };
 }
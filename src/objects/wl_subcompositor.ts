@@ -2,8 +2,9 @@ import { auto_release } from "../auto_release.ts";
 import {
   wl_subcompositor_delegate,
   wl_subcompositor_error,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_subcompositor.ts";
 import { wl_subsurface } from "./wl_subsurface.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_subcompositor implements wl_subcompositor_delegate {
   /**
@@ -75,8 +76,7 @@ export class wl_subcompositor implements wl_subcompositor_delegate {
 
       surface.role.data = id;
 
-      parent_surface.pending_update.add_sub_surface ??= [];
-      parent_surface.pending_update.add_sub_surface.push(surface_id);
+      parent_surface.pending_update.push_sub_surface(surface_id);
       s.register_role_to_surface(id, surface_id);
 
       s.add_object(id, wl_subsurface.make(parent_surface_id));
@@ -88,6 +88,6 @@ export class wl_subcompositor implements wl_subcompositor_delegate {
 }
 
 export function make_wl_subcompositor() {
-  const { wl_subcompositor: WlSubcompositorProtocol } = require("../protocols/wayland.xml.ts");
+  const WlSubcompositorProtocol = load_protocol("wl_subcompositor");
   return new WlSubcompositorProtocol(new wl_subcompositor());
 }
@@ -2,8 +2,8 @@ import {
   wl_subsurface_delegate,
   wl_subsurface as w,
   wl_subsurface_error,
-  wl_surface,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_subsurface.ts";
+import { wl_surface } from "../protocols/wl_surface.ts";
 import { Object_ID } from "../wayland_types.ts";
 import { Wayland_Client } from "../Wayland_Client.ts";
 
@@ -73,13 +73,7 @@ export class wl_subsurface implements wl_subsurface_delegate {
         );
         return;
       }
-      parent.pending_update.set_child_position ??= [];
-
-      parent.pending_update.set_child_position.push({
-        child: surface_id,
-        x,
-        y,
-      });
+      parent.pending_update.set_child_position_of(surface_id, x, y);
     };
 
   wl_subsurface_place_above: wl_subsurface_delegate["wl_subsurface_place_above"] =
@@ -115,13 +109,7 @@ export class wl_subsurface implements wl_subsurface_delegate {
     }
     const id =
       sibling_or_parent_id === this.parent ? null : sibling_or_parent_id;
-    parent.pending_update.z_order_subsurfaces ??= [];
-
-    parent.pending_update.z_order_subsurfaces.push({
-      type: above_or_below,
-      child_to_move: surface_id,
-      relative_to: id,
-    });
+    parent.pending_update.place_child(above_or_below, surface_id, id);
   };
   wl_subsurface_place_below: wl_subsurface_delegate["wl_subsurface_place_below"] =
     (s, object_id, sibling_or_parent_id) => {
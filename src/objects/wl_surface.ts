@@ -2,17 +2,16 @@ import {
   wl_surface_delegate,
   wl_surface as w,
   wl_surface_error,
-  wl_buffer,
-  wl_output_transform,
-  wl_region,
-  xdg_surface,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/wl_surface.ts";
+import { wl_buffer } from "../protocols/wl_buffer.ts";
+import { wl_output_transform } from "../protocols/wl_output.ts";
+import { wl_region } from "../protocols/wl_region.ts";
+import { xdg_surface } from "../protocols/xdg_surface.ts";
 import { Object_ID } from "../wayland_types.ts";
-import { ImageData, Canvas } from "canvas";
+import { Native_Texture } from "../c_interop.ts";
 import { Surface_Update } from "../Surface_Update.ts";
 import { Surface_with_Role_and_Data, Surface_Role } from "../Surface_Role.ts";
-import { apply_wl_surface_double_buffered_state } from "../apply_wl_surface_double_buffered_state.ts";
-import { copy_buffer_to_wl_surface_texture } from "../copy_buffer_to_wl_surface_texture.ts";
+import { commit_surface } from "../latch_surface_commits.ts";
 
 export type Pending_Buffer_Updates = {
   surface: Object_ID<w>;
@@ -31,12 +30,9 @@ export class wl_surface implements wl_surface_delegate {
     z: 0,
   };
   texture: {
-    stride: number;
     width: number;
     height: number;
-    buf: Uint8ClampedArray;
-    data: ImageData;
-    canvas: Canvas;
+    native: Native_Texture;
   } | null = null;
 
   /**
@@ -64,7 +60,20 @@ export class wl_surface implements wl_surface_delegate {
    */
   opaque_region: Object_ID<wl_region> | null = null;
 
-  pending_update: Surface_Update = {};
+  pending_update = new Surface_Update();
+  /**
+   * Commits that wait for a fifo barrier or a target
+   * time, applied in order by latch_surface_commits
+   */
+  queued_updates: Surface_Update[] = [];
+  /**
+   * Updates that were queued and applied, kept for
+   * the next commits that have to wait
+   */
+  spare_updates: Surface_Update[] = [];
+  fifo_barrier = false;
+  has_fifo = false;
+  has_commit_timer = false;
   offset: { x: number; y: number } = { x: 0, y: 0 };
 
   // texture: Size | null = null;
@@ -162,10 +171,11 @@ export class wl_surface implements wl_surface_delegate {
     x,
     y
   ) => {
-    this.pending_update.buffer = buffer === 0 ? null : buffer;
+    this.pending_update.set_buffer(buffer === 0 ? null : buffer);
 
     if (s.compositor_version < 5) {
-      this.offset = { x, y };
+      this.offset.x = x;
+      this.offset.y = y;
       return;
     }
     if (x === 0 && y === 0) {
@@ -185,59 +195,38 @@ export class wl_surface implements wl_surface_delegate {
     width,
     height
   ) => {
-    this.pending_update.damage ??= [];
-    this.pending_update.damage.push({ x, y, width, height });
+    this.pending_update.add_damage("damage", x, y, width, height);
   };
   wl_surface_frame: wl_surface_delegate["wl_surface_frame"] = (
-    s,
+    _s,
     _object_id,
     callback
   ) => {
-    s.add_frame_draw_request(callback);
+    this.pending_update.add_frame_callback(callback);
   };
   wl_surface_set_opaque_region: wl_surface_delegate["wl_surface_set_opaque_region"] =
     (_s, _object_id, region) => {
-      this.pending_update.opaque_region = region;
+      this.pending_update.set_opaque_region(region);
     };
   wl_surface_set_input_region: wl_surface_delegate["wl_surface_set_input_region"] =
     (_s, _object_id, region) => {
-      this.pending_update.input_region = region;
+      this.pending_update.set_input_region(region);
     };
 
   wl_surface_commit: wl_surface_delegate["wl_surface_commit"] = (
     s,
     object_id
   ) => {
-    const pending_buffer_texture_updates: Pending_Buffer_Updates[] = [];
-    apply_wl_surface_double_buffered_state(
-      s,
-      object_id,
-      false,
-      pending_buffer_texture_updates,
-      0
-    );
-
-    for (const { surface, buffer, z_index } of pending_buffer_texture_updates) {
-      copy_buffer_to_wl_surface_texture(s, surface, z_index, buffer);
-    }
-    for (const { buffer } of pending_buffer_texture_updates) {
-      /**
-       * @TODO Is there every an occasion where the buffer would
-       * be used more than once, ie can we always release it here?
-       */
-      if (buffer) {
-        wl_buffer.release(s, buffer);
-      }
-    }
+    commit_surface(s, object_id);
   };
 
   wl_surface_set_buffer_transform: wl_surface_delegate["wl_surface_set_buffer_transform"] =
     (_s, _object_id, transform) => {
-      this.pending_update.buffer_transform = transform;
+      this.pending_update.set_buffer_transform(transform);
     };
   wl_surface_set_buffer_scale: wl_surface_delegate["wl_surface_set_buffer_scale"] =
     (_s, _object_id, scale) => {
-      this.pending_update.buffer_scale = scale;
+      this.pending_update.set_buffer_scale(scale);
     };
   wl_surface_damage_buffer: wl_surface_delegate["wl_surface_damage_buffer"] = (
     _s,
@@ -247,8 +236,7 @@ export class wl_surface implements wl_surface_delegate {
     width,
     height
   ) => {
-    this.pending_update.damage_buffer ??= [];
-    this.pending_update.damage_buffer.push({ x, y, width, height });
+    this.pending_update.add_damage("damage_buffer", x, y, width, height);
   };
   wl_surface_offset: wl_surface_delegate["wl_surface_offset"] = (
     _s,
@@ -256,7 +244,7 @@ export class wl_surface implements wl_surface_delegate {
     x,
     y
   ) => {
-    this.pending_update.offset = { x, y };
+    this.pending_update.set_offset(x, y);
   };
 
   wl_surface_on_bind: wl_surface_delegate["wl_surface_on_bind"] = (
@@ -1,7 +1,6 @@
 import { auto_release } from "../auto_release.ts";
-import {
-  wl_touch_delegate as d,
-} from "../protocols/wayland.xml.ts";
+import { wl_touch_delegate as d } from "../protocols/wl_touch.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class wl_touch implements d {
   wl_touch_release: d["wl_touch_release"] = auto_release;
@@ -17,6 +16,6 @@ export class wl_touch implements d {
 }
 
 export function make_wl_touch() {
-  const { wl_touch: WlTouchProtocol } = require("../protocols/wayland.xml.ts");
+  const WlTouchProtocol = load_protocol("wl_touch");
   return new WlTouchProtocol(new wl_touch());
 }
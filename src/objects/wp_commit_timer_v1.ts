@@ -0,0 +1,68 @@
+import {
+  wp_commit_timer_v1_delegate as d,
+  wp_commit_timer_v1 as w,
+  wp_commit_timer_v1_error,
+} from "../protocols/wp_commit_timer_v1.ts";
+import { wl_surface } from "../protocols/wl_surface.ts";
+import { Object_ID } from "../wayland_types.ts";
+import { Surface_Update_Field } from "../Surface_Update.ts";
+
+export class wp_commit_timer_v1 implements d {
+  wp_commit_timer_v1_set_timestamp: d["wp_commit_timer_v1_set_timestamp"] = (
+    s,
+    object_id,
+    tv_sec_hi,
+    tv_sec_lo,
+    tv_nsec
+  ) => {
+    const surface = s.get_object(this.surface_id)?.delegate;
+    if (!surface) {
+      s.send_error(
+        object_id,
+        wp_commit_timer_v1_error.surface_destroyed,
+        "the surface of the commit timer is gone"
+      );
+      return;
+    }
+    if (tv_nsec >= 1_000_000_000) {
+      s.send_error(
+        object_id,
+        wp_commit_timer_v1_error.invalid_timestamp,
+        `tv_nsec ${tv_nsec} is a second or more`
+      );
+      return;
+    }
+    if (surface.pending_update.has(Surface_Update_Field.target_time)) {
+      s.send_error(
+        object_id,
+        wp_commit_timer_v1_error.timestamp_exists,
+        "the surface already has a timestamp for this commit"
+      );
+      return;
+    }
+    surface.pending_update.set_target_time(
+      tv_sec_hi * 2 ** 32 + tv_sec_lo + tv_nsec / 1e9
+    );
+  };
+  wp_commit_timer_v1_destroy: d["wp_commit_timer_v1_destroy"] = (
+    s,
+    _object_id
+  ) => {
+    const surface = s.get_object(this.surface_id)?.delegate;
+    if (surface) {
+      surface.has_commit_timer = false;
+    }
+    return true;
+  };
+  wp_commit_timer_v1_on_bind: d["wp_commit_timer_v1_on_bind"] = (
+    _s,
+    _name,
+    _interface_,
+    _new_id,
+    _version_number
+  ) => {};
+  constructor(public surface_id: Object_ID<wl_surface>) {}
+  static make(surface_id: Object_ID<wl_surface>): w {
+    return new w(new wp_commit_timer_v1(surface_id));
+  }
+}
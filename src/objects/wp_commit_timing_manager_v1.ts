@@ -0,0 +1,39 @@
+import { Global_Ids } from "../GlobalObjects.ts";
+import {
+  wp_commit_timing_manager_v1_delegate as d,
+  wp_commit_timing_manager_v1_error,
+} from "../protocols/wp_commit_timing_manager_v1.ts";
+import { wp_commit_timer_v1 } from "./wp_commit_timer_v1.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
+
+export class wp_commit_timing_manager_v1 implements d {
+  wp_commit_timing_manager_v1_destroy: d["wp_commit_timing_manager_v1_destroy"] =
+    (s, object_id) => {
+      s.remove_global_bind(Global_Ids.wp_commit_timing_manager_v1, object_id);
+      return true;
+    };
+  wp_commit_timing_manager_v1_get_timer: d["wp_commit_timing_manager_v1_get_timer"] =
+    (s, object_id, id, surface_id) => {
+      const surface = s.get_object(surface_id)?.delegate;
+      if (!surface) {
+        return;
+      }
+      if (surface.has_commit_timer) {
+        s.send_error(
+          object_id,
+          wp_commit_timing_manager_v1_error.commit_timer_exists,
+          "surface already has a commit timer"
+        );
+        return;
+      }
+      surface.has_commit_timer = true;
+      s.add_object(id, wp_commit_timer_v1.make(surface_id));
+    };
+  wp_commit_timing_manager_v1_on_bind: d["wp_commit_timing_manager_v1_on_bind"] =
+    (_s, _name, _interface_, _new_id, _version_number) => {};
+}
+
+export function make_wp_commit_timing_manager_v1() {
+  const WpCommitTimingManagerV1Protocol = load_protocol("wp_commit_timing_manager_v1");
+  return new WpCommitTimingManagerV1Protocol(new wp_commit_timing_manager_v1());
+}
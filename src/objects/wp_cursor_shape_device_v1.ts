@@ -0,0 +1,37 @@
+import { auto_release } from "../auto_release.ts";
+import {
+  wp_cursor_shape_device_v1_delegate as d,
+  wp_cursor_shape_device_v1 as w,
+  wp_cursor_shape_device_v1_error,
+  wp_cursor_shape_device_v1_shape,
+} from "../protocols/wp_cursor_shape_device_v1.ts";
+import { pointer } from "./wl_pointer.ts";
+
+export class wp_cursor_shape_device_v1 implements d {
+  wp_cursor_shape_device_v1_destroy: d["wp_cursor_shape_device_v1_destroy"] =
+    auto_release;
+  wp_cursor_shape_device_v1_set_shape: d["wp_cursor_shape_device_v1_set_shape"] =
+    (s, object_id, _serial, shape) => {
+      if (wp_cursor_shape_device_v1_shape[shape] === undefined) {
+        s.send_error(
+          object_id,
+          wp_cursor_shape_device_v1_error.invalid_shape,
+          `invalid shape ${shape}`
+        );
+        return;
+      }
+      /**
+       * The names are the CSS ones, which is what OSC 22 takes
+       */
+      pointer.set_cursor_shape(
+        s,
+        wp_cursor_shape_device_v1_shape[shape].replaceAll("_", "-")
+      );
+    };
+  wp_cursor_shape_device_v1_on_bind: d["wp_cursor_shape_device_v1_on_bind"] =
+    (_s, _name, _interface_, _new_id, _version_number) => {};
+  constructor() {}
+  static make(): w {
+    return new w(new wp_cursor_shape_device_v1());
+  }
+}
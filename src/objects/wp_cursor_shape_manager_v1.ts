@@ -0,0 +1,26 @@
+import { Global_Ids } from "../GlobalObjects.ts";
+import { wp_cursor_shape_manager_v1_delegate as d } from "../protocols/wp_cursor_shape_manager_v1.ts";
+import { wp_cursor_shape_device_v1 } from "./wp_cursor_shape_device_v1.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
+
+export class wp_cursor_shape_manager_v1 implements d {
+  wp_cursor_shape_manager_v1_destroy: d["wp_cursor_shape_manager_v1_destroy"] =
+    (s, object_id) => {
+      s.remove_global_bind(Global_Ids.wp_cursor_shape_manager_v1, object_id);
+      return true;
+    };
+  wp_cursor_shape_manager_v1_get_pointer: d["wp_cursor_shape_manager_v1_get_pointer"] =
+    (s, _object_id, cursor_shape_device, _pointer) => {
+      /**
+       * There is only the one pointer
+       */
+      s.add_object(cursor_shape_device, wp_cursor_shape_device_v1.make());
+    };
+  wp_cursor_shape_manager_v1_on_bind: d["wp_cursor_shape_manager_v1_on_bind"] =
+    (_s, _name, _interface_, _new_id, _version_number) => {};
+}
+
+export function make_wp_cursor_shape_manager_v1() {
+  const WpCursorShapeManagerV1Protocol = load_protocol("wp_cursor_shape_manager_v1");
+  return new WpCursorShapeManagerV1Protocol(new wp_cursor_shape_manager_v1());
+}
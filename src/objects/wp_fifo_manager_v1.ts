@@ -0,0 +1,50 @@
+import { Global_Ids } from "../GlobalObjects.ts";
+import {
+  wp_fifo_manager_v1_delegate as d,
+  wp_fifo_manager_v1_error,
+} from "../protocols/wp_fifo_manager_v1.ts";
+import { wp_fifo_v1 } from "./wp_fifo_v1.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
+
+export class wp_fifo_manager_v1 implements d {
+  wp_fifo_manager_v1_destroy: d["wp_fifo_manager_v1_destroy"] = (
+    s,
+    object_id
+  ) => {
+    s.remove_global_bind(Global_Ids.wp_fifo_manager_v1, object_id);
+    return true;
+  };
+  wp_fifo_manager_v1_get_fifo: d["wp_fifo_manager_v1_get_fifo"] = (
+    s,
+    object_id,
+    id,
+    surface_id
+  ) => {
+    const surface = s.get_object(surface_id)?.delegate;
+    if (!surface) {
+      return;
+    }
+    if (surface.has_fifo) {
+      s.send_error(
+        object_id,
+        wp_fifo_manager_v1_error.already_exists,
+        "surface already has a fifo"
+      );
+      return;
+    }
+    surface.has_fifo = true;
+    s.add_object(id, wp_fifo_v1.make(surface_id));
+  };
+  wp_fifo_manager_v1_on_bind: d["wp_fifo_manager_v1_on_bind"] = (
+    _s,
+    _name,
+    _interface_,
+    _new_id,
+    _version_number
+  ) => {};
+}
+
+export function make_wp_fifo_manager_v1() {
+  const WpFifoManagerV1Protocol = load_protocol("wp_fifo_manager_v1");
+  return new WpFifoManagerV1Protocol(new wp_fifo_manager_v1());
+}
@@ -0,0 +1,51 @@
+import {
+  wp_fifo_v1_delegate as d,
+  wp_fifo_v1 as w,
+  wp_fifo_v1_error,
+} from "../protocols/wp_fifo_v1.ts";
+import { wl_surface } from "../protocols/wl_surface.ts";
+import { Object_ID } from "../wayland_types.ts";
+import { Wayland_Client } from "../Wayland_Client.ts";
+
+/**
+ * Both requests are double buffered, they go into the pending
+ * update of the surface and are looked at when it is committed,
+ * see commit_surface and latch_surface_commits.
+ */
+export class wp_fifo_v1 implements d {
+  surface_or_error = (s: Wayland_Client, object_id: Object_ID<w>) => {
+    const surface = s.get_object(this.surface_id)?.delegate;
+    if (!surface) {
+      s.send_error(
+        object_id,
+        wp_fifo_v1_error.surface_destroyed,
+        "the surface of the fifo is gone"
+      );
+    }
+    return surface;
+  };
+  wp_fifo_v1_set_barrier: d["wp_fifo_v1_set_barrier"] = (s, object_id) => {
+    this.surface_or_error(s, object_id)?.pending_update.set_fifo_barrier();
+  };
+  wp_fifo_v1_wait_barrier: d["wp_fifo_v1_wait_barrier"] = (s, object_id) => {
+    this.surface_or_error(s, object_id)?.pending_update.set_fifo_wait();
+  };
+  wp_fifo_v1_destroy: d["wp_fifo_v1_destroy"] = (s, _object_id) => {
+    const surface = s.get_object(this.surface_id)?.delegate;
+    if (surface) {
+      surface.has_fifo = false;
+    }
+    return true;
+  };
+  wp_fifo_v1_on_bind: d["wp_fifo_v1_on_bind"] = (
+    _s,
+    _name,
+    _interface_,
+    _new_id,
+    _version_number
+  ) => {};
+  constructor(public surface_id: Object_ID<wl_surface>) {}
+  static make(surface_id: Object_ID<wl_surface>): w {
+    return new w(new wp_fifo_v1(surface_id));
+  }
+}
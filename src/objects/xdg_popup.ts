@@ -1,8 +1,8 @@
 import {
   xdg_popup_delegate,
   xdg_popup as w,
-  xdg_surface,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xdg_popup.ts";
+import { xdg_surface } from "../protocols/xdg_surface.ts";
 import { Object_ID, version } from "../wayland_types.ts";
 import { xdg_positioner_state } from "./xdg_positioner.ts";
 // import { configure } from "./xdg_surface.ts";
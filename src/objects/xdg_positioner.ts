@@ -5,7 +5,7 @@ import {
   xdg_positioner_anchor,
   xdg_positioner_gravity,
   xdg_positioner_constraint_adjustment,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xdg_positioner.ts";
 import { Size } from "../Size.ts";
 
 export interface xdg_positioner_state {
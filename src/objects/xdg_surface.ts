@@ -3,13 +3,12 @@ import {
   xdg_surface_delegate,
   xdg_surface as w,
   xdg_surface_error,
-  xdg_popup as xdg_popup_funcs,
-  wl_pointer,
-  wl_surface,
-  wl_keyboard,
-  xdg_toplevel as xdg_toplevel_funcs,
-  xdg_toplevel_state,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xdg_surface.ts";
+import { xdg_popup as xdg_popup_funcs } from "../protocols/xdg_popup.ts";
+import { wl_pointer } from "../protocols/wl_pointer.ts";
+import { wl_surface } from "../protocols/wl_surface.ts";
+import { wl_keyboard } from "../protocols/wl_keyboard.ts";
+import { xdg_toplevel as xdg_toplevel_funcs } from "../protocols/xdg_toplevel.ts";
 import { virtual_monitor_size } from "../virtual_monitor_size.ts";
 import { Object_ID, version } from "../wayland_types.ts";
 import { Wayland_Client } from "../Wayland_Client.ts";
@@ -114,7 +113,8 @@ export class xdg_surface implements xdg_surface_delegate {
 
     surface.role.data = id;
 
-    s.add_object(id, xdg_toplevel.make());
+    const toplevel = new xdg_toplevel(this.version);
+    s.add_object(id, new xdg_toplevel_funcs(toplevel));
     s.register_role_to_surface(id, surface_id);
     s.top_level_surfaces.add(id);
 
@@ -123,7 +123,7 @@ export class xdg_surface implements xdg_surface_delegate {
       id,
       virtual_monitor_size.width,
       virtual_monitor_size.height,
-      [xdg_toplevel_state.maximized, xdg_toplevel_state.fullscreen]
+      toplevel.states({ maximized: true, fullscreen: true })
     );
 
     /**
@@ -281,12 +281,7 @@ export class xdg_surface implements xdg_surface_delegate {
       if (!surface) {
         return;
       }
-      surface.pending_update.xdg_surface_window_geometry = {
-        x,
-        y,
-        width,
-        height,
-      };
+      surface.pending_update.set_window_geometry(x, y, width, height);
     };
   xdg_surface_ack_configure: xdg_surface_delegate["xdg_surface_ack_configure"] =
     (_s, _object_id, serial) => {
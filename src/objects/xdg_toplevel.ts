@@ -2,9 +2,9 @@ import {
   xdg_toplevel_delegate as d,
   xdg_toplevel as w,
   xdg_toplevel_state,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xdg_toplevel.ts";
 import { Wayland_Client } from "../Wayland_Client.ts";
-import { Object_ID } from "../wayland_types.ts";
+import { Object_ID, version } from "../wayland_types.ts";
 // import { configure } from "./xdg_surface.ts";
 import { virtual_monitor_size } from "../virtual_monitor_size.ts";
 
@@ -117,17 +117,56 @@ export class xdg_toplevel implements d {
       object_id,
       virtual_monitor_size.width,
       virtual_monitor_size.height,
-
-      (state.maximized ? [xdg_toplevel_state.maximized] : []).concat(
-        state.fullscreen ? [xdg_toplevel_state.fullscreen] : []
-      )
+      this.states(state)
     );
-    await xdg_surface_state.configure(s)
+    await xdg_surface_state.configure(s);
 
     // await configure(s, surface.xdg_surface_state);
     return true;
   };
 
+  /**
+   * Every toplevel fills the virtual monitor, so every edge is
+   * against the edge of the screen. Saying so in tiled states
+   * has toolkits drop their shadows and rounded corners, which
+   * are pixels that would be copied and blended every frame
+   * for nothing.
+   */
+  states = (state: {
+    maximized: boolean;
+    fullscreen: boolean;
+  }): xdg_toplevel_state[] => {
+    const states: xdg_toplevel_state[] = [];
+    if (state.maximized) {
+      states.push(xdg_toplevel_state.maximized);
+    }
+    if (state.fullscreen) {
+      states.push(xdg_toplevel_state.fullscreen);
+    }
+    if (this.version >= 2) {
+      states.push(
+        xdg_toplevel_state.tiled_left,
+        xdg_toplevel_state.tiled_right,
+        xdg_toplevel_state.tiled_top,
+        xdg_toplevel_state.tiled_bottom
+      );
+    }
+    return states;
+  };
+
+  /**
+   * Sends the current state again, for when something outside
+   * the toplevel changed what the client should draw
+   */
+  configure_again = (
+    s: Wayland_Client,
+    object_id: Object_ID<w>
+  ): Promise<boolean> =>
+    this.state_configuration(s, object_id, {
+      maximized: this.maximized,
+      fullscreen: this.fullscreen,
+    });
+
   xdg_toplevel_set_maximized: d["xdg_toplevel_set_maximized"] = (
     s,
     object_id
@@ -147,7 +186,7 @@ export class xdg_toplevel implements d {
     object_id
   ) => {
     this.state_configuration(s, object_id, {
-      maximized: true,
+      maximized: false,
       fullscreen: this.fullscreen,
     }).then((should_change) => {
       if (!should_change) {
@@ -204,16 +243,19 @@ export class xdg_toplevel implements d {
   app_id: string = "";
   min_size: { width: number; height: number } | null = null;
   max_size: { width: number; height: number } | null = null;
-  maximized: boolean = false;
-  fullscreen: boolean = false;
+  /**
+   * The first configure asks for both
+   */
+  maximized: boolean = true;
+  fullscreen: boolean = true;
 
   pending_state?: {
     min_size?: { width: number; height: number } | null;
     max_size?: { width: number; height: number } | null;
   };
 
-  constructor() {}
-  static make(): w {
-    return new w(new xdg_toplevel());
+  constructor(public version: version) {}
+  static make(version: version): w {
+    return new w(new xdg_toplevel(version));
   }
 }
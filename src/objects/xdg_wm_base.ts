@@ -2,10 +2,11 @@ import { auto_release } from "../auto_release.ts";
 import {
   xdg_wm_base_delegate,
   xdg_wm_base_error,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xdg_wm_base.ts";
 import { version } from "../wayland_types.ts";
 import { xdg_positioner } from "./xdg_positioner.ts";
 import { xdg_surface } from "./xdg_surface.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class xdg_wm_base implements xdg_wm_base_delegate {
   version: version = 1;
@@ -75,6 +76,6 @@ export class xdg_wm_base implements xdg_wm_base_delegate {
 }
 
 export function make_xdg_wm_base() {
-  const { xdg_wm_base: XdgWmBaseProtocol } = require("../protocols/wayland.xml.ts");
+  const XdgWmBaseProtocol = load_protocol("xdg_wm_base");
   return new XdgWmBaseProtocol(new xdg_wm_base());
 }
@@ -2,9 +2,10 @@ import { Global_Ids } from "../GlobalObjects.ts";
 import {
   xwayland_shell_v1_delegate as d,
   xwayland_shell_v1_error,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xwayland_shell_v1.ts";
 
 import { xwayland_surface_v1 } from "./xwayland_surface_v1.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class xwayland_shell_v1 implements d {
   xwayland_shell_v1_destroy: d["xwayland_shell_v1_destroy"] = (
@@ -62,6 +63,6 @@ export class xwayland_shell_v1 implements d {
 }
 
 export function make_xwayland_shell_v1() {
-  const { xwayland_shell_v1: XwaylandShellV1Protocol } = require("../protocols/wayland.xml.ts");
+  const XwaylandShellV1Protocol = load_protocol("xwayland_shell_v1");
   return new XwaylandShellV1Protocol(new xwayland_shell_v1());
 }
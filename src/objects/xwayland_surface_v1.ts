@@ -1,7 +1,7 @@
 import {
   xwayland_surface_v1_delegate as d,
   xwayland_surface_v1 as w,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/xwayland_surface_v1.ts";
 
 export class xwayland_surface_v1 implements d {
   xwayland_surface_v1_set_serial: d["xwayland_surface_v1_set_serial"] = (
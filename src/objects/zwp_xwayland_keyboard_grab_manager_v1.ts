@@ -1,8 +1,7 @@
 import { Global_Ids } from "../GlobalObjects.ts";
-import {
-  zwp_xwayland_keyboard_grab_manager_v1_delegate as d,
-} from "../protocols/wayland.xml.ts";
+import { zwp_xwayland_keyboard_grab_manager_v1_delegate as d } from "../protocols/zwp_xwayland_keyboard_grab_manager_v1.ts";
 import { zwp_xwayland_keyboard_grab_v1 } from "./zwp_xwayland_keyboard_grab_v1.ts";
+import { load_protocol } from "../protocols/protocol_registry.ts";
 
 export class zwp_xwayland_keyboard_grab_manager_v1 implements d {
   zwp_xwayland_keyboard_grab_manager_v1_destroy: d["zwp_xwayland_keyboard_grab_manager_v1_destroy"] =
@@ -25,6 +24,6 @@ export class zwp_xwayland_keyboard_grab_manager_v1 implements d {
 }
 
 export function make_zwp_xwayland_keyboard_grab_manager_v1() {
-  const { zwp_xwayland_keyboard_grab_manager_v1: ZwpXwaylandKeyboardGrabManagerV1Protocol } = require("../protocols/wayland.xml.ts");
+  const ZwpXwaylandKeyboardGrabManagerV1Protocol = load_protocol("zwp_xwayland_keyboard_grab_manager_v1");
   return new ZwpXwaylandKeyboardGrabManagerV1Protocol(new zwp_xwayland_keyboard_grab_manager_v1());
 }
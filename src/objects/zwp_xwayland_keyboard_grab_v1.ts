@@ -1,7 +1,7 @@
 import {
   zwp_xwayland_keyboard_grab_v1_delegate as d,
   zwp_xwayland_keyboard_grab_v1 as w,
-} from "../protocols/wayland.xml.ts";
+} from "../protocols/zwp_xwayland_keyboard_grab_v1.ts";
 
 export class zwp_xwayland_keyboard_grab_v1 implements d {
   zwp_xwayland_keyboard_grab_v1_destroy: d["zwp_xwayland_keyboard_grab_v1_destroy"] =
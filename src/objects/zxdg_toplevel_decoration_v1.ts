@@ -2,61 +2,38 @@ import { auto_release } from "../auto_release.ts";
 import {
   zxdg_toplevel_decoration_v1_delegate as d,
   zxdg_toplevel_decoration_v1 as w,
-  xdg_toplevel,
-  xdg_surface,
-} from "../protocols/wayland.xml.ts";
+  zxdg_toplevel_decoration_v1_mode,
+} from "../protocols/zxdg_toplevel_decoration_v1.ts";
+import { xdg_toplevel } from "../protocols/xdg_toplevel.ts";
 import { Object_ID } from "../wayland_types.ts";
+import { Wayland_Client } from "../Wayland_Client.ts";
 
 export class zxdg_toplevel_decoration_v1 implements d {
+  /**
+   * Whatever the client asks for, decorations are server side.
+   * The compositor doesn't draw any, so that is no title bar and
+   * no shadow: fewer pixels per window and nothing to blend at
+   * the edges.
+   *
+   * The mode only takes effect with the xdg_surface.configure
+   * after it, so the toplevel is configured again too.
+   */
+  configure = (s: Wayland_Client, object_id: Object_ID<w>) => {
+    w.configure(s, object_id, zxdg_toplevel_decoration_v1_mode.server_side);
+    s.get_object(this.xdg_toplevel)?.delegate.configure_again(
+      s,
+      this.xdg_toplevel
+    );
+  };
   zxdg_toplevel_decoration_v1_destroy: d["zxdg_toplevel_decoration_v1_destroy"] =
     auto_release;
   zxdg_toplevel_decoration_v1_set_mode: d["zxdg_toplevel_decoration_v1_set_mode"] =
-    (s, _object_id, _mode) => {
-      const surface = s.get_surface_from_role(this.xdg_toplevel);
-      if (!surface) {
-        return;
-      }
-      if (!surface.xdg_surface_state) {
-        return;
-      }
-      const xdg_surface_state = s.get_object(
-        surface.xdg_surface_state
-      )?.delegate;
-      if (!xdg_surface_state) {
-        return;
-      }
-      const xdg_surface_id = xdg_surface_state.xdg_surface_id;
-      xdg_surface_state.latest_configure_serial += 1;
-
-      xdg_surface.configure(
-        s,
-        xdg_surface_id,
-        xdg_surface_state.latest_configure_serial
-      );
+    (s, object_id, _mode) => {
+      this.configure(s, object_id);
     };
   zxdg_toplevel_decoration_v1_unset_mode: d["zxdg_toplevel_decoration_v1_unset_mode"] =
-    (s, _object_id) => {
-      const surface = s.get_surface_from_role(this.xdg_toplevel);
-      if (!surface) {
-        return;
-      }
-      if (!surface.xdg_surface_state) {
-        return;
-      }
-      const xdg_surface_state = s.get_object(
-        surface.xdg_surface_state
-      )?.delegate;
-      if (!xdg_surface_state) {
-        return;
-      }
-      const xdg_surface_id = xdg_surface_state.xdg_surface_id;
-      xdg_surface_state.latest_configure_serial += 1;
-
-      xdg_surface.configure(
-        s,
-        xdg_surface_id,
-        xdg_surface_state.latest_configure_serial
-      );
+    (s, object_id) => {
+      this.configure(s, object_id);
     };
   zxdg_toplevel_decoration_v1_on_bind: d["zxdg_toplevel_decoration_v1_on_bind"] =
     (_s, _name, _interface_, _new_id, _version_number) => {};
@@ -1,11 +1,19 @@
 import Bun from "bun";
 import { parseArgs } from "util";
+import { availableParallelism } from "node:os";
 //@ts-ignore
 import help_file from "../resources/help.md" with { type: "file" };
 import licenses_file from "../resources/LICENSES.txt" with { type: "file" };
 import { render_markdown_to_terminal } from "./render_markdown_to_terminal.ts";
 import { get_version_of_app } from "./get_version_of_app.ts";
 import npm_licenses from "../resources/npm_licenses.txt" with { type: "file" };
+export const render_modes = ["chafa", "sextant", "octant", "braille"] as const;
+export type Render_Mode = (typeof render_modes)[number];
+/**
+ * More drawing threads than this per core only adds switching
+ */
+export const max_threads_per_core = 4;
+
 export type Command_Line_args =
   ReturnType<typeof parse_args> extends Promise<infer T> ? T : never;
 
@@ -35,6 +43,45 @@ export const parse_args = async () => {
       "virtual-monitor-size": {
         type: "string",
       },
+      "auto-tune": {
+        type: "boolean",
+        default: false,
+      },
+      "record-output": {
+        type: "string",
+      },
+      threads: {
+        type: "string",
+      },
+      "profile-output": {
+        type: "string",
+      },
+      "kitty-placeholders": {
+        type: "boolean",
+        default: false,
+      },
+      "kitty-windows": {
+        type: "boolean",
+        default: false,
+      },
+      "render-mode": {
+        type: "string",
+        default: "chafa",
+      },
+      "motion-scale": {
+        type: "string",
+        default: "1",
+      },
+      "record-input": {
+        type: "string",
+      },
+      "replay-input": {
+        type: "string",
+      },
+      "replay-speed": {
+        type: "string",
+        default: "1",
+      },
 
       version: {
         type: "boolean",
@@ -67,5 +114,24 @@ export const parse_args = async () => {
     process.exit(0);
   }
 
+  if (!render_modes.includes(args.values["render-mode"] as Render_Mode)) {
+    console.error(
+      `--render-mode must be one of ${render_modes.join(", ")}, not ${args.values["render-mode"]}`
+    );
+    process.exit(1);
+  }
+
+  const threads = args.values.threads;
+  const max_threads = availableParallelism() * max_threads_per_core;
+  if (
+    threads !== undefined &&
+    (!/^\d+$/.test(threads) || Number(threads) > max_threads)
+  ) {
+    console.error(
+      `--threads must be a whole number from 0 to ${max_threads}, not ${threads}`
+    );
+    process.exit(1);
+  }
+
   return args;
 };
@@ -0,0 +1,323 @@
+/**
+ * The client side of State_Sync.ts. Draws the tiles the server
+ * sends on this terminal, acknowledges them, and sends the keys
+ * and mouse typed here. Ctrl+^ then . quits.
+ *
+ * Usage: STATE_SYNC_KEY=<key> bun src/state_sync_client.ts <host>[:<port>] [--drop-rate 0]
+ */
+import Bun from "bun";
+import { parseArgs } from "util";
+import { Ansi_Escape_Codes } from "./Ansi_Escape_Codes.ts";
+import { on_exit } from "./on_exit.ts";
+import {
+  Byte_Reader,
+  Byte_Writer,
+  State_Sync_Direction,
+  State_Sync_Message,
+  State_Sync_Socket,
+  datagram_budget_bytes,
+  default_state_sync_port,
+  timestamp_ms,
+} from "./State_Sync.ts";
+
+/**
+ * Ctrl+^, like mosh
+ */
+const escape_key = 0x1e;
+
+/**
+ * Input bytes in one datagram, more waits for the next
+ */
+const max_input_bytes = 1000;
+
+const full_ack_interval_seconds = 0.5;
+
+/**
+ * Tiles applied this recently go in every ack,
+ * in case the ones before were lost
+ */
+const recent_ack_seconds = 0.5;
+
+const tick_ms = 10;
+
+const { values, positionals } = parseArgs({
+  args: Bun.argv.slice(2),
+  options: {
+    key: { type: "string" },
+    "drop-rate": { type: "string", default: "0" },
+  },
+  allowPositionals: true,
+});
+
+const key = values.key ?? process.env["STATE_SYNC_KEY"];
+const [host, port = String(default_state_sync_port)] = (
+  positionals[0] ?? ""
+).split(":");
+if (!key || !host) {
+  console.error(
+    "Usage: STATE_SYNC_KEY=<key> bun src/state_sync_client.ts <host>[:<port>] [--drop-rate 0]"
+  );
+  process.exit(1);
+}
+
+const now = () => performance.now() / 1000;
+
+let tile_versions = new Uint32Array(0);
+/**
+ * Tile index to when it was last applied
+ */
+const recently_applied = new Map<number, number>();
+let last_full_ack_at = 0;
+let ack_due = false;
+
+/**
+ * Input from input_acked on, until the server has it
+ */
+let pending_input = new Uint8Array(0);
+let input_acked = 0;
+let input_sent_at = 0;
+let escape_pressed = false;
+
+/**
+ * The server's timestamp from its last datagram, echoed
+ * once in the next ack so it can time round trips
+ */
+let echo_sent_at = 0;
+let smoothed_rtt: number | null = null;
+let last_heard_at = now();
+let showing_lost_contact = false;
+
+/**
+ * Index and version
+ */
+const acked_tile_bytes = 6;
+
+/**
+ * Split over as many datagrams as it takes to stay under
+ * datagram_budget_bytes, the server takes every acked tile on
+ * its own. Only the first carries the input and the echo.
+ */
+const send_ack = (full: boolean) => {
+  const t = now();
+  const acked = full
+    ? Array.from(tile_versions, (_, index) => index)
+    : [...recently_applied.keys()];
+  let next = 0;
+  do {
+    const writer = new Byte_Writer();
+    writer.u8(State_Sync_Message.ack);
+    writer.u32(timestamp_ms());
+    writer.u32(echo_sent_at);
+    echo_sent_at = 0;
+    writer.u16(process.stdout.columns ?? 80);
+    writer.u16(process.stdout.rows ?? 24);
+    writer.u32(input_acked);
+    writer.data(
+      next === 0 ? pending_input.subarray(0, max_input_bytes) : new Uint8Array(0)
+    );
+    writer.u8(full ? 1 : 0);
+    const room = Math.max(
+      1,
+      Math.floor((datagram_budget_bytes - writer.length - 2) / acked_tile_bytes)
+    );
+    const chunk = acked.slice(next, next + room);
+    next += chunk.length;
+    writer.u16(chunk.length);
+    for (const index of chunk) {
+      writer.u16(index);
+      writer.u32(tile_versions[index]!);
+    }
+    socket.send(writer.finish(), host, Number(port));
+  } while (next < acked.length);
+  if (pending_input.length > 0) {
+    input_sent_at = t;
+  }
+  if (full) {
+    last_full_ack_at = t;
+  }
+  ack_due = false;
+};
+
+const on_screen = (reader: Byte_Reader) => {
+  echo_sent_at = reader.u32();
+  const echoed = reader.u32();
+  const input_received = reader.u32();
+  const columns = reader.u16();
+  const rows = reader.u16();
+  const tile_columns = reader.u16();
+  const count = reader.u16();
+  const t = now();
+
+  if (echoed !== 0) {
+    const rtt = ((timestamp_ms() - echoed) >>> 0) / 1000;
+    smoothed_rtt =
+      smoothed_rtt === null ? rtt : 0.875 * smoothed_rtt + 0.125 * rtt;
+  }
+  if (input_received > input_acked) {
+    pending_input = pending_input.slice(input_received - input_acked);
+    input_acked = input_received;
+  }
+
+  const tiles = rows * Math.ceil(columns / tile_columns);
+  if (tile_versions.length !== tiles) {
+    tile_versions = new Uint32Array(tiles);
+    recently_applied.clear();
+  }
+
+  let out = "";
+  for (let i = 0; i < count; i++) {
+    const index = reader.u16();
+    const from = reader.u32();
+    const to = reader.u32();
+    const text = reader.data();
+    /**
+     * From 0 is the whole tile, anything else only
+     * works on top of the version it was diffed from
+     */
+    if (index >= tiles || (from !== 0 && tile_versions[index] !== from)) {
+      continue;
+    }
+    /**
+     * Versions only go up, an older datagram that arrives
+     * late must not roll the tile back
+     */
+    if (to <= tile_versions[index]!) {
+      continue;
+    }
+    out += new TextDecoder().decode(text);
+    tile_versions[index] = to;
+    recently_applied.set(index, t);
+  }
+  if (out) {
+    process.stdout.write(
+      "\x1b[?2026h" + out + Ansi_Escape_Codes.reset + "\x1b[?2026l"
+    );
+  }
+  ack_due = true;
+};
+
+const show_contact = () => {
+  const silent_seconds = now() - last_heard_at;
+  if (silent_seconds > 2) {
+    showing_lost_contact = true;
+    process.stdout.write(
+      `\x1b]2;state-sync: last contact ${silent_seconds.toFixed(0)}s ago\x07`
+    );
+  } else if (showing_lost_contact) {
+    showing_lost_contact = false;
+    process.stdout.write("\x1b]2;state-sync\x07");
+  }
+};
+
+const tick = () => {
+  const t = now();
+  for (const [index, applied_at] of recently_applied) {
+    if (t - applied_at > recent_ack_seconds) {
+      recently_applied.delete(index);
+    }
+  }
+  const retransmit_seconds = Math.min(
+    1,
+    Math.max(0.05, 2 * (smoothed_rtt ?? 0.1))
+  );
+  if (t - last_full_ack_at > full_ack_interval_seconds) {
+    send_ack(true);
+  } else if (
+    ack_due ||
+    (pending_input.length > 0 && t - input_sent_at > retransmit_seconds)
+  ) {
+    send_ack(false);
+  }
+  show_contact();
+};
+
+const restore_terminal = () => {
+  process.stdout.write(
+    Ansi_Escape_Codes.reset +
+      Ansi_Escape_Codes.disable_mouse_tracking +
+      Ansi_Escape_Codes.show_cursor +
+      Ansi_Escape_Codes.disable_alternative_screen_buffer
+  );
+  if (process.stdin.isTTY) {
+    process.stdin.setRawMode(false);
+  }
+};
+
+const quit = (exit_code: number) => {
+  restore_terminal();
+  socket.close();
+  process.exit(exit_code);
+};
+
+const socket = new State_Sync_Socket(
+  key,
+  State_Sync_Direction.to_server,
+  Number(values["drop-rate"]),
+  (payload) => {
+    last_heard_at = now();
+    const reader = new Byte_Reader(payload);
+    switch (reader.u8()) {
+      case State_Sync_Message.screen:
+        on_screen(reader);
+        return;
+      case State_Sync_Message.goodbye:
+        quit(0);
+        return;
+    }
+  }
+);
+await socket.bind();
+
+if (process.stdin.isTTY) {
+  process.stdin.setRawMode(true);
+}
+process.stdout.write(
+  Ansi_Escape_Codes.enable_alternative_screen_buffer +
+    "\x1b[2J" +
+    Ansi_Escape_Codes.hide_cursor +
+    Ansi_Escape_Codes.enable_mouse_tracking
+);
+on_exit(restore_terminal);
+
+/**
+ * Everything is drawn again, the server can't
+ * resize the command but the screen was cleared
+ */
+process.stdout.on("resize", () => {
+  process.stdout.write("\x1b[2J");
+  tile_versions.fill(0);
+  recently_applied.clear();
+  send_ack(true);
+});
+
+setInterval(tick, tick_ms);
+send_ack(true);
+
+const append_input = (bytes: Uint8Array) => {
+  const input = new Uint8Array(pending_input.length + bytes.length);
+  input.set(pending_input);
+  input.set(bytes, pending_input.length);
+  pending_input = input;
+};
+
+for await (const chunk of Bun.stdin.stream()) {
+  const forwarded: number[] = [];
+  for (const byte of chunk) {
+    if (escape_pressed) {
+      escape_pressed = false;
+      if (byte === ".".charCodeAt(0)) {
+        quit(0);
+      }
+      forwarded.push(escape_key);
+    }
+    if (byte === escape_key) {
+      escape_pressed = true;
+      continue;
+    }
+    forwarded.push(byte);
+  }
+  if (forwarded.length > 0) {
+    append_input(Uint8Array.from(forwarded));
+    send_ack(false);
+  }
+}
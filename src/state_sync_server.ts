@@ -0,0 +1,429 @@
+/**
+ * The server side of State_Sync.ts. Waits for a client, runs the
+ * command at the size of the client's terminal with its output
+ * going into a VT_Screen, and keeps the client's copy of that
+ * screen up to date over UDP. The client's keys go to the
+ * command's stdin.
+ *
+ * Usage: bun src/state_sync_server.ts [--port 60001] [--drop-rate 0] -- <command...>
+ *   like: bun src/state_sync_server.ts -- ./term.everything firefox
+ */
+import Bun, { type FileSink } from "bun";
+import { parseArgs } from "util";
+import { VT_Cell, VT_Screen, sgr_of_style } from "./VT_Screen.ts";
+import {
+  Byte_Reader,
+  Byte_Writer,
+  State_Sync_Direction,
+  State_Sync_Message,
+  State_Sync_Socket,
+  datagram_budget_bytes,
+  default_state_sync_port,
+  make_state_sync_key,
+  tile_columns,
+  timestamp_ms,
+} from "./State_Sync.ts";
+
+const end_of_frame = new TextEncoder().encode("\x1b[?2026l");
+
+/**
+ * Versions of a tile the client might still have, to diff from
+ */
+const tile_history_length = 8;
+
+/**
+ * Output that doesn't mark its frames (DEC mode 2026)
+ * is taken as a frame once it has been quiet this long
+ */
+const unmarked_frame_seconds = 0.05;
+
+const tick_ms = 8;
+
+interface Tile_Version {
+  version: number;
+  cells: VT_Cell[];
+}
+
+class Tile {
+  /**
+   * Oldest first
+   */
+  history: Tile_Version[] = [];
+  client_version = 0;
+  sent_version = 0;
+  sent_at = 0;
+
+  latest = () => this.history[this.history.length - 1]!;
+}
+
+const { values, positionals } = parseArgs({
+  args: Bun.argv.slice(2),
+  options: {
+    port: { type: "string", default: String(default_state_sync_port) },
+    "drop-rate": { type: "string", default: "0" },
+  },
+  allowPositionals: true,
+});
+
+if (positionals.length === 0) {
+  console.error(
+    "Usage: bun src/state_sync_server.ts [--port 60001] [--drop-rate 0] -- <command...>"
+  );
+  process.exit(1);
+}
+
+const now = () => performance.now() / 1000;
+
+const key = process.env["STATE_SYNC_KEY"] ?? make_state_sync_key();
+
+let screen: VT_Screen | null = null;
+let tiles: Tile[] = [];
+let tiles_per_row = 0;
+let frame_version = 1;
+
+let child: ReturnType<typeof Bun.spawn> | null = null;
+let child_stdin: FileSink | null = null;
+let input_received = 0;
+
+/**
+ * Where the client's last datagram came from, it can roam
+ */
+let client: { address: string; port: number } | null = null;
+
+/**
+ * Same as TCP (RFC 6298), seconds
+ */
+let smoothed_rtt: number | null = null;
+let rtt_variance = 0;
+let last_sent_at = 0;
+/**
+ * The client's timestamp from its last ack, echoed once
+ * so it can time round trips too
+ */
+let echo_sent_at = 0;
+
+/**
+ * Snapshots the tiles that changed since the last one
+ */
+const take_snapshot = () => {
+  if (!screen) {
+    return;
+  }
+  let changed = false;
+  for (let row = 0; row < screen.rows; row++) {
+    const touched = screen.touched[row]!;
+    for (let tile_column = 0; tile_column < tiles_per_row; tile_column++) {
+      const first = tile_column * tile_columns;
+      const end = Math.min(first + tile_columns, screen.columns);
+      if (!touched.slice(first, end).includes(true)) {
+        continue;
+      }
+      const tile = tiles[row * tiles_per_row + tile_column]!;
+      const cells = screen.cells[row]!.slice(first, end);
+      const latest = tile.latest();
+      if (
+        cells.every(
+          (cell, i) =>
+            cell.char === latest.cells[i]!.char &&
+            cell.style === latest.cells[i]!.style
+        )
+      ) {
+        continue;
+      }
+      if (!changed) {
+        changed = true;
+        frame_version++;
+      }
+      tile.history.push({ version: frame_version, cells });
+      if (tile.history.length > tile_history_length) {
+        tile.history.shift();
+      }
+    }
+  }
+  screen.clear_touched();
+};
+
+/**
+ * The escape codes that take the client from the version it
+ * has to the latest, each tile starts from a reset so it can
+ * be applied on its own
+ */
+const encode_tile = (index: number, tile: Tile) => {
+  const latest = tile.latest();
+  const base = tile.history.find(
+    (version) => version.version === tile.client_version
+  );
+  const row = Math.floor(index / tiles_per_row);
+  const first_column = (index % tiles_per_row) * tile_columns;
+  let text = "";
+  let in_run = false;
+  let style: string | null = null;
+  latest.cells.forEach((cell, i) => {
+    const old = base?.cells[i];
+    if (old && old.char === cell.char && old.style === cell.style) {
+      in_run = false;
+      return;
+    }
+    if (!in_run) {
+      text += `\x1b[${row + 1};${first_column + i + 1}H`;
+      in_run = true;
+    }
+    if (cell.style !== style) {
+      text += `\x1b[${sgr_of_style(cell.style)}m`;
+      style = cell.style;
+    }
+    text += cell.char;
+  });
+  return {
+    from: base ? base.version : 0,
+    to: latest.version,
+    text: new TextEncoder().encode(text),
+  };
+};
+
+const retransmit_seconds = () =>
+  smoothed_rtt === null
+    ? 0.25
+    : Math.min(1, Math.max(0.05, smoothed_rtt + 4 * rtt_variance));
+
+/**
+ * Like mosh, about twice a round trip, but not over 50 a second
+ */
+const send_interval_seconds = () =>
+  smoothed_rtt === null
+    ? 0.02
+    : Math.min(0.25, Math.max(0.02, smoothed_rtt / 2));
+
+const begin_datagram = () => {
+  const writer = new Byte_Writer();
+  writer.u8(State_Sync_Message.screen);
+  writer.u32(timestamp_ms());
+  writer.u32(echo_sent_at);
+  echo_sent_at = 0;
+  writer.u32(input_received);
+  writer.u16(screen!.columns);
+  writer.u16(screen!.rows);
+  writer.u16(tile_columns);
+  return writer;
+};
+
+const send_tiles = () => {
+  if (!screen || !client) {
+    return;
+  }
+  const t = now();
+  if (t - last_sent_at < send_interval_seconds()) {
+    return;
+  }
+  const due: number[] = [];
+  tiles.forEach((tile, index) => {
+    const latest = tile.latest().version;
+    if (tile.client_version === latest) {
+      return;
+    }
+    if (
+      tile.sent_version !== latest ||
+      t - tile.sent_at > retransmit_seconds()
+    ) {
+      due.push(index);
+    }
+  });
+  /**
+   * Keep the connection (and the round trip time) alive
+   * while nothing changes
+   */
+  if (due.length === 0 && t - last_sent_at < 0.5) {
+    return;
+  }
+  last_sent_at = t;
+
+  let count = 0;
+  let tiles_in_datagram = new Byte_Writer();
+  const flush = () => {
+    const writer = begin_datagram();
+    writer.u16(count);
+    const header = writer.finish();
+    const body = tiles_in_datagram.finish();
+    const payload = new Uint8Array(header.length + body.length);
+    payload.set(header);
+    payload.set(body, header.length);
+    socket.send(payload, client!.address, client!.port);
+    tiles_in_datagram = new Byte_Writer();
+    count = 0;
+  };
+  for (const index of due) {
+    const tile = tiles[index]!;
+    const { from, to, text } = encode_tile(index, tile);
+    if (
+      count > 0 &&
+      tiles_in_datagram.length + text.length > datagram_budget_bytes
+    ) {
+      flush();
+    }
+    tiles_in_datagram.u16(index);
+    tiles_in_datagram.u32(from);
+    tiles_in_datagram.u32(to);
+    tiles_in_datagram.data(text);
+    count++;
+    tile.sent_version = to;
+    tile.sent_at = t;
+  }
+  flush();
+};
+
+const start_command = (columns: number, rows: number) => {
+  screen = new VT_Screen(columns, rows);
+  tiles_per_row = Math.ceil(columns / tile_columns);
+  tiles = Array.from({ length: rows * tiles_per_row }, (_, index) => {
+    const tile = new Tile();
+    const first = (index % tiles_per_row) * tile_columns;
+    tile.history.push({
+      version: frame_version,
+      cells: screen!.cells[Math.floor(index / tiles_per_row)]!.slice(
+        first,
+        first + tile_columns
+      ),
+    });
+    return tile;
+  });
+  screen.clear_touched();
+
+  child = Bun.spawn(positionals, {
+    stdin: "pipe",
+    stdout: "pipe",
+    stderr: "inherit",
+    env: { ...process.env, COLUMNS: String(columns), LINES: String(rows) },
+  });
+  child_stdin = child.stdin as FileSink;
+  read_output(child.stdout as ReadableStream<Uint8Array>);
+  child.exited.then(say_goodbye);
+};
+
+/**
+ * Whole frames go into snapshots, so the client
+ * never sees half of one
+ */
+const read_output = async (stdout: ReadableStream<Uint8Array>) => {
+  let matched = 0;
+  let unsnapshotted = false;
+  let last_output_at = now();
+  const quiet_check = setInterval(() => {
+    if (unsnapshotted && now() - last_output_at > unmarked_frame_seconds) {
+      take_snapshot();
+      unsnapshotted = false;
+    }
+  }, tick_ms);
+  for await (const chunk of stdout) {
+    last_output_at = now();
+    let start = 0;
+    for (let i = 0; i < chunk.length; i++) {
+      const byte = chunk[i]!;
+      if (byte === end_of_frame[matched]) {
+        matched++;
+        if (matched === end_of_frame.length) {
+          matched = 0;
+          screen!.write(chunk.subarray(start, i + 1));
+          start = i + 1;
+          take_snapshot();
+        }
+      } else {
+        matched = byte === end_of_frame[0] ? 1 : 0;
+      }
+    }
+    screen!.write(chunk.subarray(start));
+    unsnapshotted = start < chunk.length;
+  }
+  clearInterval(quiet_check);
+};
+
+const on_ack = (reader: Byte_Reader) => {
+  const echoed = reader.u32();
+  echo_sent_at = reader.u32();
+  const columns = reader.u16();
+  const rows = reader.u16();
+  const input_offset = reader.u32();
+  const input = reader.data();
+  const full = reader.u8() === 1;
+  const count = reader.u16();
+
+  if (!screen) {
+    start_command(columns, rows);
+  }
+  if (echoed !== 0) {
+    const rtt = ((timestamp_ms() - echoed) >>> 0) / 1000;
+    if (smoothed_rtt === null) {
+      smoothed_rtt = rtt;
+      rtt_variance = rtt / 2;
+    } else {
+      rtt_variance = 0.75 * rtt_variance + 0.25 * Math.abs(smoothed_rtt - rtt);
+      smoothed_rtt = 0.875 * smoothed_rtt + 0.125 * rtt;
+    }
+  }
+
+  if (
+    input_offset <= input_received &&
+    input_received < input_offset + input.length
+  ) {
+    child_stdin?.write(input.subarray(input_received - input_offset));
+    child_stdin?.flush();
+    input_received = input_offset + input.length;
+  }
+
+  for (let i = 0; i < count; i++) {
+    const index = reader.u16();
+    const version = reader.u32();
+    const tile = tiles[index];
+    if (!tile) {
+      continue;
+    }
+    /**
+     * A full ack can go back, the client starts over after a resize
+     */
+    if (full || version > tile.client_version) {
+      tile.client_version = version;
+    }
+  }
+};
+
+const socket = new State_Sync_Socket(
+  key,
+  State_Sync_Direction.to_client,
+  Number(values["drop-rate"]),
+  (payload, address, port, newest) => {
+    const reader = new Byte_Reader(payload);
+    if (reader.u8() !== State_Sync_Message.ack) {
+      return;
+    }
+    /**
+     * Roam only to where the newest datagram came from,
+     * a late one could still be coming from the old address
+     */
+    if (newest || !client) {
+      client = { address, port };
+    }
+    on_ack(reader);
+  }
+);
+
+const say_goodbye = async (exit_code: number) => {
+  clearInterval(ticker);
+  if (client) {
+    for (let i = 0; i < 5; i++) {
+      socket.send(
+        Uint8Array.of(State_Sync_Message.goodbye),
+        client.address,
+        client.port
+      );
+      await Bun.sleep(50);
+    }
+  }
+  socket.close();
+  process.exit(exit_code);
+};
+
+const port = await socket.bind(Number(values.port));
+console.log(
+  `state-sync: listening on udp port ${port}, connect with\n` +
+    `STATE_SYNC_KEY=${key} bun src/state_sync_client.ts <this host>:${port}`
+);
+const ticker = setInterval(send_tiles, tick_ms);